@@ -0,0 +1,14 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+// Both images are layers of one texture array, so a single binding serves them
+uniform sampler2DArray textures;
+uniform int layer1;
+uniform int layer2;
+
+void main()
+{
+	FragColor = mix(texture(textures, vec3(TexCoord, layer1)), texture(textures, vec3(TexCoord, layer2)), 0.2);
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+// The material texture is a layer of a texture array (Model::Create with
+// arrays); meshes with layers of the same array draw without binds in between
+struct Material {
+	sampler2DArray texture_diffuse1;
+	int layer_diffuse1;
+};
+uniform Material material;
+
+void main()
+{
+	FragColor = texture(material.texture_diffuse1, vec3(TexCoord, material.layer_diffuse1));
+}
\ No newline at end of file
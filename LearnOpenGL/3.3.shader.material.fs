@@ -0,0 +1,14 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+struct Material {
+	sampler2D texture_diffuse1;
+};
+uniform Material material;
+
+void main()
+{
+	FragColor = texture(material.texture_diffuse1, TexCoord);
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#version 330 core
+// Vertex shader for QuantizedVertex data (see VertexQuantization.h)
+layout (location = 0) in vec4 aPos;      // unorm16, relative to the mesh bounds
+layout (location = 1) in vec2 aNormal;   // octahedral, snorm16
+layout (location = 2) in vec2 aTexCoord; // half float
+
+out vec3 Normal;
+out vec2 TexCoord;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 boundsMin;
+uniform vec3 boundsExtent;
+
+vec3 decodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+void main() {
+	vec3 position = boundsMin + aPos.xyz * boundsExtent;
+	gl_Position = projection * view * model * vec4(position, 1.0);
+	Normal = mat3(model) * decodeOctahedral(aNormal);
+	TexCoord = aTexCoord;
+}
\ No newline at end of file
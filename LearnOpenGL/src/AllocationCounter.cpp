@@ -0,0 +1,63 @@
+#include "AllocationCounter.h"
+
+#ifdef LEARNOPENGL_COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<bool> s_Counting = false;
+static std::atomic<uint64_t> s_Allocations = 0;
+
+static void* countedAllocation(size_t size)
+{
+	if (s_Counting.load(std::memory_order_relaxed))
+		s_Allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+// Every form that pairs with the replaced operator new, so nothing reaches the
+// default delete with a malloc'd pointer
+void* operator new(size_t size) { return countedAllocation(size); }
+void* operator new[](size_t size) { return countedAllocation(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+bool CountingAllocations()
+{
+	return true;
+}
+
+void StartCountingAllocations()
+{
+	s_Allocations = 0;
+	s_Counting = true;
+}
+
+uint64_t StopCountingAllocations()
+{
+	s_Counting = false;
+	return s_Allocations;
+}
+
+#else
+
+bool CountingAllocations()
+{
+	return false;
+}
+
+void StartCountingAllocations()
+{
+}
+
+uint64_t StopCountingAllocations()
+{
+	return 0;
+}
+
+#endif
\ No newline at end of file
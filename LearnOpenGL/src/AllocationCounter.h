@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+
+// Heap allocations made through the global operator new, for the allocations
+// runner mode. operator new is only replaced when LEARNOPENGL_COUNT_ALLOCATIONS
+// is defined, which the LearnOpenGLTests target does; the app keeps the
+// standard allocator and CountingAllocations() is false there.
+bool CountingAllocations();
+void StartCountingAllocations();
+// Allocations since StartCountingAllocations
+uint64_t StopCountingAllocations();
\ No newline at end of file
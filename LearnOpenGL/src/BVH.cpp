@@ -0,0 +1,387 @@
+#include "BVH.h"
+
+#include "Renderer.h"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <numeric>
+#include <thread>
+
+static constexpr unsigned int BIN_COUNT = 16;
+// Below this many objects a subtree isn't worth a thread of its own
+static constexpr uint32_t PARALLEL_THRESHOLD = 16384;
+// Past this depth splits go at the median, which bounds the depth of any tree
+static constexpr unsigned int SAH_DEPTH_LIMIT = BVH::MaxDepth - 40;
+
+void BVH::Clear()
+{
+	m_Nodes.clear();
+	m_Objects.clear();
+	m_Boxes.clear();
+}
+
+void BVH::Build(std::span<const AABB> boxes, unsigned int threadCount)
+{
+	Clear();
+	if (boxes.empty())
+		return;
+
+	uint32_t count = (uint32_t)boxes.size();
+	m_Boxes.assign(boxes.begin(), boxes.end());
+	// A binary tree with at least one object per leaf never needs more
+	m_Nodes.resize((size_t)count * 2 - 1);
+
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	BuildContext context;
+	context.Items.resize(count);
+	for (uint32_t i = 0; i < count; i++)
+		context.Items[i] = { boxes[i], boxes[i].GetCenter(), i };
+	context.NextNode = 1;
+	context.ThreadDepth = threadCount > 1 ? std::bit_width(threadCount - 1) : 0;
+
+	build(context, 0, 0, count, 0);
+	m_Nodes.resize(context.NextNode);
+	m_Nodes.shrink_to_fit();
+	m_Objects.resize(count);
+	for (uint32_t i = 0; i < count; i++)
+		m_Objects[i] = context.Items[i].Object;
+}
+
+void BVH::build(BuildContext& context, uint32_t nodeIndex, uint32_t first, uint32_t count, unsigned int depth)
+{
+	Node& node = m_Nodes[nodeIndex];
+	BuildItem* items = context.Items.data() + first;
+	AABB centroidBounds;
+	node.Bounds = AABB();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		node.Bounds.Expand(items[i].Box);
+		centroidBounds.Expand(items[i].Centroid);
+	}
+	node.First = first;
+	node.Count = count;
+	if (count == 1)
+		return;
+
+	// Cheapest split over the bins of every axis: objects in each half
+	// times the half's area, relative to the parent's
+	struct Bin
+	{
+		AABB Bounds;
+		uint32_t Count = 0;
+	};
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	unsigned int bestSplit = 0;
+	glm::vec3 extent = centroidBounds.Max - centroidBounds.Min;
+	if (depth < SAH_DEPTH_LIMIT)
+	{
+		// All three axes binned in one pass
+		Bin bins[3][BIN_COUNT];
+		glm::vec3 scale;
+		for (int axis = 0; axis < 3; axis++)
+			scale[axis] = extent[axis] > 0.0f ? BIN_COUNT / extent[axis] : 0.0f;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			glm::vec3 offset = (items[i].Centroid - centroidBounds.Min) * scale;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				Bin& bin = bins[axis][std::min(BIN_COUNT - 1, (unsigned int)offset[axis])];
+				bin.Count++;
+				bin.Bounds.Expand(items[i].Box);
+			}
+		}
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (extent[axis] <= 0.0f)
+				continue;
+			float rightArea[BIN_COUNT - 1];
+			uint32_t rightCount[BIN_COUNT - 1];
+			AABB right;
+			uint32_t objectsRight = 0;
+			for (unsigned int i = BIN_COUNT - 1; i > 0; i--)
+			{
+				right.Expand(bins[axis][i].Bounds);
+				objectsRight += bins[axis][i].Count;
+				rightArea[i - 1] = objectsRight ? right.GetHalfArea() : 0.0f;
+				rightCount[i - 1] = objectsRight;
+			}
+			AABB left;
+			uint32_t objectsLeft = 0;
+			for (unsigned int i = 0; i < BIN_COUNT - 1; i++)
+			{
+				left.Expand(bins[axis][i].Bounds);
+				objectsLeft += bins[axis][i].Count;
+				if (objectsLeft == 0 || rightCount[i] == 0)
+					continue;
+				float cost = objectsLeft * left.GetHalfArea() + rightCount[i] * rightArea[i];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = i;
+				}
+			}
+		}
+	}
+
+	// A split costs one more box test (the node) on top of its children
+	float area = node.Bounds.GetHalfArea();
+	bool splitPays = bestAxis >= 0 && area + bestCost < count * area;
+	if (!splitPays && count <= MaxLeafSize)
+		return;
+
+	uint32_t leftCount;
+	if (bestAxis >= 0)
+	{
+		float scale = BIN_COUNT / extent[bestAxis];
+		float minimum = centroidBounds.Min[bestAxis];
+		BuildItem* middle = std::partition(items, items + count, [&](const BuildItem& item)
+		{
+			float offset = (item.Centroid[bestAxis] - minimum) * scale;
+			return std::min(BIN_COUNT - 1, (unsigned int)offset) <= bestSplit;
+		});
+		leftCount = (uint32_t)(middle - items);
+	}
+	else
+	{
+		// Too deep for the SAH, or every centroid in one spot: halve along the widest axis
+		int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+		leftCount = count / 2;
+		std::nth_element(items, items + leftCount, items + count, [&](const BuildItem& a, const BuildItem& b)
+		{
+			return a.Centroid[axis] < b.Centroid[axis];
+		});
+	}
+
+	uint32_t children = context.NextNode.fetch_add(2);
+	node.First = children;
+	node.Count = 0;
+	if (depth < context.ThreadDepth && count >= PARALLEL_THRESHOLD)
+	{
+		std::thread leftThread(&BVH::build, this, std::ref(context), children, first, leftCount, depth + 1);
+		build(context, children + 1, first + leftCount, count - leftCount, depth + 1);
+		leftThread.join();
+	}
+	else
+	{
+		build(context, children, first, leftCount, depth + 1);
+		build(context, children + 1, first + leftCount, count - leftCount, depth + 1);
+	}
+}
+
+// Children are always allocated after their parent, so walking the nodes
+// backwards sees both children before the node that needs them
+void BVH::Refit(std::span<const AABB> boxes)
+{
+	ASSERT(boxes.size() == m_Boxes.size());
+	std::copy(boxes.begin(), boxes.end(), m_Boxes.begin());
+	for (size_t i = m_Nodes.size(); i-- > 0;)
+	{
+		Node& node = m_Nodes[i];
+		if (node.Count > 0)
+		{
+			node.Bounds = AABB();
+			for (uint32_t j = 0; j < node.Count; j++)
+				node.Bounds.Expand(m_Boxes[m_Objects[node.First + j]]);
+		}
+		else
+		{
+			node.Bounds = m_Nodes[node.First].Bounds;
+			node.Bounds.Expand(m_Nodes[node.First + 1].Bounds);
+		}
+	}
+}
+
+void BVH::addSubtree(uint32_t root, std::vector<uint32_t>& visible) const
+{
+	uint32_t stack[MaxDepth * 2];
+	unsigned int size = 0;
+	stack[size++] = root;
+	while (size > 0)
+	{
+		const Node& node = m_Nodes[stack[--size]];
+		if (node.Count > 0)
+		{
+			visible.insert(visible.end(), m_Objects.begin() + node.First, m_Objects.begin() + node.First + node.Count);
+			continue;
+		}
+		stack[size++] = node.First + 1;
+		stack[size++] = node.First;
+	}
+}
+
+void BVH::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& visible) const
+{
+	visible.clear();
+	if (m_Nodes.empty())
+		return;
+
+	glm::vec4 planes[Frustum::PlaneCount];
+	glm::vec3 absNormals[Frustum::PlaneCount];
+	for (int i = 0; i < Frustum::PlaneCount; i++)
+	{
+		planes[i] = frustum.GetPlane((Frustum::Plane)i);
+		absNormals[i] = glm::abs(glm::vec3(planes[i]));
+	}
+	constexpr unsigned int AllPlanes = (1u << Frustum::PlaneCount) - 1;
+
+	// Bit i of the result is set while the box still crosses plane i; ~0 means outside
+	auto classify = [&](const AABB& box, unsigned int mask)
+	{
+		glm::vec3 center = box.GetCenter(), extents = box.GetExtents();
+		for (int i = 0; i < Frustum::PlaneCount; i++)
+		{
+			if (!(mask & (1u << i)))
+				continue;
+			float distance = glm::dot(glm::vec3(planes[i]), center) + planes[i].w;
+			float radius = glm::dot(absNormals[i], extents);
+			if (distance + radius < 0.0f)
+				return ~0u;
+			if (distance - radius >= 0.0f)
+				mask &= ~(1u << i);
+		}
+		return mask;
+	};
+
+	struct Entry
+	{
+		uint32_t Node;
+		unsigned int Planes;
+	};
+	Entry stack[MaxDepth * 2];
+	unsigned int size = 0;
+	stack[size++] = { 0, AllPlanes };
+	while (size > 0)
+	{
+		Entry entry = stack[--size];
+		const Node& node = m_Nodes[entry.Node];
+		unsigned int mask = classify(node.Bounds, entry.Planes);
+		if (mask == ~0u)
+			continue;
+		if (mask == 0)
+		{
+			addSubtree(entry.Node, visible);
+			continue;
+		}
+		if (node.Count > 0)
+		{
+			for (uint32_t i = node.First; i < node.First + node.Count; i++)
+			{
+				if (classify(m_Boxes[m_Objects[i]], mask) != ~0u)
+					visible.push_back(m_Objects[i]);
+			}
+			continue;
+		}
+		stack[size++] = { node.First + 1, mask };
+		stack[size++] = { node.First, mask };
+	}
+}
+
+RayHit BVH::Raycast(const Ray& ray, float maxDistance) const
+{
+	RayHit hit;
+	hit.Distance = maxDistance;
+	float distance;
+	glm::vec3 inverse = 1.0f / ray.Direction;
+	if (m_Nodes.empty() || !m_Nodes[0].Bounds.Intersects(ray, inverse, maxDistance, distance))
+		return hit;
+
+	struct Entry
+	{
+		uint32_t Node;
+		float Distance;
+	};
+	Entry stack[MaxDepth * 2];
+	unsigned int size = 0;
+	stack[size++] = { 0, distance };
+	while (size > 0)
+	{
+		Entry entry = stack[--size];
+		if (entry.Distance > hit.Distance)
+			continue;
+		const Node& node = m_Nodes[entry.Node];
+		if (node.Count > 0)
+		{
+			for (uint32_t i = node.First; i < node.First + node.Count; i++)
+			{
+				if (m_Boxes[m_Objects[i]].Intersects(ray, inverse, hit.Distance, distance) && distance < hit.Distance)
+				{
+					hit.Object = m_Objects[i];
+					hit.Distance = distance;
+				}
+			}
+			continue;
+		}
+
+		// Visit the nearer child first so it can cut the other one short
+		float leftDistance, rightDistance;
+		bool left = m_Nodes[node.First].Bounds.Intersects(ray, inverse, hit.Distance, leftDistance);
+		bool right = m_Nodes[node.First + 1].Bounds.Intersects(ray, inverse, hit.Distance, rightDistance);
+		if (left && right && leftDistance > rightDistance)
+		{
+			stack[size++] = { node.First, leftDistance };
+			stack[size++] = { node.First + 1, rightDistance };
+			continue;
+		}
+		if (right)
+			stack[size++] = { node.First + 1, rightDistance };
+		if (left)
+			stack[size++] = { node.First, leftDistance };
+	}
+	return hit;
+}
+
+uint32_t BVH::FindNearest(const glm::vec3& point, float maxDistance) const
+{
+	uint32_t nearest = UINT32_MAX;
+	if (m_Nodes.empty())
+		return nearest;
+	float best = maxDistance == FLT_MAX ? FLT_MAX : maxDistance * maxDistance;
+
+	struct Entry
+	{
+		uint32_t Node;
+		float DistanceSquared;
+	};
+	Entry stack[MaxDepth * 2];
+	unsigned int size = 0;
+	stack[size++] = { 0, m_Nodes[0].Bounds.DistanceSquared(point) };
+	while (size > 0)
+	{
+		Entry entry = stack[--size];
+		if (entry.DistanceSquared > best)
+			continue;
+		const Node& node = m_Nodes[entry.Node];
+		if (node.Count > 0)
+		{
+			for (uint32_t i = node.First; i < node.First + node.Count; i++)
+			{
+				float distance = m_Boxes[m_Objects[i]].DistanceSquared(point);
+				if (distance <= best)
+				{
+					best = distance;
+					nearest = m_Objects[i];
+				}
+			}
+			continue;
+		}
+
+		float left = m_Nodes[node.First].Bounds.DistanceSquared(point);
+		float right = m_Nodes[node.First + 1].Bounds.DistanceSquared(point);
+		if (left <= right)
+		{
+			stack[size++] = { node.First + 1, right };
+			stack[size++] = { node.First, left };
+		}
+		else
+		{
+			stack[size++] = { node.First, left };
+			stack[size++] = { node.First + 1, right };
+		}
+	}
+	return nearest;
+}
\ No newline at end of file
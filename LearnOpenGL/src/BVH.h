@@ -0,0 +1,82 @@
+#pragma once
+#include "Bounds.h"
+#include "Frustum.h"
+
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+struct RayHit
+{
+	uint32_t Object = UINT32_MAX;
+	float Distance = FLT_MAX;
+
+	inline bool IsValid() const { return Object != UINT32_MAX; }
+};
+
+// Bounding volume hierarchy over object boxes, for culling, picking and
+// proximity queries. Objects are identified by their index in the span given
+// to Build().
+//
+// Built top-down with the surface area heuristic over binned centroids.
+// Moving objects are handled by Refit(), which keeps the tree shape and
+// only recomputes the boxes; rebuild once the tree has degraded noticeably
+// (objects moved far from where they started).
+//
+// Queries test object boxes, not geometry: Raycast returns the nearest box
+// hit, which callers can refine against triangles if they need to.
+class BVH
+{
+public:
+	// threadCount 0 uses every hardware thread; small scenes build on the calling thread
+	void Build(std::span<const AABB> boxes, unsigned int threadCount = 0);
+	// boxes must have the same count and order as for Build()
+	void Refit(std::span<const AABB> boxes);
+	void Clear();
+
+	// Replaces visible with every object at least partly inside. Nodes fully
+	// inside a plane stop testing it, and fully inside nodes add their whole subtree.
+	void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+	RayHit Raycast(const Ray& ray, float maxDistance = FLT_MAX) const;
+	// Object whose box is closest to point, or UINT32_MAX if none is within maxDistance
+	uint32_t FindNearest(const glm::vec3& point, float maxDistance = FLT_MAX) const;
+
+	inline bool IsEmpty() const { return m_Nodes.empty(); }
+	inline size_t GetNodeCount() const { return m_Nodes.size(); }
+	inline const AABB& GetBounds() const { return m_Nodes[0].Bounds; }
+
+	static constexpr unsigned int MaxLeafSize = 8;
+	static constexpr unsigned int MaxDepth = 96;
+private:
+	// 32 bytes. Leaves have Count > 0 and own m_Objects[First, First + Count);
+	// inner nodes have Count == 0 and children at First and First + 1.
+	struct Node
+	{
+		AABB Bounds;
+		uint32_t First;
+		uint32_t Count;
+	};
+
+	// Partitioned in place, so every pass over a node reads memory in order
+	struct BuildItem
+	{
+		AABB Box;
+		glm::vec3 Centroid;
+		uint32_t Object;
+	};
+
+	struct BuildContext
+	{
+		std::vector<BuildItem> Items;
+		std::atomic<uint32_t> NextNode;
+		unsigned int ThreadDepth;
+	};
+
+	std::vector<Node> m_Nodes;
+	std::vector<uint32_t> m_Objects;
+	std::vector<AABB> m_Boxes;
+
+	void build(BuildContext& context, uint32_t node, uint32_t first, uint32_t count, unsigned int depth);
+	void addSubtree(uint32_t node, std::vector<uint32_t>& visible) const;
+};
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include "VertexLayout.h"
+
+// Layout of a baked mesh file (.bmesh), written by the MeshConverter tool:
+//
+//   BakedMeshHeader
+//   BakedMeshSection[SectionCount]
+//   section data                    each section starts on a 16-byte boundary
+//
+// Vertices are stored exactly as VERTEX_LAYOUT describes them and indices
+// local to their submesh, in the type IndexBuffer would pick for them (16 bits
+// for most), so both can be handed to glBufferData straight from a memory
+// mapping. Strings (names, texture paths) are null terminated; texture paths
+// are relative to the .bmesh file.
+
+constexpr char BAKED_MESH_MAGIC[4] = { 'B', 'M', 'S', 'H' };
+constexpr uint32_t BAKED_MESH_VERSION = 2;
+constexpr uint32_t BAKED_MESH_ALIGNMENT = 16;
+constexpr uint32_t BAKED_MESH_NO_STRING = UINT32_MAX;
+
+enum BakedMeshSectionType : uint32_t
+{
+	BAKED_MESH_LAYOUT = 1,    // BakedVertexAttribute[Count]
+	BAKED_MESH_VERTICES = 2,  // Count vertices of header.VertexStride bytes
+	BAKED_MESH_INDICES = 3,   // Count bytes, each submesh's indices in its IndexType
+	BAKED_MESH_SUBMESHES = 4, // BakedSubmesh[Count]
+	BAKED_MESH_MATERIALS = 5, // BakedMaterial[Count]
+	BAKED_MESH_STRINGS = 6    // Count bytes
+};
+
+struct BakedMeshHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint32_t SectionCount;
+	uint32_t VertexStride;
+	float BoundsMin[3];
+	float BoundsMax[3];
+};
+
+struct BakedMeshSection
+{
+	uint32_t Type;
+	uint32_t Reserved;
+	uint64_t Count;
+	uint64_t Offset; // from the start of the file
+	uint64_t Size;
+};
+
+// Mirrors VertexBufferElement
+struct BakedVertexAttribute
+{
+	uint32_t GLType;
+	uint32_t Count;
+	uint32_t Normalized;
+	uint32_t Offset;
+};
+
+struct BakedSubmesh
+{
+	uint64_t FirstVertex;
+	uint64_t IndexOffset; // bytes into the indices, a multiple of the index size
+	uint32_t VertexCount;
+	uint32_t IndexCount;
+	uint32_t IndexType;   // GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	uint32_t Primitive;   // GL_TRIANGLES, or GL_TRIANGLE_STRIP cut by the type's largest value
+	uint32_t Material;    // UINT32_MAX for none
+	uint32_t Name;        // offset into the strings
+	float BoundsMin[3];
+	float BoundsMax[3];
+};
+
+struct BakedMaterial
+{
+	uint32_t Name;
+	uint32_t Textures[4]; // per TextureType, offsets into the strings
+};
+
+static_assert(sizeof(BakedMeshHeader) == 40, "BakedMeshHeader must match the file layout");
+static_assert(sizeof(BakedMeshSection) == 32, "BakedMeshSection must match the file layout");
+static_assert(sizeof(BakedVertexAttribute) == 16, "BakedVertexAttribute must match the file layout");
+static_assert(sizeof(BakedSubmesh) == 64, "BakedSubmesh must match the file layout");
+static_assert(sizeof(BakedMaterial) == 20, "BakedMaterial must match the file layout");
+static_assert(4 == (size_t)TextureType::Count, "BakedMaterial::Textures needs a slot per TextureType");
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "BakedMeshWriter.h"
+
+#include "BakedMeshFormat.h"
+#include "IndexBuffer.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <vector>
+
+// Null-terminated strings, each stored once
+class StringTable
+{
+public:
+	uint32_t Add(const std::string& text)
+	{
+		if (text.empty())
+			return BAKED_MESH_NO_STRING;
+		auto [it, inserted] = m_Offsets.try_emplace(text, (uint32_t)m_Data.size());
+		if (inserted)
+			m_Data.insert(m_Data.end(), text.c_str(), text.c_str() + text.size() + 1);
+		return it->second;
+	}
+
+	inline const std::vector<char>& GetData() const { return m_Data; }
+private:
+	std::vector<char> m_Data;
+	std::map<std::string, uint32_t> m_Offsets;
+};
+
+static size_t countTriangles(const MeshData& mesh)
+{
+	if (mesh.Primitive != GL_TRIANGLE_STRIP)
+		return mesh.Indices.size() / 3;
+	// A strip of n indices holds n - 2 triangles
+	size_t triangles = 0, run = 0;
+	for (unsigned int index : mesh.Indices)
+	{
+		if (index == IndexBuffer::RestartIndex)
+			run = 0;
+		else if (++run >= 3)
+			triangles++;
+	}
+	return triangles;
+}
+
+static uint64_t align(uint64_t offset)
+{
+	return (offset + BAKED_MESH_ALIGNMENT - 1) & ~(uint64_t)(BAKED_MESH_ALIGNMENT - 1);
+}
+
+bool WriteBakedMesh(const ModelData& model, const std::string& path, BakedMeshSummary* summary)
+{
+	std::filesystem::path outputDirectory = std::filesystem::absolute(path).parent_path();
+	StringTable strings;
+	std::vector<BakedMaterial> materials(model.Materials.size());
+	for (size_t i = 0; i < model.Materials.size(); i++)
+	{
+		materials[i].Name = strings.Add(model.Materials[i].Name);
+		for (size_t type = 0; type < (size_t)TextureType::Count; type++)
+		{
+			const std::string& texture = model.Materials[i].Textures[type];
+			std::string relative;
+			if (!texture.empty())
+				relative = std::filesystem::absolute(texture).lexically_relative(outputDirectory).generic_string();
+			materials[i].Textures[type] = strings.Add(relative.empty() ? texture : relative);
+		}
+	}
+
+	std::vector<BakedVertexAttribute> layout;
+	for (const VertexBufferElement& element : VERTEX_LAYOUT.Elements)
+		layout.push_back({ element.type, element.count, element.normalized, element.offset });
+
+	std::vector<BakedSubmesh> submeshes(model.Meshes.size());
+	uint64_t vertexCount = 0, indexBytes = 0, triangleCount = 0;
+	AABB bounds;
+	for (size_t i = 0; i < model.Meshes.size(); i++)
+	{
+		const MeshData& mesh = model.Meshes[i];
+		BakedSubmesh& submesh = submeshes[i];
+		submesh.IndexType = IndexBuffer::SelectType(IndexBuffer::MaxIndex(mesh.Indices));
+		submesh.Primitive = mesh.Primitive;
+		submesh.FirstVertex = vertexCount;
+		// Every index type stays aligned if each submesh starts on 4 bytes
+		submesh.IndexOffset = (indexBytes + 3) & ~(uint64_t)3;
+		submesh.VertexCount = (uint32_t)mesh.Vertices.size();
+		submesh.IndexCount = (uint32_t)mesh.Indices.size();
+		submesh.Material = mesh.Material;
+		submesh.Name = strings.Add(mesh.Name);
+		memcpy(submesh.BoundsMin, &mesh.Bounds.Min, sizeof(submesh.BoundsMin));
+		memcpy(submesh.BoundsMax, &mesh.Bounds.Max, sizeof(submesh.BoundsMax));
+		vertexCount += mesh.Vertices.size();
+		indexBytes = submesh.IndexOffset + (uint64_t)submesh.IndexCount * IndexBuffer::TypeSize(submesh.IndexType);
+		triangleCount += countTriangles(mesh);
+		bounds.Expand(mesh.Bounds);
+	}
+
+	std::vector<BakedMeshSection> sections = {
+		{ BAKED_MESH_LAYOUT, 0, layout.size(), 0, layout.size() * sizeof(BakedVertexAttribute) },
+		{ BAKED_MESH_VERTICES, 0, vertexCount, 0, vertexCount * sizeof(Vertex) },
+		{ BAKED_MESH_INDICES, 0, indexBytes, 0, indexBytes },
+		{ BAKED_MESH_SUBMESHES, 0, submeshes.size(), 0, submeshes.size() * sizeof(BakedSubmesh) },
+		{ BAKED_MESH_MATERIALS, 0, materials.size(), 0, materials.size() * sizeof(BakedMaterial) },
+		{ BAKED_MESH_STRINGS, 0, strings.GetData().size(), 0, strings.GetData().size() }
+	};
+	uint64_t offset = sizeof(BakedMeshHeader) + sections.size() * sizeof(BakedMeshSection);
+	for (BakedMeshSection& section : sections)
+	{
+		section.Offset = align(offset);
+		offset = section.Offset + section.Size;
+	}
+
+	BakedMeshHeader header = {};
+	memcpy(header.Magic, BAKED_MESH_MAGIC, 4);
+	header.Version = BAKED_MESH_VERSION;
+	header.SectionCount = (uint32_t)sections.size();
+	header.VertexStride = VERTEX_LAYOUT.Stride;
+	memcpy(header.BoundsMin, &bounds.Min, sizeof(header.BoundsMin));
+	memcpy(header.BoundsMax, &bounds.Max, sizeof(header.BoundsMax));
+
+	// Written piece by piece: a big model doesn't need a second copy in memory
+	std::ofstream out(path, std::ios::binary);
+	uint64_t position = 0;
+	auto writeAt = [&](uint64_t offset, const void* data, uint64_t size)
+	{
+		static const char padding[BAKED_MESH_ALIGNMENT] = {};
+		out.write(padding, (std::streamsize)(offset - position));
+		out.write((const char*)data, (std::streamsize)size);
+		position = offset + size;
+	};
+	writeAt(0, &header, sizeof(header));
+	writeAt(position, sections.data(), sections.size() * sizeof(BakedMeshSection));
+	writeAt(sections[0].Offset, layout.data(), sections[0].Size);
+	writeAt(sections[1].Offset, nullptr, 0);
+	for (const MeshData& mesh : model.Meshes)
+		writeAt(position, mesh.Vertices.data(), mesh.Vertices.size() * sizeof(Vertex));
+	std::vector<uint8_t> converted;
+	for (size_t i = 0; i < model.Meshes.size(); i++)
+	{
+		const BakedSubmesh& submesh = submeshes[i];
+		converted.resize((size_t)submesh.IndexCount * IndexBuffer::TypeSize(submesh.IndexType));
+		IndexBuffer::Convert(model.Meshes[i].Indices, submesh.IndexType, converted.data());
+		writeAt(sections[2].Offset + submesh.IndexOffset, converted.data(), converted.size());
+	}
+	writeAt(sections[3].Offset, submeshes.data(), sections[3].Size);
+	writeAt(sections[4].Offset, materials.data(), sections[4].Size);
+	writeAt(sections[5].Offset, strings.GetData().data(), sections[5].Size);
+	if (!out)
+	{
+		std::cout << "Can't write " << path << std::endl;
+		return false;
+	}
+
+	if (summary)
+	{
+		summary->Submeshes = submeshes.size();
+		summary->Vertices = vertexCount;
+		summary->Triangles = triangleCount;
+		summary->IndexBytes = indexBytes;
+		summary->FileBytes = position;
+	}
+	return true;
+}
\ No newline at end of file
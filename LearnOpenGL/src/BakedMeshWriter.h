@@ -0,0 +1,21 @@
+#pragma once
+#include "ModelImporter.h"
+
+#include <cstdint>
+#include <string>
+
+struct BakedMeshSummary
+{
+	size_t Submeshes = 0;
+	uint64_t Vertices = 0;
+	uint64_t Triangles = 0;
+	uint64_t IndexBytes = 0;
+	uint64_t FileBytes = 0;
+};
+
+// Writes an imported model as a baked mesh (.bmesh, see BakedMeshFormat.h).
+// Indices are stored in the smallest type that holds them and texture paths
+// relative to the output, so the two can move together. Used by MeshConverter
+// and the mesh-load runner mode. Prints what went wrong and returns false if
+// the file can't be written.
+bool WriteBakedMesh(const ModelData& model, const std::string& path, BakedMeshSummary* summary = nullptr);
\ No newline at end of file
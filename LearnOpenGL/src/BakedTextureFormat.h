@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+
+// Layout of a baked texture file (.btex), written by the TextureBaker tool:
+//
+//   BakedTextureHeader
+//   BakedTextureLevel[LevelCount]   largest level first
+//   level data                      each level starts on a 16-byte boundary
+//
+// Levels are stored exactly as glCompressedTexImage2D expects them, so the
+// file can be uploaded straight from a memory mapping.
+
+// S3TC formats aren't part of core GL, so the loader doesn't get them from glad
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+constexpr char BAKED_TEXTURE_MAGIC[4] = { 'B', 'T', 'E', 'X' };
+constexpr uint32_t BAKED_TEXTURE_VERSION = 1;
+constexpr uint32_t BAKED_TEXTURE_ALIGNMENT = 16;
+
+enum BakedTextureFlags : uint32_t
+{
+	BAKED_TEXTURE_FLIPPED = 1 << 0, // rows stored bottom first, as stbi flip-on-load would give
+	BAKED_TEXTURE_ALPHA = 1 << 1
+};
+
+struct BakedTextureHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint32_t GLFormat; // compressed internal format
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t LevelCount;
+	uint32_t Flags;
+	uint32_t Reserved;
+};
+
+struct BakedTextureLevel
+{
+	uint64_t Offset; // from the start of the file
+	uint64_t Size;
+	uint32_t Width;
+	uint32_t Height;
+};
+
+static_assert(sizeof(BakedTextureHeader) == 32, "BakedTextureHeader must match the file layout");
+static_assert(sizeof(BakedTextureLevel) == 24, "BakedTextureLevel must match the file layout");
\ No newline at end of file
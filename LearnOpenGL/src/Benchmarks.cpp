@@ -0,0 +1,1992 @@
+#include "Benchmarks.h"
+
+// Ahead of glad, which takes APIENTRY from it when it's there
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#endif
+#ifdef __linux__
+#include <fcntl.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "AllocationCounter.h"
+#include "BakedMeshWriter.h"
+#include "BVH.h"
+#include "Camera.h"
+#include "Framebuffer.h"
+#include "Frustum.h"
+#include "GeometryPool.h"
+#include "GLStateCache.h"
+#include "IndexBuffer.h"
+#include "Mesh.h"
+#include "MipGenerator.h"
+#include "Model.h"
+#include "ModelImporter.h"
+#include "Renderer.h"
+#include "RenderQueue.h"
+#include "Shader.h"
+#include "StreamBuffer.h"
+#include "TextureArray.h"
+#include "TextureCache.h"
+#include "TextureLoader.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct FrameTime
+{
+	double Submit = 0.0; // CPU time issuing the commands
+	double Total = 0.0;  // until glFinish returned
+};
+
+// Median of a few frames, which shrugs off the odd preempted one. frame
+// issues the commands; the GL queue is drained before and after it.
+template<typename F>
+static FrameTime timeFrames(unsigned int frames, F&& frame)
+{
+	std::vector<double> submit, total;
+	GLCall(glFinish());
+	for (unsigned int i = 0; i < frames; i++)
+	{
+		auto start = Clock::now();
+		frame();
+		submit.push_back(millisecondsSince(start));
+		GLCall(glFinish());
+		total.push_back(millisecondsSince(start));
+	}
+	std::sort(submit.begin(), submit.end());
+	std::sort(total.begin(), total.end());
+	return { submit[frames / 2], total[frames / 2] };
+}
+
+// Unit cube as 36 vertices of position and (unused) texture coordinates, the
+// attributes the coordsys and instanced shaders read
+static std::vector<float> cubeVertices()
+{
+	static const unsigned int corners[36] = {
+		0, 1, 3, 0, 3, 2,  4, 5, 7, 4, 7, 6,  0, 2, 6, 0, 6, 4,
+		1, 3, 7, 1, 7, 5,  0, 1, 5, 0, 5, 4,  2, 3, 7, 2, 7, 6
+	};
+	std::vector<float> vertices;
+	for (unsigned int corner : corners)
+	{
+		vertices.insert(vertices.end(), { (float)(corner & 1) - 0.5f, (float)((corner >> 1) & 1) - 0.5f,
+			(float)((corner >> 2) & 1) - 0.5f, 0.0f, 0.0f });
+	}
+	return vertices;
+}
+
+// Counts the calls made through one of glad's function pointers while it exists
+template<auto& Function>
+class GLCallCounter
+{
+public:
+	GLCallCounter()
+	{
+		s_Real = Function;
+		s_Calls = 0;
+		Function = hook(Function);
+	}
+	~GLCallCounter() { Function = s_Real; }
+
+	GLCallCounter(const GLCallCounter&) = delete;
+	GLCallCounter& operator=(const GLCallCounter&) = delete;
+
+	inline uint64_t GetCalls() const { return s_Calls; }
+	inline void Reset() { s_Calls = 0; }
+private:
+	using Pointer = std::remove_reference_t<decltype(Function)>;
+	static inline Pointer s_Real = nullptr;
+	static inline uint64_t s_Calls = 0;
+
+	template<typename R, typename... Args>
+	static R APIENTRY counted(Args... args)
+	{
+		s_Calls++;
+		return s_Real(args...);
+	}
+	template<typename R, typename... Args>
+	static Pointer hook(R (APIENTRY*)(Args...)) { return &counted<R, Args...>; }
+};
+
+// Resident memory of the process, in bytes; 0 where it can't be read
+struct MemoryUsage
+{
+	size_t Resident = 0;
+	size_t Peak = 0;
+};
+
+static MemoryUsage memoryUsage()
+{
+	MemoryUsage usage;
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		usage.Resident = counters.WorkingSetSize;
+		usage.Peak = counters.PeakWorkingSetSize;
+	}
+#elif defined(__linux__)
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line))
+	{
+		if (line.starts_with("VmRSS:"))
+			usage.Resident = std::stoull(line.substr(6)) * 1024;
+		else if (line.starts_with("VmHWM:"))
+			usage.Peak = std::stoull(line.substr(6)) * 1024;
+	}
+#endif
+	return usage;
+}
+
+// Hands freed heap back to the system, so it stops counting as resident
+static void releaseFreedMemory()
+{
+#ifdef __GLIBC__
+	malloc_trim(0);
+#endif
+}
+
+// Starts a new peak at the current resident size. Only Linux can do this;
+// elsewhere the peak covers the whole run.
+static bool resetPeakMemory()
+{
+	releaseFreedMemory();
+#ifdef __linux__
+	std::ofstream clearRefs("/proc/self/clear_refs");
+	clearRefs << "5";
+	clearRefs.close();
+	return !clearRefs.fail();
+#else
+	return false;
+#endif
+}
+
+// Counts 100, 1000, ... and finally max itself
+template<typename F>
+static void sweep(unsigned int max, F&& step)
+{
+	for (unsigned int count = std::min(100u, max); ; count = std::min(count * 10, max))
+	{
+		step(count);
+		if (count == max)
+			break;
+	}
+}
+
+// ========== draws ==========
+
+static int benchmarkDraws(unsigned int maxObjects)
+{
+	const unsigned int size = 256;
+	const unsigned int frames = 5;
+	Framebuffer target(size, size);
+	GLCall(glViewport(0, 0, size, size));
+	GLStateCache::Get().SetEnabled(GL_DEPTH_TEST, true);
+
+	std::vector<float> cube = cubeVertices();
+	VertexBuffer cubeVB(cube.data(), (unsigned int)(cube.size() * sizeof(float)));
+	VertexBufferLayout layout;
+	layout.Push<float>(3);
+	layout.Push<float>(2);
+	VertexArray perObjectVA;
+	perObjectVA.AddBuffer(cubeVB, layout);
+	VertexBufferLayout instanceLayout;
+	instanceLayout.Push<glm::mat4>(1);
+
+	Shader perObject("3.3.shader.coordsys.vs", "3.3.shader.coordsys.fs");
+	Shader instanced("3.3.shader.instanced.vs", "3.3.shader.coordsys.fs");
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -3.0f));
+	for (Shader* shader : { &perObject, &instanced })
+	{
+		shader->use();
+		shader->setMat4("projection", projection);
+		shader->setMat4("view", view);
+	}
+	UniformHandle modelLoc = perObject.getUniformHandle("model");
+
+	// Tiny boxes scattered over the view, so the sweep measures submission rather than fill rate
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> spread(-1.0f, 1.0f);
+	std::vector<glm::mat4> models(maxObjects);
+	for (glm::mat4& model : models)
+	{
+		glm::vec3 position(spread(random), spread(random), spread(random));
+		model = glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(0.01f));
+	}
+
+	std::cout << "draws: " << size << "x" << size << " target, median of " << frames << " frames, ms submitted / finished"
+		<< std::endl << std::setw(10) << "objects" << std::setw(24) << "one draw per object" << std::setw(24) << "instanced"
+		<< std::setw(10) << "speedup" << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	sweep(maxObjects, [&](unsigned int count)
+	{
+		FrameTime perObjectTime = timeFrames(frames, [&]()
+		{
+			GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+			perObject.use();
+			perObjectVA.Bind();
+			for (unsigned int i = 0; i < count; i++)
+			{
+				perObject.set(modelLoc, models[i]);
+				GLCall(glDrawArrays(GL_TRIANGLES, 0, 36));
+			}
+		});
+		// Sized for this step, so refilling it each frame only orphans what is drawn
+		VertexArray instancedVA;
+		instancedVA.AddBuffer(cubeVB, layout);
+		VertexBuffer instanceVB(nullptr, (unsigned int)(count * sizeof(glm::mat4)), GL_DYNAMIC_DRAW);
+		instancedVA.AddBuffer(instanceVB, instanceLayout, 1);
+		FrameTime instancedTime = timeFrames(frames, [&]()
+		{
+			GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+			instanced.use();
+			instanceVB.SetData(models.data(), (unsigned int)(count * sizeof(glm::mat4)));
+			instancedVA.Bind();
+			GLCall(glDrawArraysInstanced(GL_TRIANGLES, 0, 36, count));
+		});
+		std::cout << std::setw(10) << count
+			<< std::setw(12) << perObjectTime.Submit << " / " << std::setw(9) << perObjectTime.Total
+			<< std::setw(12) << instancedTime.Submit << " / " << std::setw(9) << instancedTime.Total
+			<< std::setw(9) << perObjectTime.Total / instancedTime.Total << "x" << std::endl;
+	});
+	std::cout << std::defaultfloat;
+	return 0;
+}
+
+// ========== uniforms ==========
+
+static int benchmarkUniforms(unsigned int objects)
+{
+	const unsigned int frames = 5;
+	Shader shader("3.3.shader.coordsys.vs", "3.3.shader.coordsys.fs");
+	shader.use();
+	std::vector<glm::mat4> models(objects);
+	for (unsigned int i = 0; i < objects; i++)
+		models[i] = glm::translate(glm::mat4(1.0f), glm::vec3((float)i, 0.0f, 0.0f));
+
+	GLCallCounter<glad_glGetUniformLocation> locationCalls;
+	GLCallCounter<glad_glUniformMatrix4fv> uniformCalls;
+	UniformHandle modelLoc = shader.getUniformHandle("model");
+	// Returns how many locations were looked up
+	auto report = [&](const char* name, FrameTime time)
+	{
+		uint64_t lookups = locationCalls.GetCalls();
+		std::cout << std::setw(24) << name << std::setw(10) << time.Submit << std::setw(24)
+			<< lookups / frames << std::setw(14) << uniformCalls.GetCalls() / frames << std::endl;
+		locationCalls.Reset();
+		uniformCalls.Reset();
+		return lookups;
+	};
+
+	std::cout << "uniforms: model matrix for " << objects << " objects, median of " << frames << " frames"
+		<< std::endl << std::setw(24) << "" << std::setw(10) << "ms" << std::setw(24) << "glGetUniformLocation"
+		<< std::setw(14) << "glUniform*" << std::endl;
+	std::cout << std::fixed << std::setprecision(3);
+	// What every set* call did before locations were cached
+	report("lookup per call", timeFrames(frames, [&]()
+	{
+		for (const glm::mat4& model : models)
+		{
+			std::string name = "model";
+			GLCall(glUniformMatrix4fv(glGetUniformLocation(shader.ID, name.c_str()), 1, GL_FALSE, &model[0][0]));
+		}
+	}));
+	uint64_t lookups = report("cached, by name", timeFrames(frames, [&]()
+	{
+		for (const glm::mat4& model : models)
+			shader.setMat4("model", model);
+	}));
+	lookups += report("handle", timeFrames(frames, [&]()
+	{
+		for (const glm::mat4& model : models)
+			shader.set(modelLoc, model);
+	}));
+	std::cout << std::defaultfloat;
+	if (lookups > 0)
+	{
+		std::cout << "FAILED: cached uniforms still called glGetUniformLocation" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+// ========== handles ==========
+
+// Buffers, index buffers and meshes are moved around in vectors and
+// reassigned from temporaries; every GL name has to stay alive while
+// something owns it, and each one has to be deleted exactly once.
+static int benchmarkHandles(unsigned int count)
+{
+	GLCallCounter<glad_glGenBuffers> buffersCreated;
+	GLCallCounter<glad_glDeleteBuffers> buffersDeleted;
+	GLCallCounter<glad_glGenVertexArrays> arraysCreated;
+	GLCallCounter<glad_glDeleteVertexArrays> arraysDeleted;
+
+	std::vector<float> cube = cubeVertices();
+	std::vector<Vertex> vertices(36);
+	std::vector<unsigned int> indices(36);
+	for (unsigned int i = 0; i < 36; i++)
+	{
+		vertices[i] = { glm::vec3(cube[i * 5], cube[i * 5 + 1], cube[i * 5 + 2]), glm::vec3(0.0f), glm::vec2(0.0f) };
+		indices[i] = i;
+	}
+
+	bool ok = true;
+	std::vector<unsigned int> bufferNames, arrayNames;
+	{
+		// Growing the vectors moves every element a few times
+		std::vector<VertexBuffer> buffers;
+		std::vector<IndexBuffer> indexBuffers;
+		std::vector<Mesh> meshes;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			buffers.emplace_back(vertices);
+			indexBuffers.emplace_back(indices);
+			meshes.emplace_back(vertices, indices, std::vector<Texture>());
+		}
+		// Assigning a temporary used to delete the buffer it had just created
+		VertexBuffer assigned;
+		assigned = VertexBuffer(vertices);
+		VertexBuffer moved = std::move(buffers.back());
+		buffers.pop_back();
+
+		auto alive = [&](unsigned int name, GLboolean (APIENTRY* isName)(GLuint), std::vector<unsigned int>& names)
+		{
+			names.push_back(name);
+			if (name == 0 || !isName(name))
+				ok = false;
+		};
+		for (const VertexBuffer& buffer : buffers)
+			alive(buffer.GetID(), glIsBuffer, bufferNames);
+		alive(assigned.GetID(), glIsBuffer, bufferNames);
+		alive(moved.GetID(), glIsBuffer, bufferNames);
+		for (const Mesh& mesh : meshes)
+			alive(mesh.GetDrawRange().VertexArray, glIsVertexArray, arrayNames);
+		if (!ok)
+			std::cout << "FAILED: a name was deleted while still owned" << std::endl;
+
+		// Meshes that lost their element buffer binding would draw garbage or crash
+		Shader shader("3.3.shader.mesh.vs", "3.3.shader.material.fs");
+		Framebuffer target(64, 64);
+		shader.use();
+		for (Mesh& mesh : meshes)
+			mesh.Draw(shader);
+		GLCall(glFinish());
+	}
+	for (unsigned int name : bufferNames)
+		ok = ok && !glIsBuffer(name);
+	for (unsigned int name : arrayNames)
+		ok = ok && !glIsVertexArray(name);
+
+	std::cout << "handles: " << buffersCreated.GetCalls() << " buffers created, " << buffersDeleted.GetCalls() << " deleted; "
+		<< arraysCreated.GetCalls() << " vertex arrays created, " << arraysDeleted.GetCalls() << " deleted" << std::endl;
+	if (buffersCreated.GetCalls() != buffersDeleted.GetCalls() || arraysCreated.GetCalls() != arraysDeleted.GetCalls())
+	{
+		std::cout << "FAILED: every name should be deleted exactly once" << std::endl;
+		ok = false;
+	}
+	return ok ? 0 : 1;
+}
+
+// ========== load ==========
+
+// A flat grid of about the given number of triangles
+static void gridMesh(unsigned int triangles, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	unsigned int side = std::max(1u, (unsigned int)std::sqrt(triangles / 2.0));
+	vertices.resize((size_t)(side + 1) * (side + 1));
+	for (unsigned int y = 0; y <= side; y++)
+	{
+		for (unsigned int x = 0; x <= side; x++)
+		{
+			glm::vec2 uv((float)x / side, (float)y / side);
+			vertices[(size_t)y * (side + 1) + x] = { glm::vec3(uv.x, 0.0f, uv.y), glm::vec3(0.0f, 1.0f, 0.0f), uv };
+		}
+	}
+	indices.clear();
+	indices.reserve((size_t)side * side * 6);
+	for (unsigned int y = 0; y < side; y++)
+	{
+		for (unsigned int x = 0; x < side; x++)
+		{
+			unsigned int corner = y * (side + 1) + x;
+			indices.insert(indices.end(), { corner, corner + 1, corner + side + 1, corner + 1, corner + side + 2, corner + side + 1 });
+		}
+	}
+}
+
+// Peak and remaining memory of getting a big mesh onto the GPU, for each way
+// of handing Mesh its geometry. Each variant builds its own copy of the
+// source data first; memory is counted from before that. With a software
+// driver the GPU copy is process memory as well.
+static int benchmarkLoad(unsigned int triangles)
+{
+	struct Variant
+	{
+		const char* Name;
+		// Builds the mesh from the source data, which it may move from
+		std::unique_ptr<Mesh> (*Load)(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+	};
+	const Variant variants[] = {
+		{ "copied in", [](std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+			{ return std::make_unique<Mesh>(vertices, indices, std::vector<Texture>()); } },
+		{ "moved in", [](std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+			{ return std::make_unique<Mesh>(std::move(vertices), std::move(indices), std::vector<Texture>()); } },
+		{ "moved in, CPU copy released", [](std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+			{
+				auto mesh = std::make_unique<Mesh>(std::move(vertices), std::move(indices), std::vector<Texture>());
+				mesh->ReleaseCPUData();
+				return mesh;
+			} },
+		{ "span upload", [](std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+			{
+				AABB bounds;
+				for (const Vertex& vertex : vertices)
+					bounds.Expand(vertex.Position);
+				auto mesh = std::make_unique<Mesh>(std::span<const Vertex>(vertices), IndexBuffer(indices),
+					std::vector<Texture>(), bounds);
+				std::vector<Vertex>().swap(vertices);
+				std::vector<unsigned int>().swap(indices);
+				return mesh;
+			} },
+	};
+
+	bool peakReset = resetPeakMemory();
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	gridMesh(triangles, vertices, indices);
+	double sourceMB = (vertices.size() * sizeof(Vertex) + indices.size() * sizeof(unsigned int)) / (1024.0 * 1024.0);
+	std::cout << "load: " << indices.size() / 3 << " triangles, " << sourceMB << " MB of vertices and indices"
+		<< (peakReset ? "" : " (peak is for the whole run on this platform)") << std::endl
+		<< std::setw(30) << "" << std::setw(10) << "ms" << std::setw(14) << "peak MB" << std::setw(14) << "after MB" << std::endl;
+	std::cout << std::fixed << std::setprecision(1);
+	for (const Variant& variant : variants)
+	{
+		std::vector<Vertex>().swap(vertices);
+		std::vector<unsigned int>().swap(indices);
+		resetPeakMemory();
+		size_t baseline = memoryUsage().Resident;
+		gridMesh(triangles, vertices, indices);
+
+		auto start = Clock::now();
+		std::unique_ptr<Mesh> mesh = variant.Load(vertices, indices);
+		GLCall(glFinish());
+		double loadMs = millisecondsSince(start);
+		// The caller's copy, where one is left, goes now as a loader's would
+		std::vector<Vertex>().swap(vertices);
+		std::vector<unsigned int>().swap(indices);
+		releaseFreedMemory();
+		MemoryUsage usage = memoryUsage();
+
+		const double MB = 1024.0 * 1024.0;
+		std::cout << std::setw(30) << variant.Name << std::setw(10) << loadMs
+			<< std::setw(14) << ((double)usage.Peak - (double)baseline) / MB
+			<< std::setw(14) << ((double)usage.Resident - (double)baseline) / MB << std::endl;
+	}
+	std::cout << std::defaultfloat;
+	return 0;
+}
+
+// ========== errors ==========
+
+// GLCall's expansion under each GL_ERROR_CHECK policy (Renderer.h). The build
+// compiles in only one of them, so the benchmark spells them all out.
+static unsigned int s_CheckFailures = 0;
+
+template<int Policy, typename F>
+static inline void checkedCall(const char* function, F&& call)
+{
+	if constexpr (Policy == GL_ERROR_CHECK_CALL)
+	{
+		GLClearError();
+		call();
+		if (!GLLogCall(function, __FILE__, __LINE__))
+			s_CheckFailures++;
+	}
+	else if constexpr (Policy == GL_ERROR_CHECK_CALLBACK)
+	{
+		GLSetCallSite(function, __FILE__, __LINE__);
+		call();
+	}
+	else
+		call();
+}
+
+static void APIENTRY countingDebugCallback(GLenum, GLenum, GLuint, GLenum severity, GLsizei, const GLchar*, const void*)
+{
+	if (severity != GL_DEBUG_SEVERITY_NOTIFICATION)
+		s_CheckFailures++;
+}
+
+// Frame time of size per-object draws under each error checking policy
+static int benchmarkErrors(unsigned int objects)
+{
+	const unsigned int frames = 5;
+	Framebuffer target(64, 64);
+	GLCall(glViewport(0, 0, 64, 64));
+
+	std::vector<float> cube = cubeVertices();
+	VertexBuffer cubeVB(cube.data(), (unsigned int)(cube.size() * sizeof(float)));
+	VertexBufferLayout layout;
+	layout.Push<float>(3);
+	layout.Push<float>(2);
+	VertexArray va;
+	va.AddBuffer(cubeVB, layout);
+	Shader shader("3.3.shader.coordsys.vs", "3.3.shader.coordsys.fs");
+	shader.use();
+	shader.setMat4("projection", glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f));
+	shader.setMat4("view", glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -3.0f)));
+	va.Bind();
+	int modelLoc = glGetUniformLocation(shader.ID, "model");
+	std::vector<glm::mat4> models(objects);
+	for (unsigned int i = 0; i < objects; i++)
+		models[i] = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3((float)(i % 100) / 50.0f - 1.0f, 0.0f, 0.0f)), glm::vec3(0.01f));
+
+	auto frame = [&]<int Policy>()
+	{
+		return timeFrames(frames, [&]()
+		{
+			checkedCall<Policy>("glClear", [] { glClear(GL_COLOR_BUFFER_BIT); });
+			for (const glm::mat4& model : models)
+			{
+				checkedCall<Policy>("glUniformMatrix4fv", [&] { glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &model[0][0]); });
+				checkedCall<Policy>("glDrawArrays", [] { glDrawArrays(GL_TRIANGLES, 0, 36); });
+			}
+			if constexpr (Policy == GL_ERROR_CHECK_FRAME)
+			{
+				while (glGetError() != GL_NO_ERROR)
+					s_CheckFailures++;
+			}
+		});
+	};
+
+	std::cout << "errors: " << objects << " draws per frame (" << 2 * objects + 1 << " GL calls), median of "
+		<< frames << " frames; this build uses policy " << GL_ERROR_CHECK << std::endl
+		<< std::setw(12) << "" << std::setw(12) << "submit ms" << std::setw(12) << "total ms" << std::setw(12) << "vs none" << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	s_CheckFailures = 0;
+	// Warm up the driver first, or the first policy pays for it
+	frame.template operator()<GL_ERROR_CHECK_NONE>();
+	FrameTime none = frame.template operator()<GL_ERROR_CHECK_NONE>();
+	auto report = [&](const char* name, FrameTime time)
+	{
+		std::cout << std::setw(12) << name << std::setw(12) << time.Submit << std::setw(12) << time.Total
+			<< std::setw(11) << time.Total / none.Total << "x" << std::endl;
+	};
+	report("none", none);
+	report("call", frame.template operator()<GL_ERROR_CHECK_CALL>());
+	report("frame", frame.template operator()<GL_ERROR_CHECK_FRAME>());
+
+	if (GLAD_GL_VERSION_4_3)
+	{
+		// Borrow the debug output for the run, putting back whatever the build installed
+		GLboolean wasEnabled = glIsEnabled(GL_DEBUG_OUTPUT);
+		GLDEBUGPROC previous = nullptr;
+		const void* previousParam = nullptr;
+		glGetPointerv(GL_DEBUG_CALLBACK_FUNCTION, (void**)&previous);
+		glGetPointerv(GL_DEBUG_CALLBACK_USER_PARAM, (void**)&previousParam);
+		glEnable(GL_DEBUG_OUTPUT);
+		glDebugMessageCallback(countingDebugCallback, nullptr);
+		report("callback", frame.template operator()<GL_ERROR_CHECK_CALLBACK>());
+		glDebugMessageCallback(previous, previousParam);
+		if (!wasEnabled)
+			glDisable(GL_DEBUG_OUTPUT);
+	}
+	else
+		std::cout << std::setw(12) << "callback" << "  skipped, glDebugMessageCallback needs GL 4.3" << std::endl;
+	std::cout << std::defaultfloat;
+
+	if (s_CheckFailures > 0)
+	{
+		std::cout << "FAILED: " << s_CheckFailures << " errors reported during the frames" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+// ========== allocations ==========
+
+// Drawing meshes shouldn't touch the heap: sampler bindings are built at load
+// time and uniform locations are cached. Two meshes with different textures
+// are drawn size times, alternating between two programs so sampler uniforms
+// are set again on every switch; any allocation fails the run.
+static int benchmarkAllocations(unsigned int draws)
+{
+	if (!CountingAllocations())
+	{
+		std::cout << "allocations: operator new isn't hooked in this build, run LearnOpenGLTests" << std::endl;
+		return 1;
+	}
+
+	std::vector<float> cube = cubeVertices();
+	std::vector<Vertex> vertices(36);
+	std::vector<unsigned int> indices(36);
+	for (unsigned int i = 0; i < 36; i++)
+	{
+		vertices[i] = { glm::vec3(cube[i * 5], cube[i * 5 + 1], cube[i * 5 + 2]), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(0.0f) };
+		indices[i] = i;
+	}
+	unsigned int textures[3];
+	GLCall(glGenTextures(3, textures));
+	for (unsigned int texture : textures)
+	{
+		const unsigned char texel[4] = { 255, 255, 255, 255 };
+		GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, texture);
+		GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel));
+	}
+
+	uint64_t allocations = 0;
+	{
+		Mesh first(vertices, indices, { { textures[0], TextureType::Diffuse }, { textures[1], TextureType::Specular } });
+		Mesh second(vertices, indices, { { textures[2], TextureType::Diffuse }, { textures[1], TextureType::Specular } });
+		Shader shaders[2] = {
+			Shader("3.3.shader.mesh.vs", "3.3.shader.material.fs"),
+			Shader("3.3.shader.mesh.vs", "3.3.shader.material.fs")
+		};
+		Framebuffer target(64, 64);
+		auto drawAll = [&](unsigned int count)
+		{
+			for (unsigned int i = 0; i < count; i++)
+			{
+				Shader& shader = shaders[i % 2];
+				shader.use();
+				first.Draw(shader);
+				second.Draw(shader);
+			}
+		};
+
+		// The first draw with each program looks its sampler uniforms up and caches them
+		drawAll(2);
+		StartCountingAllocations();
+		auto start = Clock::now();
+		drawAll(draws);
+		double elapsed = millisecondsSince(start);
+		allocations = StopCountingAllocations();
+		GLCall(glFinish());
+
+		std::cout << "allocations: " << 2 * draws << " mesh draws in " << std::fixed << std::setprecision(2) << elapsed
+			<< " ms, " << allocations << " heap allocations" << std::defaultfloat << std::endl;
+	}
+	GLCall(glDeleteTextures(3, textures));
+	if (allocations > 0)
+	{
+		std::cout << "FAILED: Mesh::Draw allocated" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+// ========== cull ==========
+
+// Frustum culling of size boxes, one Intersects call per box against the SIMD
+// CullingSet, and how many of the --meshes grid's draws survive along the
+// headless camera path.
+static int benchmarkCull(unsigned int objects)
+{
+	const unsigned int runs = 5;
+	const float aspect = 1024.0f / 768.0f;
+	Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+	Frustum frustum(camera.GetProjectionMatrix(aspect) * camera.GetViewMatrix());
+
+	// Small boxes spread well past the far plane, so only some are visible
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> spread(-150.0f, 150.0f);
+	std::uniform_real_distribution<float> extent(0.1f, 2.0f);
+	std::vector<AABB> boxes(objects);
+	CullingSet set;
+	set.Reserve(objects);
+	for (AABB& box : boxes)
+	{
+		glm::vec3 center(spread(random), spread(random), spread(random));
+		glm::vec3 half(extent(random), extent(random), extent(random));
+		box = AABB(center - half, center + half);
+		set.Add(box);
+	}
+
+	auto median = [&](auto&& cull)
+	{
+		std::vector<double> times;
+		for (unsigned int i = 0; i < runs; i++)
+		{
+			auto start = Clock::now();
+			cull();
+			times.push_back(millisecondsSince(start));
+		}
+		std::sort(times.begin(), times.end());
+		return times[runs / 2];
+	};
+	std::vector<uint32_t> scalarVisible, setVisible;
+	double scalarMs = median([&]()
+	{
+		scalarVisible.clear();
+		for (uint32_t i = 0; i < objects; i++)
+		{
+			if (frustum.Intersects(boxes[i]))
+				scalarVisible.push_back(i);
+		}
+	});
+	double setMs = median([&]() { set.Cull(frustum, setVisible); });
+
+	std::cout << "cull: " << objects << " boxes, " << setVisible.size() << " visible, median of " << runs << " runs"
+		<< std::endl << std::fixed << std::setprecision(2)
+		<< std::setw(24) << "Frustum::Intersects" << std::setw(10) << scalarMs << " ms" << std::endl
+		<< std::setw(24) << "CullingSet::Cull" << std::setw(10) << setMs << " ms" << std::setw(9) << scalarMs / setMs << "x" << std::endl;
+	bool ok = scalarVisible == setVisible;
+	if (!ok)
+		std::cout << "FAILED: CullingSet found " << setVisible.size() << " boxes, Intersects " << scalarVisible.size() << std::endl;
+
+	// The --meshes grid of Test.cpp: half-size cubes on a square in front of the camera
+	unsigned int side = (unsigned int)std::ceil(std::sqrt((float)objects));
+	const AABB unitCube(glm::vec3(-0.5f), glm::vec3(0.5f));
+	set.Clear();
+	for (unsigned int i = 0; i < objects; i++)
+	{
+		glm::vec3 gridPosition((float)(i % side) - side * 0.5f, -4.0f, -(float)(i / side) - 5.0f);
+		set.Add(unitCube.Transformed(glm::scale(glm::translate(glm::mat4(1.0f), gridPosition * 1.5f), glm::vec3(0.5f))));
+	}
+	const unsigned int frames = 60;
+	size_t fewest = SIZE_MAX, most = 0, total = 0;
+	double cullMs = 0.0;
+	for (unsigned int frame = 0; frame < frames; frame++)
+	{
+		scriptedCamera(camera, frame, frames);
+		auto start = Clock::now();
+		set.Cull(Frustum(camera.GetProjectionMatrix(aspect) * camera.GetViewMatrix()), setVisible);
+		cullMs += millisecondsSince(start);
+		fewest = std::min(fewest, setVisible.size());
+		most = std::max(most, setVisible.size());
+		total += setVisible.size();
+	}
+	std::cout << "fly-through of " << frames << " frames over the grid: " << fewest << " / " << total / frames << " / " << most
+		<< " draws (min / avg / max) of " << objects << ", culled in " << cullMs / frames << " ms a frame" << std::endl;
+	std::cout << std::defaultfloat;
+	return ok ? 0 : 1;
+}
+
+// ========== bvh ==========
+
+// Boxes of up to 2 units scattered at the same density whatever their count
+static std::vector<AABB> scatteredBoxes(unsigned int count, std::mt19937& random)
+{
+	float half = 2.0f * std::cbrt((float)count);
+	std::uniform_real_distribution<float> spread(-half, half);
+	std::uniform_real_distribution<float> extent(0.1f, 1.0f);
+	std::vector<AABB> boxes(count);
+	for (AABB& box : boxes)
+	{
+		glm::vec3 center(spread(random), spread(random), spread(random));
+		glm::vec3 size(extent(random), extent(random), extent(random));
+		box = AABB(center - size, center + size);
+	}
+	return boxes;
+}
+
+struct BVHQueries
+{
+	std::vector<Frustum> Frustums;
+	std::vector<Ray> Rays;
+	std::vector<glm::vec3> Points;
+};
+
+// Cameras, rays and points spread over the volume of the boxes
+static BVHQueries bvhQueries(const std::vector<AABB>& boxes, std::mt19937& random)
+{
+	AABB bounds;
+	for (const AABB& box : boxes)
+		bounds.Expand(box);
+	std::uniform_real_distribution<float> x(bounds.Min.x, bounds.Max.x), y(bounds.Min.y, bounds.Max.y), z(bounds.Min.z, bounds.Max.z);
+	std::uniform_real_distribution<float> angle(0.0f, 360.0f), unit(-1.0f, 1.0f);
+	BVHQueries queries;
+	Camera camera;
+	for (unsigned int i = 0; i < 20; i++)
+	{
+		camera.Position = glm::vec3(x(random), y(random), z(random));
+		camera.Yaw = angle(random);
+		camera.ProcessMouseMovement(0.0f, 0.0f);
+		queries.Frustums.emplace_back(camera.GetProjectionMatrix(1024.0f / 768.0f) * camera.GetViewMatrix());
+	}
+	for (unsigned int i = 0; i < 1000; i++)
+	{
+		glm::vec3 direction(unit(random), unit(random), unit(random));
+		queries.Rays.push_back({ glm::vec3(x(random), y(random), z(random)), glm::normalize(direction + glm::vec3(0.0f, 0.0f, 1e-3f)) });
+		queries.Points.emplace_back(x(random), y(random), z(random));
+	}
+	return queries;
+}
+
+// Every query answered by testing every box, as the BVH should answer it.
+// Ties may pick different objects, so rays and points compare distances.
+static bool bvhMatchesBruteForce(const BVH& bvh, const std::vector<AABB>& boxes, const BVHQueries& queries)
+{
+	std::vector<uint32_t> visible, expected;
+	for (const Frustum& frustum : queries.Frustums)
+	{
+		bvh.QueryFrustum(frustum, visible);
+		std::sort(visible.begin(), visible.end());
+		expected.clear();
+		for (uint32_t i = 0; i < boxes.size(); i++)
+		{
+			if (frustum.Intersects(boxes[i]))
+				expected.push_back(i);
+		}
+		if (visible != expected)
+		{
+			std::cout << "FAILED: QueryFrustum found " << visible.size() << " objects, brute force " << expected.size() << std::endl;
+			return false;
+		}
+	}
+	for (const Ray& ray : queries.Rays)
+	{
+		glm::vec3 inverse = 1.0f / ray.Direction;
+		float nearest = FLT_MAX, distance;
+		for (const AABB& box : boxes)
+		{
+			if (box.Intersects(ray, inverse, FLT_MAX, distance))
+				nearest = std::min(nearest, distance);
+		}
+		RayHit hit = bvh.Raycast(ray);
+		if (hit.Distance != nearest || hit.IsValid() != (nearest != FLT_MAX))
+		{
+			std::cout << "FAILED: Raycast hit at " << hit.Distance << ", brute force at " << nearest << std::endl;
+			return false;
+		}
+	}
+	for (const glm::vec3& point : queries.Points)
+	{
+		float nearest = FLT_MAX;
+		for (const AABB& box : boxes)
+			nearest = std::min(nearest, box.DistanceSquared(point));
+		uint32_t found = bvh.FindNearest(point);
+		if (found == UINT32_MAX || boxes[found].DistanceSquared(point) != nearest)
+		{
+			std::cout << "FAILED: FindNearest returned " << found << ", not a box at the nearest distance" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+// Build, refit and query times from 10k objects up to size. Sets small enough
+// to brute force are checked against it, after the build and after a refit.
+static int benchmarkBVH(unsigned int maxObjects)
+{
+	const unsigned int bruteForceLimit = 20000;
+	unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+	std::mt19937 random(1);
+
+	std::cout << "bvh: build on 1 and " << threads << " threads, refit after every box moved, queries of 20 frustums, "
+		<< "1000 rays and 1000 points" << std::endl
+		<< std::setw(10) << "objects" << std::setw(12) << "build ms" << std::setw(12) << "parallel" << std::setw(12) << "refit ms"
+		<< std::setw(14) << "frustum us" << std::setw(10) << "ray us" << std::setw(12) << "nearest us" << std::setw(10) << "checked" << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	bool ok = true;
+	for (unsigned int count = std::min(10000u, maxObjects); ok; count = std::min(count * 10, maxObjects))
+	{
+		std::vector<AABB> boxes = scatteredBoxes(count, random);
+		BVHQueries queries = bvhQueries(boxes, random);
+		BVH bvh;
+		auto start = Clock::now();
+		bvh.Build(boxes, 1);
+		double buildMs = millisecondsSince(start);
+		start = Clock::now();
+		bvh.Build(boxes, threads);
+		double parallelMs = millisecondsSince(start);
+		bool check = count <= bruteForceLimit;
+		if (check)
+			ok = bvhMatchesBruteForce(bvh, boxes, queries);
+
+		// Nudge every box and refit rather than rebuild
+		std::uniform_real_distribution<float> nudge(-0.5f, 0.5f);
+		for (AABB& box : boxes)
+		{
+			glm::vec3 offset(nudge(random), nudge(random), nudge(random));
+			box = AABB(box.Min + offset, box.Max + offset);
+		}
+		start = Clock::now();
+		bvh.Refit(boxes);
+		double refitMs = millisecondsSince(start);
+		if (check && ok)
+			ok = bvhMatchesBruteForce(bvh, boxes, queries);
+
+		std::vector<uint32_t> visible;
+		start = Clock::now();
+		for (const Frustum& frustum : queries.Frustums)
+			bvh.QueryFrustum(frustum, visible);
+		double frustumUs = millisecondsSince(start) * 1000.0 / queries.Frustums.size();
+		start = Clock::now();
+		uint32_t hits = 0;
+		for (const Ray& ray : queries.Rays)
+			hits += bvh.Raycast(ray).IsValid();
+		double rayUs = millisecondsSince(start) * 1000.0 / queries.Rays.size();
+		start = Clock::now();
+		for (const glm::vec3& point : queries.Points)
+			hits += bvh.FindNearest(point) != UINT32_MAX;
+		double nearestUs = millisecondsSince(start) * 1000.0 / queries.Points.size();
+
+		std::cout << std::setw(10) << count << std::setw(12) << buildMs << std::setw(12) << parallelMs << std::setw(12) << refitMs
+			<< std::setw(14) << frustumUs << std::setw(10) << rayUs << std::setw(12) << nearestUs
+			<< std::setw(10) << (check ? (ok ? "yes" : "FAILED") : "no") << std::endl;
+		if (count == maxObjects)
+			break;
+	}
+	std::cout << std::defaultfloat;
+	return ok ? 0 : 1;
+}
+
+// ========== mips ==========
+
+// Largest difference between two mip chains, in 8-bit steps
+static int mipDifference(const std::vector<MipLevel>& a, const std::vector<MipLevel>& b)
+{
+	if (a.size() != b.size())
+		return 256;
+	int difference = 0;
+	for (size_t level = 0; level < a.size(); level++)
+	{
+		for (size_t i = 0; i < a[level].pixels.size(); i++)
+			difference = std::max(difference, std::abs((int)a[level].pixels[i] - (int)b[level].pixels[i]));
+	}
+	return difference;
+}
+
+// A size x size RGBA image through GenerateMips with the SIMD and the scalar
+// kernels, and through glGenerateMipmap. The two CPU chains may only differ
+// by rounding, which is also checked on an odd-sized image.
+static int benchmarkMips(unsigned int size)
+{
+	const unsigned int runs = 5;
+	std::mt19937 random(1);
+	auto image = [&](unsigned int width, unsigned int height)
+	{
+		std::uniform_int_distribution<int> noise(0, 63);
+		std::vector<uint8_t> pixels((size_t)width * height * 4);
+		for (size_t i = 0; i < pixels.size(); i++)
+			pixels[i] = (uint8_t)(((i / 4) % width * 192 / width) + noise(random));
+		return pixels;
+	};
+	auto median = [&](auto&& run)
+	{
+		std::vector<double> times;
+		for (unsigned int i = 0; i < runs; i++)
+		{
+			auto start = Clock::now();
+			run();
+			times.push_back(millisecondsSince(start));
+		}
+		std::sort(times.begin(), times.end());
+		return times[runs / 2];
+	};
+
+	std::vector<uint8_t> pixels = image(size, size);
+	MipOptions simd, scalar;
+	scalar.simd = false;
+	std::vector<MipLevel> simdMips, scalarMips;
+	// Interleaved, so neither kernel gets the warm caches and allocator to itself
+	std::vector<double> simdTimes, scalarTimes;
+	for (unsigned int i = 0; i < runs; i++)
+	{
+		auto start = Clock::now();
+		simdMips = GenerateMips(pixels.data(), size, size, 4, simd);
+		simdTimes.push_back(millisecondsSince(start));
+		start = Clock::now();
+		scalarMips = GenerateMips(pixels.data(), size, size, 4, scalar);
+		scalarTimes.push_back(millisecondsSince(start));
+	}
+	std::sort(simdTimes.begin(), simdTimes.end());
+	std::sort(scalarTimes.begin(), scalarTimes.end());
+	double simdMs = simdTimes[runs / 2], scalarMs = scalarTimes[runs / 2];
+	int difference = mipDifference(simdMips, scalarMips);
+	std::vector<uint8_t> odd = image(301, 199);
+	difference = std::max(difference, mipDifference(GenerateMips(odd.data(), 301, 199, 4, simd), GenerateMips(odd.data(), 301, 199, 4, scalar)));
+
+	unsigned int texture;
+	GLCall(glGenTextures(1, &texture));
+	GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, texture);
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+	GLCall(glFinish());
+	double glMs = median([&]()
+	{
+		GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+		GLCall(glFinish());
+	});
+	GLCall(glDeleteTextures(1, &texture));
+
+	std::cout << "mips: " << size << "x" << size << " RGBA, sRGB and premultiplied alpha, " << simdMips.size()
+		<< " levels, median of " << runs << " runs" << std::endl << std::fixed << std::setprecision(2)
+#if defined(__AVX__)
+		<< std::setw(30) << "GenerateMips, AVX"
+#else
+		<< std::setw(30) << "GenerateMips, SIMD"
+#endif
+		<< std::setw(10) << simdMs << " ms" << std::endl
+		<< std::setw(30) << "GenerateMips, scalar" << std::setw(10) << scalarMs << " ms" << std::endl
+		<< std::setw(30) << "glGenerateMipmap" << std::setw(10) << glMs << " ms" << std::endl
+		<< std::defaultfloat << "largest SIMD/scalar difference: " << difference << std::endl;
+	if (difference > 1)
+	{
+		std::cout << "FAILED: the SIMD and scalar kernels should only differ by rounding" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+// ========== binds ==========
+
+static void materialColor(unsigned int material, unsigned char color[3])
+{
+	color[0] = (unsigned char)(material * 37 + 20);
+	color[1] = (unsigned char)(material * 101 + 60);
+	color[2] = (unsigned char)(material * 13 + 100);
+}
+
+// An OBJ of one quad per material on a side x side grid covering clip space,
+// each material with a solid 16x16 PPM of its own
+static std::filesystem::path writeMaterialGrid(const std::filesystem::path& directory, unsigned int materials, unsigned int side)
+{
+	std::filesystem::create_directories(directory);
+	std::ofstream obj(directory / "grid.obj"), mtl(directory / "grid.mtl");
+	obj << "mtllib grid.mtl\nvt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n";
+	float cell = 2.0f / side;
+	for (unsigned int i = 0; i < materials; i++)
+	{
+		std::string texture = "material" + std::to_string(i) + ".ppm";
+		std::ofstream image(directory / texture, std::ios::binary);
+		image << "P6\n16 16\n255\n";
+		unsigned char color[3];
+		materialColor(i, color);
+		for (unsigned int texel = 0; texel < 16 * 16; texel++)
+			image.write((const char*)color, 3);
+		mtl << "newmtl m" << i << "\nmap_Kd " << texture << "\n";
+
+		float x = -1.0f + cell * (i % side), y = -1.0f + cell * (i / side);
+		obj << "v " << x << " " << y << " 0\nv " << x + cell << " " << y << " 0\n"
+			<< "v " << x + cell << " " << y + cell << " 0\nv " << x << " " << y + cell << " 0\n";
+		unsigned int v = i * 4 + 1;
+		obj << "g quad" << i << "\nusemtl m" << i << "\n"
+			<< "f " << v << "/1 " << v + 1 << "/2 " << v + 2 << "/3\nf " << v << "/1 " << v + 2 << "/3 " << v + 3 << "/4\n";
+	}
+	return directory / "grid.obj";
+}
+
+// Imports a model of size (256) quads, each with a material and texture of its
+// own, and counts glBindTexture calls per frame of drawing it mesh by mesh and
+// through RenderQueue: first with a texture per material, then with the
+// textures as layers of one texture array. Both have to render the same image.
+static int benchmarkBinds(unsigned int materials)
+{
+	const unsigned int size = 256;
+	const unsigned int frames = 10;
+	unsigned int side = (unsigned int)std::ceil(std::sqrt((double)materials));
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "learnopengl_binds";
+	std::filesystem::path objPath = writeMaterialGrid(directory, materials, side);
+
+	Framebuffer target(size, size);
+	GLCall(glViewport(0, 0, size, size));
+	GLCall(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
+	TextureLoader loader;
+	ModelImporter importer;
+	RenderQueue queue;
+	GLCallCounter<glad_glBindTexture> bindCalls;
+
+	struct Result
+	{
+		double DrawBinds;
+		double QueueBinds;
+		size_t Arrays;
+		std::vector<unsigned char> Pixels;
+	};
+	Result results[2];
+	for (int layered = 0; layered < 2; layered++)
+	{
+		ModelData data;
+		if (!importer.Import(objPath.string(), data))
+		{
+			std::filesystem::remove_all(directory);
+			return 1;
+		}
+		TextureCache cache(loader);
+		TextureArrayAllocator arrays(materials);
+		Model model = Model::Create(data, cache, nullptr, false, layered ? &arrays : nullptr);
+		loader.Finish();
+
+		Shader shader("3.3.shader.mesh.vs", layered ? "3.3.shader.material.array.fs" : "3.3.shader.material.fs");
+		shader.use();
+		shader.setMat4("projection", glm::mat4(1.0f));
+		shader.setMat4("view", glm::mat4(1.0f));
+		UniformHandle modelLoc = shader.getUniformHandle("model");
+		auto drawMeshes = [&]()
+		{
+			GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+			shader.use();
+			shader.set(modelLoc, glm::mat4(1.0f));
+			for (Mesh& mesh : model.Meshes)
+				mesh.Draw(shader);
+		};
+		auto drawQueue = [&]()
+		{
+			GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+			queue.Begin(glm::vec3(0.0f), 100.0f);
+			for (Mesh& mesh : model.Meshes)
+				queue.Submit(mesh, shader, glm::mat4(1.0f));
+			queue.Flush();
+		};
+		// The first frame binds the textures whatever happens; count the ones after it
+		auto bindsPerFrame = [&](auto&& draw)
+		{
+			draw();
+			bindCalls.Reset();
+			for (unsigned int i = 0; i < frames; i++)
+				draw();
+			return (double)bindCalls.GetCalls() / frames;
+		};
+		Result& result = results[layered];
+		result.DrawBinds = bindsPerFrame(drawMeshes);
+		result.QueueBinds = bindsPerFrame(drawQueue);
+		result.Arrays = arrays.GetArrays().size();
+		result.Pixels = target.ReadPixels();
+	}
+	std::filesystem::remove_all(directory);
+
+	std::cout << "binds: " << materials << " materials, glBindTexture calls per frame, mean of " << frames << " frames"
+		<< std::endl << std::setw(30) << "" << std::setw(12) << "Mesh::Draw" << std::setw(14) << "RenderQueue" << std::endl
+		<< std::setw(30) << "a texture per material" << std::setw(12) << results[0].DrawBinds << std::setw(14) << results[0].QueueBinds
+		<< std::endl << std::setw(30) << "texture array layers" << std::setw(12) << results[1].DrawBinds << std::setw(14) << results[1].QueueBinds
+		<< "  (" << results[1].Arrays << " array)" << std::endl;
+
+	// Every quad shows its own color, the same either way
+	int difference = 0;
+	for (size_t i = 0; i < results[0].Pixels.size(); i++)
+		difference = std::max(difference, std::abs(results[0].Pixels[i] - results[1].Pixels[i]));
+	unsigned int wrongQuads = 0;
+	for (unsigned int i = 0; i < materials; i++)
+	{
+		unsigned int x = (2 * (i % side) + 1) * size / (2 * side), y = (2 * (i / side) + 1) * size / (2 * side);
+		const unsigned char* pixel = &results[1].Pixels[((size_t)y * size + x) * 4];
+		unsigned char color[3];
+		materialColor(i, color);
+		for (int c = 0; c < 3; c++)
+		{
+			if (std::abs(pixel[c] - color[c]) > 1)
+			{
+				wrongQuads++;
+				break;
+			}
+		}
+	}
+	std::cout << "largest pixel difference: " << difference << ", quads with the wrong color: " << wrongQuads << std::endl;
+	if (difference > 1 || wrongQuads > 0)
+	{
+		std::cout << "FAILED: the texture array layers should render what the separate textures do" << std::endl;
+		return 1;
+	}
+	if (results[1].DrawBinds > results[1].Arrays || results[1].QueueBinds > results[1].Arrays)
+	{
+		std::cout << "FAILED: meshes sharing a texture array should not need binds in between" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+// ========== stream ==========
+
+// Small triangles scattered over clip space, each a flat color: its texture
+// coordinates all point at one texel of a 16x16 texture. Position, texcoord.
+static std::vector<float> streamedTriangles(unsigned int frame, unsigned int vertexCount)
+{
+	std::mt19937 random(frame + 1);
+	std::uniform_real_distribution<float> spread(-1.0f, 1.0f);
+	std::uniform_int_distribution<int> texel(0, 255);
+	const glm::vec2 corners[3] = { { -0.03f, -0.03f }, { 0.03f, -0.03f }, { 0.0f, 0.03f } };
+	std::vector<float> vertices((size_t)vertexCount * 5);
+	for (unsigned int v = 0; v + 3 <= vertexCount; v += 3)
+	{
+		glm::vec2 center(spread(random), spread(random));
+		int t = texel(random);
+		glm::vec2 uv((t % 16 + 0.5f) / 16.0f, (t / 16 + 0.5f) / 16.0f);
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			float* vertex = &vertices[(size_t)(v + c) * 5];
+			vertex[0] = center.x + corners[c].x;
+			vertex[1] = center.y + corners[c].y;
+			vertex[2] = 0.0f;
+			vertex[3] = uv.x;
+			vertex[4] = uv.y;
+		}
+	}
+	return vertices;
+}
+
+// Streams size (300000) vertices of small triangles per frame through a
+// StreamBuffer ring of three regions, for more frames than the ring has and
+// without waiting on the GPU in between. Each frame goes to a target of its
+// own in a few allocations, drawn by their base vertex. Checks that every
+// allocation lies in the region of its frame, that a region is only written
+// again once the frame that last used it has finished on the GPU, and that
+// every frame renders what its vertices do from a static buffer.
+static int benchmarkStream(unsigned int vertexCount)
+{
+	const unsigned int size = 128;
+	const unsigned int frames = 8;
+	const unsigned int ringFrames = 3;
+	const unsigned int chunks = 4;
+	const unsigned int stride = 5 * sizeof(float);
+	// Whole triangles in every chunk
+	vertexCount = std::max(vertexCount / (3 * chunks), 1u) * 3 * chunks;
+	unsigned int chunkVertices = vertexCount / chunks;
+
+	GLCall(glViewport(0, 0, size, size));
+	GLStateCache::Get().SetEnabled(GL_DEPTH_TEST, false);
+	std::mt19937 random(1);
+	std::vector<uint8_t> palette(16 * 16 * 4);
+	for (uint8_t& channel : palette)
+		channel = (uint8_t)random();
+	unsigned int texture;
+	GLCall(glGenTextures(1, &texture));
+	GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, texture);
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 16, 16, 0, GL_RGBA, GL_UNSIGNED_BYTE, palette.data()));
+
+	// coordsys.fs mixes two samplers; with both on the palette it shows the palette
+	Shader shader("3.3.shader.coordsys.vs", "3.3.shader.coordsys.fs");
+	shader.use();
+	shader.setInt("texture1", 0);
+	shader.setInt("texture2", 0);
+	shader.setMat4("model", glm::mat4(1.0f));
+	shader.setMat4("view", glm::mat4(1.0f));
+	shader.setMat4("projection", glm::mat4(1.0f));
+	VertexBufferLayout layout;
+	layout.Push<float>(3);
+	layout.Push<float>(2);
+
+	std::vector<std::vector<float>> frameVertices;
+	std::vector<std::unique_ptr<Framebuffer>> targets;
+	for (unsigned int frame = 0; frame < frames; frame++)
+	{
+		frameVertices.push_back(streamedTriangles(frame, vertexCount));
+		targets.push_back(std::make_unique<Framebuffer>(size, size));
+	}
+
+	unsigned int misplaced = 0, reusedEarly = 0;
+	double waitMs = 0.0, longestWaitMs = 0.0;
+	bool persistent;
+	std::vector<GLsync> drawn(frames, nullptr);
+	auto start = Clock::now();
+	{
+		StreamBuffer stream(vertexCount * stride, stride, ringFrames);
+		persistent = stream.IsPersistent();
+		VertexArray streamVA;
+		streamVA.AddBuffer(stream, layout);
+		unsigned int regionSize = vertexCount * stride;
+		for (unsigned int frame = 0; frame < frames; frame++)
+		{
+			// EndFrame of the previous frame has to have waited for the frame that last used this region
+			if (frame >= ringFrames)
+			{
+				GLint status = GL_UNSIGNALED;
+				GLCall(glGetSynciv(drawn[frame - ringFrames], GL_SYNC_STATUS, 1, nullptr, &status));
+				if (status != GL_SIGNALED)
+					reusedEarly++;
+			}
+
+			StreamAllocation allocations[chunks];
+			for (unsigned int c = 0; c < chunks; c++)
+			{
+				StreamAllocation& allocation = allocations[c];
+				allocation = stream.Allocate(chunkVertices);
+				unsigned int offset = (frame % ringFrames) * regionSize + c * chunkVertices * stride;
+				if (!allocation.Data || allocation.Offset != offset || allocation.BaseVertex != offset / stride)
+				{
+					misplaced++;
+					continue;
+				}
+				memcpy(allocation.Data, &frameVertices[frame][(size_t)c * chunkVertices * 5], (size_t)chunkVertices * stride);
+			}
+			stream.Flush();
+
+			targets[frame]->Bind();
+			GLCall(glClear(GL_COLOR_BUFFER_BIT));
+			shader.use();
+			streamVA.Bind();
+			for (const StreamAllocation& allocation : allocations)
+			{
+				if (allocation.Data)
+					GLCall(glDrawArrays(GL_TRIANGLES, allocation.BaseVertex, chunkVertices));
+			}
+			GLCall(drawn[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+			auto endStart = Clock::now();
+			stream.EndFrame();
+			double endMs = millisecondsSince(endStart);
+			waitMs += endMs;
+			longestWaitMs = std::max(longestWaitMs, endMs);
+		}
+		GLCall(glFinish());
+	}
+	double streamMs = millisecondsSince(start);
+	for (GLsync fence : drawn)
+		GLCall(glDeleteSync(fence));
+
+	// The same vertices from a static buffer, drawn in one go
+	unsigned int differentFrames = 0;
+	int difference = 0;
+	Framebuffer reference(size, size);
+	for (unsigned int frame = 0; frame < frames; frame++)
+	{
+		VertexBuffer vb(frameVertices[frame].data(), vertexCount * stride);
+		VertexArray va;
+		va.AddBuffer(vb, layout);
+		reference.Bind();
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+		shader.use();
+		va.Bind();
+		GLCall(glDrawArrays(GL_TRIANGLES, 0, vertexCount));
+		std::vector<unsigned char> expected = reference.ReadPixels(), streamed = targets[frame]->ReadPixels();
+		int frameDifference = 0;
+		for (size_t i = 0; i < expected.size(); i++)
+			frameDifference = std::max(frameDifference, std::abs(expected[i] - streamed[i]));
+		if (frameDifference > 0)
+			differentFrames++;
+		difference = std::max(difference, frameDifference);
+	}
+	reference.Unbind();
+	GLCall(glDeleteTextures(1, &texture));
+
+	std::cout << "stream: " << vertexCount << " vertices (" << std::fixed << std::setprecision(1)
+		<< vertexCount * stride / (1024.0 * 1024.0) << " MB) per frame in " << chunks << " allocations, " << frames
+		<< " frames through a ring of " << ringFrames << ", " << (persistent ? "persistent mapping" : "mapped per frame")
+		<< std::endl << std::setprecision(2)
+		<< "  " << streamMs << " ms in all, EndFrame waited " << waitMs << " ms (longest " << longestWaitMs << " ms)"
+		<< std::defaultfloat << std::endl
+		<< "  misplaced allocations: " << misplaced << ", regions written before their last frame finished: " << reusedEarly
+		<< std::endl << "  frames unlike the static buffer draw: " << differentFrames << " (largest difference " << difference
+		<< ")" << std::endl;
+	if (misplaced > 0 || reusedEarly > 0)
+	{
+		std::cout << "FAILED: each frame has to get its own region, free of the GPU" << std::endl;
+		return 1;
+	}
+	if (differentFrames > 0)
+	{
+		std::cout << "FAILED: streamed frames should render what the static buffer does" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+// ========== pool ==========
+
+// Free gaps of [0, capacity) around the live ranges (offset -> size)
+static std::vector<std::pair<size_t, size_t>> freeGaps(const std::map<size_t, size_t>& live, size_t capacity)
+{
+	std::vector<std::pair<size_t, size_t>> gaps;
+	size_t end = 0;
+	for (const auto& [offset, size] : live)
+	{
+		if (offset > end)
+			gaps.push_back({ end, offset - end });
+		end = offset + size;
+	}
+	if (capacity > end)
+		gaps.push_back({ end, capacity - end });
+	return gaps;
+}
+
+// Random allocations and frees, each checked against the live ranges kept on
+// the side: allocations land at the start of the smallest gap that fits (the
+// lowest of equal ones) and only fail when none does, ranges never overlap,
+// and after every call the used units, the number of free ranges (freed
+// neighbours merge, so one per gap) and the largest one match the gaps.
+static unsigned int checkRangeAllocator(unsigned int operations)
+{
+	const size_t capacity = 4096;
+	RangeAllocator allocator(capacity);
+	std::map<size_t, size_t> live;
+	size_t used = 0;
+	unsigned int failures = 0;
+	std::mt19937 random(1);
+	std::uniform_int_distribution<size_t> sizes(1, 64);
+	for (unsigned int i = 0; i < operations && failures < 10; i++)
+	{
+		std::vector<std::pair<size_t, size_t>> gaps = freeGaps(live, capacity);
+		// Keeps the allocator about half full, with frees picking a random live range
+		if (live.empty() || random() % 2 == 0)
+		{
+			size_t size = sizes(random);
+			const std::pair<size_t, size_t>* best = nullptr;
+			for (const auto& gap : gaps)
+			{
+				if (gap.second >= size && (!best || gap.second < best->second))
+					best = &gap;
+			}
+			size_t offset = allocator.Allocate(size);
+			if (offset != (best ? best->first : RangeAllocator::Fail))
+			{
+				std::cout << "  allocation " << i << " of " << size << " at " << offset << ", expected "
+					<< (best ? std::to_string(best->first) : "Fail") << std::endl;
+				failures++;
+			}
+			if (offset != RangeAllocator::Fail)
+			{
+				auto next = live.lower_bound(offset);
+				bool overlaps = (next != live.end() && next->first < offset + size)
+					|| (next != live.begin() && std::prev(next)->first + std::prev(next)->second > offset)
+					|| offset + size > capacity;
+				if (overlaps)
+				{
+					std::cout << "  allocation " << i << " overlaps a live range" << std::endl;
+					failures++;
+				}
+				live[offset] = size;
+				used += size;
+			}
+		}
+		else
+		{
+			auto range = std::next(live.begin(), random() % live.size());
+			allocator.Free(range->first, range->second);
+			used -= range->second;
+			live.erase(range);
+		}
+
+		gaps = freeGaps(live, capacity);
+		size_t largest = 0;
+		for (const auto& gap : gaps)
+			largest = std::max(largest, gap.second);
+		if (allocator.GetUsed() != used || allocator.GetFreeRangeCount() != gaps.size() || allocator.GetLargestFreeRange() != largest)
+		{
+			std::cout << "  after operation " << i << ": used " << allocator.GetUsed() << " (expected " << used << "), "
+				<< allocator.GetFreeRangeCount() << " free ranges (" << gaps.size() << "), largest " << allocator.GetLargestFreeRange()
+				<< " (" << largest << ")" << std::endl;
+			failures++;
+		}
+	}
+	return failures;
+}
+
+// size (100000) random RangeAllocator operations, checked as above. Then a
+// GeometryPool of small pages is filled with quads and three in four of them
+// are freed; defragmenting has to release pages, leave at most one free
+// range per buffer and page, and draw exactly what the pool drew before.
+static int benchmarkPool(unsigned int operations)
+{
+	auto start = Clock::now();
+	unsigned int allocatorFailures = checkRangeAllocator(operations);
+	double allocatorMs = millisecondsSince(start);
+
+	const unsigned int size = 256;
+	const unsigned int quads = 1024;
+	const unsigned int side = 32;
+	GLCall(glViewport(0, 0, size, size));
+	GLStateCache::Get().SetEnabled(GL_DEPTH_TEST, false);
+	std::mt19937 random(1);
+	std::vector<uint8_t> palette(16 * 16 * 4);
+	for (uint8_t& channel : palette)
+		channel = (uint8_t)random();
+	unsigned int texture;
+	GLCall(glGenTextures(1, &texture));
+	GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, texture);
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 16, 16, 0, GL_RGBA, GL_UNSIGNED_BYTE, palette.data()));
+	Shader shader("3.3.shader.mesh.vs", "3.3.shader.material.fs");
+	shader.use();
+	shader.setInt("material.texture_diffuse1", 0);
+	shader.setMat4("model", glm::mat4(1.0f));
+	shader.setMat4("view", glm::mat4(1.0f));
+	shader.setMat4("projection", glm::mat4(1.0f));
+
+	// 128 quads fill a page's vertices and, as 16-bit indices of three units each, its index space
+	GeometryPool pool(512, 128 * 12);
+	std::vector<GeometryAllocation> allocations;
+	const std::vector<unsigned int> indices = { 0, 1, 2, 0, 2, 3 };
+	float cell = 2.0f / side;
+	for (unsigned int i = 0; i < quads; i++)
+	{
+		glm::vec2 corner(-1.0f + cell * (i % side), -1.0f + cell * (i / side));
+		glm::vec2 uv((i % 16 + 0.5f) / 16.0f, (i / 16 % 16 + 0.5f) / 16.0f);
+		const glm::vec2 offsets[4] = { { 0.1f, 0.1f }, { 0.9f, 0.1f }, { 0.9f, 0.9f }, { 0.1f, 0.9f } };
+		Vertex vertices[4];
+		for (int v = 0; v < 4; v++)
+			vertices[v] = { glm::vec3(corner + offsets[v] * cell, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), uv };
+		allocations.push_back(pool.Allocate(vertices, indices));
+	}
+	for (GeometryAllocation& allocation : allocations)
+	{
+		if (random() % 4 != 0)
+			allocation.Reset();
+	}
+
+	Framebuffer target(size, size);
+	auto draw = [&]()
+	{
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+		shader.use();
+		for (const GeometryAllocation& allocation : allocations)
+		{
+			if (!allocation)
+				continue;
+			const DrawRange& range = allocation.GetDrawRange();
+			GLStateCache::Get().BindVertexArray(range.VertexArray);
+			range.Draw();
+		}
+		return target.ReadPixels();
+	};
+	std::vector<unsigned char> before = draw();
+	GeometryPoolStats fragmented = pool.GetStats();
+	start = Clock::now();
+	size_t released = pool.Defragment();
+	GLCall(glFinish());
+	double defragmentMs = millisecondsSince(start);
+	GeometryPoolStats packed = pool.GetStats();
+	std::vector<unsigned char> after = draw();
+	target.Unbind();
+	GLCall(glDeleteTextures(1, &texture));
+
+	int difference = 0;
+	for (size_t i = 0; i < before.size(); i++)
+		difference = std::max(difference, std::abs(before[i] - after[i]));
+	std::cout << "pool: " << operations << " random RangeAllocator operations checked in " << std::fixed << std::setprecision(2)
+		<< allocatorMs << " ms, " << allocatorFailures << " mismatches" << std::endl
+		<< "  " << packed.Allocations << " of " << quads << " quads left: " << fragmented.Pages << " pages, "
+		<< fragmented.FreeRanges << " free ranges -> defragmented in " << defragmentMs << " ms -> " << packed.Pages
+		<< " pages (" << released << " released), " << packed.FreeRanges << " free ranges" << std::endl
+		<< std::defaultfloat << "  largest pixel difference after defragmenting: " << difference << std::endl;
+	if (allocatorFailures > 0)
+	{
+		std::cout << "FAILED: RangeAllocator disagrees with the live ranges" << std::endl;
+		return 1;
+	}
+	if (packed.Pages >= fragmented.Pages || released != fragmented.Pages - packed.Pages
+		|| packed.FreeRanges > 2 * packed.Pages || packed.VerticesUsed != fragmented.VerticesUsed)
+	{
+		std::cout << "FAILED: defragmenting should pack the quads into fewer pages" << std::endl;
+		return 1;
+	}
+	if (difference > 0)
+	{
+		std::cout << "FAILED: the pool should draw the same after defragmenting" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+// ========== mesh-load ==========
+
+static bool writeGridObj(const std::filesystem::path& path, const std::vector<Vertex>& vertices,
+	const std::vector<unsigned int>& indices)
+{
+	std::ofstream obj(path, std::ios::binary);
+	char line[192];
+	for (const Vertex& v : vertices)
+	{
+		int length = snprintf(line, sizeof(line), "v %g %g %g\nvt %g %g\nvn %g %g %g\n", v.Position.x, v.Position.y,
+			v.Position.z, v.TexCoords.x, v.TexCoords.y, v.Normal.x, v.Normal.y, v.Normal.z);
+		obj.write(line, length);
+	}
+	for (size_t i = 0; i + 3 <= indices.size(); i += 3)
+	{
+		unsigned int a = indices[i] + 1, b = indices[i + 1] + 1, c = indices[i + 2] + 1;
+		int length = snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c);
+		obj.write(line, length);
+	}
+	return (bool)obj;
+}
+
+// Writes the file out and drops it from the page cache, so the next read
+// comes from the disk. Returns false where that isn't possible.
+static bool evictFromPageCache(const std::filesystem::path& path)
+{
+#ifdef __linux__
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+	// Dirty pages can't be dropped
+	bool evicted = fdatasync(file) == 0 && posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	close(file);
+	return evicted;
+#else
+	(void)path;
+	return false;
+#endif
+}
+
+// Fraction of the file in the page cache, or -1 where that can't be asked
+static double cachedFraction(const std::filesystem::path& path)
+{
+#ifdef __linux__
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return -1.0;
+	size_t size = (size_t)std::filesystem::file_size(path);
+	void* mapping = size ? mmap(nullptr, size, PROT_READ, MAP_SHARED, file, 0) : MAP_FAILED;
+	close(file);
+	if (mapping == MAP_FAILED)
+		return -1.0;
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	std::vector<unsigned char> resident((size + page - 1) / page);
+	size_t cached = 0;
+	if (mincore(mapping, size, resident.data()) == 0)
+	{
+		for (unsigned char pageResident : resident)
+			cached += pageResident & 1;
+	}
+	munmap(mapping, size);
+	return (double)cached / resident.size();
+#else
+	(void)path;
+	return -1.0;
+#endif
+}
+
+// A grid of size (1000000) triangles written as OBJ text, and the import
+// baked into a .bmesh. Times getting each onto the GPU as a Model: ModelImporter
+// plus Model::Create against Model::LoadBaked mapping and uploading the file.
+// Cold loads come right after dropping the file from the page cache (Linux),
+// or are just the first load after writing it; warm ones are the median of
+// repeated loads. Both have to give the same number of indices.
+static int benchmarkMeshLoad(unsigned int triangles)
+{
+	const unsigned int runs = 5;
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "learnopengl_mesh_load";
+	std::filesystem::create_directories(directory);
+	std::filesystem::path objPath = directory / "grid.obj", bakedPath = directory / "grid.bmesh";
+
+	ModelImporter importer;
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		gridMesh(triangles, vertices, indices);
+		ModelData data;
+		if (!writeGridObj(objPath, vertices, indices) || !importer.Import(objPath.string(), data)
+			|| !WriteBakedMesh(data, bakedPath.string()))
+		{
+			std::cout << "FAILED: can't write the test meshes to " << directory << std::endl;
+			std::filesystem::remove_all(directory);
+			return 1;
+		}
+	}
+
+	TextureLoader loader;
+	TextureCache cache(loader);
+	struct Load
+	{
+		double Milliseconds = 0.0;
+		size_t Indices = 0;
+	};
+	auto countIndices = [](const Model& model)
+	{
+		size_t count = 0;
+		for (const Mesh& mesh : model.Meshes)
+			count += mesh.GetIndexCount();
+		return count;
+	};
+	auto loadObj = [&]()
+	{
+		Load load;
+		auto start = Clock::now();
+		ModelData data;
+		if (importer.Import(objPath.string(), data))
+		{
+			Model model = Model::Create(data, cache);
+			GLCall(glFinish());
+			load.Milliseconds = millisecondsSince(start);
+			load.Indices = countIndices(model);
+		}
+		return load;
+	};
+	auto loadBaked = [&]()
+	{
+		Load load;
+		auto start = Clock::now();
+		Model model;
+		if (Model::LoadBaked(bakedPath.string(), cache, model))
+		{
+			GLCall(glFinish());
+			load.Milliseconds = millisecondsSince(start);
+			load.Indices = countIndices(model);
+		}
+		return load;
+	};
+	auto median = [&](auto&& load)
+	{
+		std::vector<Load> loads;
+		for (unsigned int i = 0; i < runs; i++)
+			loads.push_back(load());
+		std::sort(loads.begin(), loads.end(), [](const Load& a, const Load& b) { return a.Milliseconds < b.Milliseconds; });
+		return loads[runs / 2];
+	};
+
+	bool evicted = evictFromPageCache(objPath) && evictFromPageCache(bakedPath);
+	double objCached = cachedFraction(objPath), bakedCached = cachedFraction(bakedPath);
+	Load objCold = loadObj();
+	Load bakedCold = loadBaked();
+	Load objWarm = median(loadObj);
+	Load bakedWarm = median(loadBaked);
+	double objMB = std::filesystem::file_size(objPath) / (1024.0 * 1024.0);
+	double bakedMB = std::filesystem::file_size(bakedPath) / (1024.0 * 1024.0);
+	std::filesystem::remove_all(directory);
+
+	std::cout << "mesh-load: " << objWarm.Indices / 3 << " triangles, OBJ " << std::fixed << std::setprecision(1) << objMB
+		<< " MB, .bmesh " << bakedMB << " MB" << std::endl;
+	if (evicted && objCached >= 0.0)
+		std::cout << "  cold: dropped from the page cache, " << objCached * 100.0 << "% and " << bakedCached * 100.0
+			<< "% of the files still cached" << std::endl;
+	else
+		std::cout << "  cold: first load after writing, the files may still be cached" << std::endl;
+	std::cout << std::setprecision(2) << std::setw(24) << "" << std::setw(12) << "cold ms" << std::setw(12) << "warm ms"
+		<< "  (median of " << runs << ")" << std::endl
+		<< std::setw(24) << "OBJ import + upload" << std::setw(12) << objCold.Milliseconds << std::setw(12) << objWarm.Milliseconds << std::endl
+		<< std::setw(24) << ".bmesh map + upload" << std::setw(12) << bakedCold.Milliseconds << std::setw(12) << bakedWarm.Milliseconds << std::endl
+		<< std::setw(24) << "speedup" << std::setw(11) << objCold.Milliseconds / bakedCold.Milliseconds << "x"
+		<< std::setw(11) << objWarm.Milliseconds / bakedWarm.Milliseconds << "x" << std::endl << std::defaultfloat;
+
+	if (objWarm.Indices == 0 || objCold.Indices != objWarm.Indices || bakedCold.Indices != objWarm.Indices
+		|| bakedWarm.Indices != objWarm.Indices)
+	{
+		std::cout << "FAILED: the OBJ and .bmesh loads should give the same indices" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+// ========== textures ==========
+
+// Queues size (1000) 256x256 images through TextureCache at once, as a scene
+// naming that many textures would, then draws a quad with each every frame
+// while TextureCache::Update() streams them in: under the default per-frame
+// upload budget and with no budget. Reports the time to the first frame, until
+// every texture has loaded, and the slowest frame. The last frame has to show
+// every texture's color, and evicting them has to drop their loader status.
+static int benchmarkTextures(unsigned int count)
+{
+	const unsigned int size = 256;
+	const unsigned int imageSize = 256;
+	unsigned int side = (unsigned int)std::ceil(std::sqrt((double)count));
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "learnopengl_textures";
+	std::filesystem::create_directories(directory);
+	std::vector<std::string> paths;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		paths.push_back((directory / ("texture" + std::to_string(i) + ".ppm")).string());
+		std::ofstream image(paths.back(), std::ios::binary);
+		image << "P6\n" << imageSize << " " << imageSize << "\n255\n";
+		unsigned char color[3];
+		materialColor(i, color);
+		std::vector<unsigned char> row;
+		for (unsigned int texel = 0; texel < imageSize; texel++)
+			row.insert(row.end(), color, color + 3);
+		for (unsigned int y = 0; y < imageSize; y++)
+			image.write((const char*)row.data(), row.size());
+	}
+
+	Framebuffer target(size, size);
+	GLCall(glViewport(0, 0, size, size));
+	GLCall(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
+	Shader shader("3.3.shader.mesh.vs", "3.3.shader.material.fs");
+	shader.use();
+	shader.setMat4("projection", glm::mat4(1.0f));
+	shader.setMat4("view", glm::mat4(1.0f));
+	shader.setMat4("model", glm::mat4(1.0f));
+
+	struct Result
+	{
+		double FirstFrame = 0.0;
+		double Loaded = 0.0;
+		double SlowestFrame = 0.0;
+		unsigned int Frames = 0;
+		size_t Bytes = 0;
+		unsigned int StatusesLeft = 0; // of the textures evicted at the end
+		std::vector<unsigned char> Pixels;
+	};
+	auto load = [&](size_t uploadBudget)
+	{
+		Result result;
+		TextureLoader loader;
+		TextureCache cache(loader);
+		auto start = Clock::now();
+		std::vector<TextureHandle> handles;
+		std::vector<std::unique_ptr<Mesh>> quads;
+		float cell = 2.0f / side;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			handles.push_back(cache.Acquire(paths[i]));
+			float x = -1.0f + cell * (i % side), y = -1.0f + cell * (i / side);
+			std::vector<Vertex> vertices = {
+				{ glm::vec3(x, y, 0.0f), glm::vec3(0.0f), glm::vec2(0.0f, 0.0f) },
+				{ glm::vec3(x + cell, y, 0.0f), glm::vec3(0.0f), glm::vec2(1.0f, 0.0f) },
+				{ glm::vec3(x + cell, y + cell, 0.0f), glm::vec3(0.0f), glm::vec2(1.0f, 1.0f) },
+				{ glm::vec3(x, y + cell, 0.0f), glm::vec3(0.0f), glm::vec2(0.0f, 1.0f) }
+			};
+			std::vector<Texture> textures = { { handles.back().GetID(), TextureType::Diffuse } };
+			quads.push_back(std::make_unique<Mesh>(std::move(vertices), std::vector<unsigned int>{ 0, 1, 2, 0, 2, 3 }, textures));
+		}
+
+		// The frame that sees the loader idle draws every texture in place
+		bool loaded = false;
+		while (!loaded)
+		{
+			auto frameStart = Clock::now();
+			cache.Update(uploadBudget);
+			loaded = loader.IsIdle();
+			GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+			for (auto& quad : quads)
+				quad->Draw(shader);
+			GLCall(glFinish());
+			result.SlowestFrame = std::max(result.SlowestFrame, millisecondsSince(frameStart));
+			if (result.Frames++ == 0)
+				result.FirstFrame = millisecondsSince(start);
+		}
+		result.Loaded = millisecondsSince(start);
+		result.Pixels = target.ReadPixels();
+		result.Bytes = cache.GetStats().Bytes;
+
+		std::vector<unsigned int> ids;
+		for (const TextureHandle& handle : handles)
+			ids.push_back(handle.GetID());
+		quads.clear();
+		handles.clear();
+		cache.SetMemoryBudget(0);
+		for (unsigned int id : ids)
+		{
+			if (loader.GetStatus(id).bytes > 0)
+				result.StatusesLeft++;
+		}
+		return result;
+	};
+	Result results[2] = { load(8 * 1024 * 1024), load(SIZE_MAX) };
+	std::filesystem::remove_all(directory);
+
+	std::cout << "textures: " << count << " " << imageSize << "x" << imageSize << " images, "
+		<< results[0].Bytes / (1024 * 1024) << " MB with mips" << std::endl << std::fixed << std::setprecision(1)
+		<< std::setw(16) << "" << std::setw(16) << "first frame ms" << std::setw(12) << "loaded ms" << std::setw(8) << "frames"
+		<< std::setw(18) << "slowest frame ms" << std::endl;
+	const char* labels[2] = { "8 MB per frame", "no budget" };
+	for (int i = 0; i < 2; i++)
+	{
+		std::cout << std::setw(16) << labels[i] << std::setw(16) << results[i].FirstFrame << std::setw(12) << results[i].Loaded
+			<< std::setw(8) << results[i].Frames << std::setw(18) << results[i].SlowestFrame << std::endl;
+	}
+	std::cout << std::defaultfloat;
+
+	// Every quad shows its own color once everything is in
+	unsigned int wrongQuads = 0;
+	for (const Result& result : results)
+	{
+		for (unsigned int i = 0; i < count; i++)
+		{
+			unsigned int x = (2 * (i % side) + 1) * size / (2 * side), y = (2 * (i / side) + 1) * size / (2 * side);
+			const unsigned char* pixel = &result.Pixels[((size_t)y * size + x) * 4];
+			unsigned char color[3];
+			materialColor(i, color);
+			for (int c = 0; c < 3; c++)
+			{
+				if (std::abs(pixel[c] - color[c]) > 1)
+				{
+					wrongQuads++;
+					break;
+				}
+			}
+		}
+	}
+	unsigned int statusesLeft = results[0].StatusesLeft + results[1].StatusesLeft;
+	std::cout << "quads with the wrong color: " << wrongQuads << ", statuses left after evicting everything: "
+		<< statusesLeft << std::endl;
+	if (wrongQuads > 0)
+	{
+		std::cout << "FAILED: every texture should show once the loader is idle" << std::endl;
+		return 1;
+	}
+	if (statusesLeft > 0)
+	{
+		std::cout << "FAILED: evicted textures should not keep their TextureLoader status" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+// ========== dispatch ==========
+
+struct BenchmarkMode
+{
+	const char* Name;
+	int (*Run)(unsigned int size);
+	unsigned int DefaultSize;
+};
+
+static const BenchmarkMode MODES[] = {
+	{ "draws", benchmarkDraws, 100000 },
+	{ "uniforms", benchmarkUniforms, 10000 },
+	{ "handles", benchmarkHandles, 100 },
+	{ "load", benchmarkLoad, 2000000 },
+	{ "errors", benchmarkErrors, 10000 },
+	{ "allocations", benchmarkAllocations, 1000 },
+	{ "cull", benchmarkCull, 1000000 },
+	{ "bvh", benchmarkBVH, 10000000 },
+	{ "mips", benchmarkMips, 2048 },
+	{ "binds", benchmarkBinds, 256 },
+	{ "stream", benchmarkStream, 300000 },
+	{ "pool", benchmarkPool, 100000 },
+	{ "mesh-load", benchmarkMeshLoad, 1000000 },
+	{ "textures", benchmarkTextures, 1000 },
+};
+
+int RunBenchmark(const char* name, unsigned int size)
+{
+	for (const BenchmarkMode& mode : MODES)
+	{
+		if (strcmp(mode.Name, name) != 0)
+			continue;
+
+		int result = mode.Run(size > 0 ? size : mode.DefaultSize);
+		// Whatever the mode checks itself, a GL error fails the run too
+		while (GLenum error = glGetError())
+		{
+			std::cout << "[OpenGL Error] (" << error << ") during --bench-" << name << std::endl;
+			result = 1;
+		}
+		return result;
+	}
+
+	std::cout << "Unknown benchmark " << name << ", expected one of:";
+	for (const BenchmarkMode& mode : MODES)
+		std::cout << " " << mode.Name;
+	std::cout << std::endl;
+	return 1;
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+// Measurements and checks of the headless runner. Given --bench-<name> [size],
+// Test.cpp creates a headless context and runs one of these instead of the
+// scene. Each prints its results and returns the process exit code, non-zero
+// when a check fails or GL reported an error, so they can run as tests.
+//
+//   draws     one draw call per object against one instanced draw, for
+//             10^2 objects up to size (100000)
+//   uniforms  time and driver calls of a matrix uniform set for size objects
+//             (10000): looked up each call, cached by name, and by handle
+//   handles   moves size (100) buffers and meshes around, checking that their
+//             GL names stay alive and that each is deleted exactly once
+//   load      load time and peak/remaining resident memory of a mesh of size
+//             (2000000) triangles, copied, moved, moved and released, or
+//             uploaded from a span
+//   errors    frame time of size (10000) per-object draws with GLCall expanded
+//             under each GL_ERROR_CHECK policy
+//   allocations  heap allocations made while drawing two meshes size (1000)
+//             times, switching programs; fails unless there are none. Needs
+//             the counting operator new of the LearnOpenGLTests build
+//   cull      frustum culling of size (1000000) boxes box by box and with
+//             CullingSet, and the draws left of the same-size --meshes grid
+//             along the headless camera path
+//   bvh       BVH build (one thread and all of them), refit and query times
+//             for 10^4 objects up to size (10000000); up to 20000 objects the
+//             queries are checked against testing every box
+//   mips      GenerateMips with SIMD and scalar kernels against glGenerateMipmap
+//             on a size x size (2048) image; the CPU chains have to agree
+//   binds     glBindTexture calls per frame of an imported model of size (256)
+//             quads with a texture each, drawn mesh by mesh and through
+//             RenderQueue, with separate textures and with texture array
+//             layers; both have to render the same image
+//   stream    size (300000) vertices per frame streamed through a StreamBuffer
+//             ring for more frames than it has regions; checks that regions
+//             are only reused once their fence signaled and that the draws
+//             from base vertices match a static buffer, and reports the wait
+//   pool      size (100000) random RangeAllocator allocations and frees checked
+//             against the live ranges, then defragmenting a GeometryPool with
+//             holes; it has to release pages and draw what it drew before
+//   mesh-load  OBJ import against .bmesh map and upload of a size (1000000)
+//             triangle grid, cold (out of the page cache on Linux, else the
+//             first load after writing) and warm
+//   textures  time to the first frame and until size (1000) textures queued
+//             through TextureCache at once have loaded, with the default
+//             per-frame upload budget and without; the last frame has to show
+//             them all, and evicting them has to drop their loader status
+//
+// size 0 picks the default in brackets.
+int RunBenchmark(const char* name, unsigned int size);
+
+class Camera;
+// The fixed camera path of headless runs, in Test.cpp
+void scriptedCamera(Camera& camera, unsigned int frame, unsigned int frameCount);
\ No newline at end of file
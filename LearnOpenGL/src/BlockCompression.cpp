@@ -0,0 +1,274 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOCK_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#define BLOCK_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Endpoints come from the block's bounding box in color space, shrunk a little
+// so the interpolated colors sit closer to the actual pixels, and the indices
+// from projecting each pixel onto the line between the endpoints.
+
+static void blockMinMax(const uint8_t* block, uint8_t minColor[4], uint8_t maxColor[4])
+{
+#if BLOCK_SSE2
+	__m128i p0 = _mm_loadu_si128((const __m128i*)(block + 0));
+	__m128i p1 = _mm_loadu_si128((const __m128i*)(block + 16));
+	__m128i p2 = _mm_loadu_si128((const __m128i*)(block + 32));
+	__m128i p3 = _mm_loadu_si128((const __m128i*)(block + 48));
+	__m128i mn = _mm_min_epu8(_mm_min_epu8(p0, p1), _mm_min_epu8(p2, p3));
+	__m128i mx = _mm_max_epu8(_mm_max_epu8(p0, p1), _mm_max_epu8(p2, p3));
+	// Fold the four pixels in each register down to one
+	mn = _mm_min_epu8(mn, _mm_shuffle_epi32(mn, _MM_SHUFFLE(1, 0, 3, 2)));
+	mn = _mm_min_epu8(mn, _mm_shuffle_epi32(mn, _MM_SHUFFLE(2, 3, 0, 1)));
+	mx = _mm_max_epu8(mx, _mm_shuffle_epi32(mx, _MM_SHUFFLE(1, 0, 3, 2)));
+	mx = _mm_max_epu8(mx, _mm_shuffle_epi32(mx, _MM_SHUFFLE(2, 3, 0, 1)));
+	uint32_t mnBits = (uint32_t)_mm_cvtsi128_si32(mn);
+	uint32_t mxBits = (uint32_t)_mm_cvtsi128_si32(mx);
+	memcpy(minColor, &mnBits, 4);
+	memcpy(maxColor, &mxBits, 4);
+#elif BLOCK_NEON
+	uint8x16x4_t px = vld4q_u8(block);
+	for (int c = 0; c < 4; c++)
+	{
+		minColor[c] = vminvq_u8(px.val[c]);
+		maxColor[c] = vmaxvq_u8(px.val[c]);
+	}
+#else
+	for (int c = 0; c < 4; c++)
+	{
+		minColor[c] = 255;
+		maxColor[c] = 0;
+	}
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			minColor[c] = std::min(minColor[c], block[i * 4 + c]);
+			maxColor[c] = std::max(maxColor[c], block[i * 4 + c]);
+		}
+	}
+#endif
+}
+
+// dots[i] = r * dir[0] + g * dir[1] + b * dir[2] for each of the 16 pixels
+static void projectBlock(const uint8_t* block, const int dir[3], int dots[16])
+{
+#if BLOCK_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i axis = _mm_setr_epi16((short)dir[0], (short)dir[1], (short)dir[2], 0,
+		(short)dir[0], (short)dir[1], (short)dir[2], 0);
+	for (int i = 0; i < 4; i++)
+	{
+		__m128i px = _mm_loadu_si128((const __m128i*)(block + i * 16));
+		// Each madd gives [r*dr + g*dg, b*db] for two pixels; adding the odd and even lanes finishes the dot
+		__m128 lo = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpacklo_epi8(px, zero), axis));
+		__m128 hi = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpackhi_epi8(px, zero), axis));
+		__m128i even = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+		__m128i odd = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+		_mm_storeu_si128((__m128i*)(dots + i * 4), _mm_add_epi32(even, odd));
+	}
+#elif BLOCK_NEON
+	uint8x16x4_t px = vld4q_u8(block);
+	for (int half = 0; half < 2; half++)
+	{
+		int16x8_t r = vreinterpretq_s16_u16(vmovl_u8(half ? vget_high_u8(px.val[0]) : vget_low_u8(px.val[0])));
+		int16x8_t g = vreinterpretq_s16_u16(vmovl_u8(half ? vget_high_u8(px.val[1]) : vget_low_u8(px.val[1])));
+		int16x8_t b = vreinterpretq_s16_u16(vmovl_u8(half ? vget_high_u8(px.val[2]) : vget_low_u8(px.val[2])));
+		int32x4_t lo = vmull_n_s16(vget_low_s16(r), (int16_t)dir[0]);
+		lo = vmlal_n_s16(lo, vget_low_s16(g), (int16_t)dir[1]);
+		lo = vmlal_n_s16(lo, vget_low_s16(b), (int16_t)dir[2]);
+		int32x4_t hi = vmull_n_s16(vget_high_s16(r), (int16_t)dir[0]);
+		hi = vmlal_n_s16(hi, vget_high_s16(g), (int16_t)dir[1]);
+		hi = vmlal_n_s16(hi, vget_high_s16(b), (int16_t)dir[2]);
+		vst1q_s32(dots + half * 8, lo);
+		vst1q_s32(dots + half * 8 + 4, hi);
+	}
+#else
+	for (int i = 0; i < 16; i++)
+		dots[i] = block[i * 4 + 0] * dir[0] + block[i * 4 + 1] * dir[1] + block[i * 4 + 2] * dir[2];
+#endif
+}
+
+static uint16_t packRGB565(const uint8_t* c)
+{
+	return (uint16_t)((((c[0] * 31 + 127) / 255) << 11) | (((c[1] * 63 + 127) / 255) << 5) | ((c[2] * 31 + 127) / 255));
+}
+
+static void unpackRGB565(uint16_t v, int out[3])
+{
+	int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+	out[0] = (r << 3) | (r >> 2);
+	out[1] = (g << 2) | (g >> 4);
+	out[2] = (b << 3) | (b >> 2);
+}
+
+static void encodeColorBlock(const uint8_t* block, uint8_t* out)
+{
+	uint8_t minColor[4], maxColor[4];
+	blockMinMax(block, minColor, maxColor);
+
+	// The box diagonal only follows the colors if they rise together; flip the
+	// red and blue extents when they run against green
+	int center[3] = { (minColor[0] + maxColor[0]) / 2, (minColor[1] + maxColor[1]) / 2, (minColor[2] + maxColor[2]) / 2 };
+	int covRG = 0, covBG = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int g = block[i * 4 + 1] - center[1];
+		covRG += (block[i * 4 + 0] - center[0]) * g;
+		covBG += (block[i * 4 + 2] - center[2]) * g;
+	}
+	if (covRG < 0)
+		std::swap(minColor[0], maxColor[0]);
+	if (covBG < 0)
+		std::swap(minColor[2], maxColor[2]);
+
+	for (int c = 0; c < 3; c++)
+	{
+		int inset = (maxColor[c] - minColor[c]) / 16;
+		maxColor[c] = (uint8_t)(maxColor[c] - inset);
+		minColor[c] = (uint8_t)(minColor[c] + inset);
+	}
+
+	uint16_t color0 = packRGB565(maxColor);
+	uint16_t color1 = packRGB565(minColor);
+	if (color0 < color1)
+		std::swap(color0, color1);
+
+	uint32_t indices = 0;
+	if (color0 != color1)
+	{
+		int c0[3], c1[3];
+		unpackRGB565(color0, c0);
+		unpackRGB565(color1, c1);
+		int dir[3] = { c0[0] - c1[0], c0[1] - c1[1], c0[2] - c1[2] };
+
+		int dots[16];
+		projectBlock(block, dir, dots);
+		int dot1 = c1[0] * dir[0] + c1[1] * dir[1] + c1[2] * dir[2];
+		int dot0 = c0[0] * dir[0] + c0[1] * dir[1] + c0[2] * dir[2];
+
+		// Split the segment into the four palette entries, ordered from color1 to color0
+		static const uint32_t stepToIndex[4] = { 1, 3, 2, 0 };
+		int range = dot0 - dot1;
+		for (int i = 0; i < 16; i++)
+		{
+			int t = ((dots[i] - dot1) * 6 + range) / (2 * range);
+			t = std::clamp(t, 0, 3);
+			indices |= stepToIndex[t] << (i * 2);
+		}
+	}
+
+	memcpy(out + 0, &color0, 2);
+	memcpy(out + 2, &color1, 2);
+	memcpy(out + 4, &indices, 4);
+}
+
+static void encodeAlphaBlock(const uint8_t* block, uint8_t* out)
+{
+	int minAlpha = 255, maxAlpha = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		minAlpha = std::min(minAlpha, (int)block[i * 4 + 3]);
+		maxAlpha = std::max(maxAlpha, (int)block[i * 4 + 3]);
+	}
+	int inset = (maxAlpha - minAlpha) / 32;
+	int alpha0 = maxAlpha - inset;
+	int alpha1 = minAlpha + inset;
+
+	uint64_t indices = 0;
+	if (alpha0 > alpha1)
+	{
+		// Eight-value mode: index 0 is alpha0, 1 is alpha1, 2..7 step from alpha0 towards alpha1
+		int range = alpha0 - alpha1;
+		for (int i = 0; i < 16; i++)
+		{
+			int t = ((block[i * 4 + 3] - alpha1) * 14 + range) / (2 * range);
+			t = std::clamp(t, 0, 7);
+			uint64_t index = t == 7 ? 0 : t == 0 ? 1 : (uint64_t)(8 - t);
+			indices |= index << (i * 3);
+		}
+	}
+
+	out[0] = (uint8_t)alpha0;
+	out[1] = (uint8_t)alpha1;
+	for (int i = 0; i < 6; i++)
+		out[2 + i] = (uint8_t)(indices >> (i * 8));
+}
+
+void CompressBlockBC1(const uint8_t* block, uint8_t* out)
+{
+	encodeColorBlock(block, out);
+}
+
+void CompressBlockBC3(const uint8_t* block, uint8_t* out)
+{
+	encodeAlphaBlock(block, out);
+	encodeColorBlock(block, out + 8);
+}
+
+static void compressRows(BlockFormat format, const uint8_t* rgba, unsigned int width, unsigned int height,
+	unsigned int firstBlockRow, unsigned int lastBlockRow, uint8_t* out)
+{
+	unsigned int blocksWide = (width + 3) / 4;
+	unsigned int blockBytes = BlockBytes(format);
+	alignas(16) uint8_t block[64];
+	for (unsigned int by = firstBlockRow; by < lastBlockRow; by++)
+	{
+		for (unsigned int bx = 0; bx < blocksWide; bx++)
+		{
+			for (unsigned int y = 0; y < 4; y++)
+			{
+				unsigned int sy = std::min(by * 4 + y, height - 1);
+				const uint8_t* row = rgba + (size_t)sy * width * 4;
+				if (bx * 4 + 3 < width)
+					memcpy(block + y * 16, row + bx * 16, 16);
+				else
+				{
+					for (unsigned int x = 0; x < 4; x++)
+						memcpy(block + y * 16 + x * 4, row + std::min(bx * 4 + x, width - 1) * 4, 4);
+				}
+			}
+
+			uint8_t* dst = out + ((size_t)by * blocksWide + bx) * blockBytes;
+			if (format == BlockFormat::BC1)
+				CompressBlockBC1(block, dst);
+			else
+				CompressBlockBC3(block, dst);
+		}
+	}
+}
+
+void CompressImage(BlockFormat format, const uint8_t* rgba, unsigned int width, unsigned int height, uint8_t* out,
+	unsigned int threadCount)
+{
+	unsigned int blockRows = (height + 3) / 4;
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	// Small mip levels aren't worth a thread each
+	threadCount = std::min(threadCount, std::max(1u, blockRows / 16));
+
+	if (threadCount == 1)
+	{
+		compressRows(format, rgba, width, height, 0, blockRows, out);
+		return;
+	}
+
+	std::vector<std::thread> threads;
+	unsigned int rowsPerThread = (blockRows + threadCount - 1) / threadCount;
+	for (unsigned int first = 0; first < blockRows; first += rowsPerThread)
+	{
+		unsigned int last = std::min(blockRows, first + rowsPerThread);
+		threads.emplace_back(compressRows, format, rgba, width, height, first, last, out);
+	}
+	for (std::thread& thread : threads)
+		thread.join();
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// S3TC/DXT block compression of RGBA8 images. Every 4x4 pixel block becomes
+// 8 bytes (BC1, opaque RGB) or 16 bytes (BC3, RGB plus interpolated alpha).
+enum class BlockFormat
+{
+	BC1,
+	BC3
+};
+
+inline unsigned int BlockBytes(BlockFormat format)
+{
+	return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+inline size_t CompressedImageSize(BlockFormat format, unsigned int width, unsigned int height)
+{
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * BlockBytes(format);
+}
+
+// block is 16 RGBA pixels, row by row
+void CompressBlockBC1(const uint8_t* block, uint8_t* out);
+void CompressBlockBC3(const uint8_t* block, uint8_t* out);
+
+// Compresses a tightly packed RGBA8 image into out, which must hold
+// CompressedImageSize() bytes. Edge blocks repeat the last row and column.
+// threadCount 0 uses every hardware thread.
+void CompressImage(BlockFormat format, const uint8_t* rgba, unsigned int width, unsigned int height, uint8_t* out,
+	unsigned int threadCount = 0);
\ No newline at end of file
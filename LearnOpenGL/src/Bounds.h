@@ -0,0 +1,76 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cfloat>
+
+struct Ray
+{
+	glm::vec3 Origin;
+	glm::vec3 Direction; // normalized
+};
+
+// Axis-aligned bounding box. Starts out empty (Min > Max) so Expand can grow it from nothing.
+struct AABB
+{
+	glm::vec3 Min = glm::vec3(FLT_MAX);
+	glm::vec3 Max = glm::vec3(-FLT_MAX);
+
+	AABB() = default;
+	AABB(const glm::vec3& min, const glm::vec3& max)
+		: Min(min), Max(max)
+	{}
+
+	inline bool IsEmpty() const { return Min.x > Max.x || Min.y > Max.y || Min.z > Max.z; }
+	inline glm::vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+	inline glm::vec3 GetExtents() const { return (Max - Min) * 0.5f; }
+
+	inline void Expand(const glm::vec3& point)
+	{
+		Min = glm::min(Min, point);
+		Max = glm::max(Max, point);
+	}
+
+	inline void Expand(const AABB& box)
+	{
+		Min = glm::min(Min, box.Min);
+		Max = glm::max(Max, box.Max);
+	}
+
+	// Box around this one after the transform. The extents go through the
+	// absolute matrix, so it costs one mat3 multiply instead of eight corners.
+	AABB Transformed(const glm::mat4& transform) const
+	{
+		if (IsEmpty())
+			return *this;
+		glm::vec3 center = glm::vec3(transform * glm::vec4(GetCenter(), 1.0f));
+		glm::mat3 absolute(glm::abs(glm::vec3(transform[0])), glm::abs(glm::vec3(transform[1])), glm::abs(glm::vec3(transform[2])));
+		glm::vec3 extents = absolute * GetExtents();
+		return AABB(center - extents, center + extents);
+	}
+
+	// Half the surface area, which is all the SAH needs
+	inline float GetHalfArea() const
+	{
+		glm::vec3 size = Max - Min;
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+
+	inline float DistanceSquared(const glm::vec3& point) const
+	{
+		glm::vec3 offset = glm::max(glm::max(Min - point, point - Max), glm::vec3(0.0f));
+		return glm::dot(offset, offset);
+	}
+
+	// Slab test. inverseDirection is 1 / ray.Direction, worked out once per ray.
+	// On a hit, distance is where the ray enters the box (0 when it starts inside).
+	inline bool Intersects(const Ray& ray, const glm::vec3& inverseDirection, float maxDistance, float& distance) const
+	{
+		glm::vec3 t0 = (Min - ray.Origin) * inverseDirection;
+		glm::vec3 t1 = (Max - ray.Origin) * inverseDirection;
+		glm::vec3 tMin = glm::min(t0, t1), tMax = glm::max(t0, t1);
+		float enter = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+		float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxDistance));
+		distance = enter;
+		return enter <= exit;
+	}
+};
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "Bounds.h"
+
 enum Camera_Movement
 {
 	FORWARD,
@@ -61,6 +63,23 @@ public:
 		return glm::lookAt(Position, Position + Front, Up);
 	}
 
+	glm::mat4 GetProjectionMatrix(float aspect, float nearPlane = 0.1f, float farPlane = 100.0f)
+	{
+		return glm::perspective(glm::radians(Zoom), aspect, nearPlane, farPlane);
+	}
+
+	// World-space ray through a point on the screen, in pixels from the top left
+	Ray GetScreenRay(float x, float y, float width, float height)
+	{
+		glm::vec2 ndc(2.0f * x / width - 1.0f, 1.0f - 2.0f * y / height);
+		glm::mat4 inverse = glm::inverse(GetProjectionMatrix(width / height) * GetViewMatrix());
+		glm::vec4 nearPoint = inverse * glm::vec4(ndc, -1.0f, 1.0f);
+		glm::vec4 farPoint = inverse * glm::vec4(ndc, 1.0f, 1.0f);
+		glm::vec3 start = glm::vec3(nearPoint) / nearPoint.w;
+		glm::vec3 end = glm::vec3(farPoint) / farPoint.w;
+		return { start, glm::normalize(end - start) };
+	}
+
 	void ProcessKeyboard(Camera_Movement direction, float deltaTime)
 	{
 		float velocity = MovementSpeed * deltaTime;
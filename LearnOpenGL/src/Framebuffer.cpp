@@ -0,0 +1,72 @@
+#include "Framebuffer.h"
+
+#include "Renderer.h"
+
+#include <fstream>
+#include <iostream>
+
+Framebuffer::Framebuffer(unsigned int width, unsigned int height)
+	: m_Width(width), m_Height(height)
+{
+	unsigned int id;
+	GLCall(glGenFramebuffers(1, &id));
+	m_Handle.Reset(id);
+	Bind();
+
+	GLCall(glGenRenderbuffers(1, &id));
+	m_Color.Reset(id);
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, id));
+	GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height));
+	GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, id));
+
+	GLCall(glGenRenderbuffers(1, &id));
+	m_Depth.Reset(id);
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, id));
+	GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height));
+	GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, id));
+
+	GLenum status;
+	GLCall(status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::FRAMEBUFFER::INCOMPLETE (" << status << ")" << std::endl;
+}
+
+void Framebuffer::Bind() const
+{
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_Handle.Get()));
+}
+
+void Framebuffer::Unbind() const
+{
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+std::vector<unsigned char> Framebuffer::ReadPixels() const
+{
+	std::vector<unsigned char> pixels((size_t)m_Width * m_Height * 4);
+	GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_Handle.Get()));
+	GLCall(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+	GLCall(glReadPixels(0, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+	return pixels;
+}
+
+bool Framebuffer::SaveImage(const char* path) const
+{
+	std::vector<unsigned char> pixels = ReadPixels();
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "Failed to open " << path << std::endl;
+		return false;
+	}
+	file << "P6\n" << m_Width << " " << m_Height << "\n255\n";
+	// GL rows start at the bottom
+	for (unsigned int y = m_Height; y-- > 0;)
+	{
+		const unsigned char* row = &pixels[(size_t)y * m_Width * 4];
+		for (unsigned int x = 0; x < m_Width; x++)
+			file.write((const char*)&row[x * 4], 3);
+	}
+	return (bool)file;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "GLHandle.h"
+#include <vector>
+
+struct RenderbufferDeleter
+{
+	void operator()(unsigned int id) const { GLCall(glDeleteRenderbuffers(1, &id)); }
+};
+
+struct FramebufferDeleter
+{
+	void operator()(unsigned int id) const { GLCall(glDeleteFramebuffers(1, &id)); }
+};
+
+// Offscreen render target with an RGBA8 color and a 24-bit depth attachment
+class Framebuffer
+{
+public:
+	Framebuffer(unsigned int width, unsigned int height);
+
+	void Bind() const;
+	void Unbind() const;
+
+	// Reads back the color attachment, bottom row first, 4 bytes per pixel
+	std::vector<unsigned char> ReadPixels() const;
+	// Writes the color attachment as a binary PPM, top row first
+	bool SaveImage(const char* path) const;
+
+	inline unsigned int GetWidth() const { return m_Width; }
+	inline unsigned int GetHeight() const { return m_Height; }
+private:
+	GLHandle<FramebufferDeleter> m_Handle;
+	GLHandle<RenderbufferDeleter> m_Color;
+	GLHandle<RenderbufferDeleter> m_Depth;
+	unsigned int m_Width;
+	unsigned int m_Height;
+};
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "Frustum.h"
+
+#include <bit>
+#include <cmath>
+
+#if defined(__AVX__)
+#define CULL_AVX 1
+#include <immintrin.h>
+static constexpr size_t LANES = 8;
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CULL_SSE2 1
+#include <emmintrin.h>
+static constexpr size_t LANES = 4;
+#elif defined(__ARM_NEON)
+#define CULL_NEON 1
+#include <arm_neon.h>
+static constexpr size_t LANES = 4;
+#else
+static constexpr size_t LANES = 4;
+#endif
+
+// Padding boxes: extents so negative that no plane distance reaches zero
+static constexpr float PADDING_EXTENT = -1e30f;
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+	// glm is column-major, so row i of the matrix is m[0][i], m[1][i], ...
+	const glm::mat4& m = viewProjection;
+	glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	m_Planes[Left] = row3 + row0;
+	m_Planes[Right] = row3 - row0;
+	m_Planes[Bottom] = row3 + row1;
+	m_Planes[Top] = row3 - row1;
+	m_Planes[Near] = row3 + row2;
+	m_Planes[Far] = row3 - row2;
+	for (glm::vec4& plane : m_Planes)
+		plane /= glm::length(glm::vec3(plane));
+}
+
+bool Frustum::Intersects(const AABB& box) const
+{
+	glm::vec3 center = box.GetCenter();
+	glm::vec3 extents = box.GetExtents();
+	for (const glm::vec4& plane : m_Planes)
+	{
+		glm::vec3 normal(plane);
+		float distance = glm::dot(normal, center) + plane.w;
+		float radius = glm::dot(glm::abs(normal), extents);
+		if (distance + radius < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+uint32_t CullingSet::Add(const AABB& box)
+{
+	uint32_t index = (uint32_t)m_Count;
+	resize(m_Count + 1);
+	Set(index, box);
+	return index;
+}
+
+void CullingSet::Set(uint32_t index, const AABB& box)
+{
+	glm::vec3 center = box.GetCenter();
+	glm::vec3 extents = box.GetExtents();
+	m_CenterX[index] = center.x;
+	m_CenterY[index] = center.y;
+	m_CenterZ[index] = center.z;
+	m_ExtentX[index] = extents.x;
+	m_ExtentY[index] = extents.y;
+	m_ExtentZ[index] = extents.z;
+}
+
+void CullingSet::Clear()
+{
+	resize(0);
+}
+
+void CullingSet::Reserve(size_t count)
+{
+	size_t padded = (count + LANES - 1) / LANES * LANES;
+	for (std::vector<float>* array : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_ExtentX, &m_ExtentY, &m_ExtentZ })
+		array->reserve(padded);
+}
+
+void CullingSet::resize(size_t count)
+{
+	size_t padded = (count + LANES - 1) / LANES * LANES;
+	for (std::vector<float>* array : { &m_CenterX, &m_CenterY, &m_CenterZ })
+		array->resize(padded, 0.0f);
+	for (std::vector<float>* array : { &m_ExtentX, &m_ExtentY, &m_ExtentZ })
+	{
+		array->resize(padded, PADDING_EXTENT);
+		// A slot that held a real box before shrinking becomes padding again
+		std::fill(array->begin() + count, array->end(), PADDING_EXTENT);
+	}
+	m_Count = count;
+}
+
+// Per plane: distance of each center plus the box's projected radius,
+// dot(|normal|, extents). A box is out once that sum is negative for any plane.
+void CullingSet::Cull(const Frustum& frustum, std::vector<uint32_t>& visible) const
+{
+	visible.clear();
+	float planes[Frustum::PlaneCount][7];
+	for (int i = 0; i < Frustum::PlaneCount; i++)
+	{
+		const glm::vec4& plane = frustum.GetPlane((Frustum::Plane)i);
+		float values[7] = { plane.x, plane.y, plane.z, plane.w, std::fabs(plane.x), std::fabs(plane.y), std::fabs(plane.z) };
+		std::copy(values, values + 7, planes[i]);
+	}
+
+	size_t padded = m_CenterX.size();
+	for (size_t block = 0; block < padded; block += LANES)
+	{
+#if CULL_AVX
+		__m256 cx = _mm256_loadu_ps(&m_CenterX[block]), cy = _mm256_loadu_ps(&m_CenterY[block]), cz = _mm256_loadu_ps(&m_CenterZ[block]);
+		__m256 ex = _mm256_loadu_ps(&m_ExtentX[block]), ey = _mm256_loadu_ps(&m_ExtentY[block]), ez = _mm256_loadu_ps(&m_ExtentZ[block]);
+		unsigned int mask = 0xFF;
+		for (const float* p : planes)
+		{
+			__m256 d = _mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(p[0])), _mm256_set1_ps(p[3]));
+			d = _mm256_add_ps(d, _mm256_mul_ps(cy, _mm256_set1_ps(p[1])));
+			d = _mm256_add_ps(d, _mm256_mul_ps(cz, _mm256_set1_ps(p[2])));
+			d = _mm256_add_ps(d, _mm256_mul_ps(ex, _mm256_set1_ps(p[4])));
+			d = _mm256_add_ps(d, _mm256_mul_ps(ey, _mm256_set1_ps(p[5])));
+			d = _mm256_add_ps(d, _mm256_mul_ps(ez, _mm256_set1_ps(p[6])));
+			mask &= (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_GE_OQ));
+			if (mask == 0)
+				break;
+		}
+#elif CULL_SSE2
+		__m128 cx = _mm_loadu_ps(&m_CenterX[block]), cy = _mm_loadu_ps(&m_CenterY[block]), cz = _mm_loadu_ps(&m_CenterZ[block]);
+		__m128 ex = _mm_loadu_ps(&m_ExtentX[block]), ey = _mm_loadu_ps(&m_ExtentY[block]), ez = _mm_loadu_ps(&m_ExtentZ[block]);
+		unsigned int mask = 0xF;
+		for (const float* p : planes)
+		{
+			__m128 d = _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(p[0])), _mm_set1_ps(p[3]));
+			d = _mm_add_ps(d, _mm_mul_ps(cy, _mm_set1_ps(p[1])));
+			d = _mm_add_ps(d, _mm_mul_ps(cz, _mm_set1_ps(p[2])));
+			d = _mm_add_ps(d, _mm_mul_ps(ex, _mm_set1_ps(p[4])));
+			d = _mm_add_ps(d, _mm_mul_ps(ey, _mm_set1_ps(p[5])));
+			d = _mm_add_ps(d, _mm_mul_ps(ez, _mm_set1_ps(p[6])));
+			mask &= (unsigned int)_mm_movemask_ps(_mm_cmpge_ps(d, _mm_setzero_ps()));
+			if (mask == 0)
+				break;
+		}
+#elif CULL_NEON
+		float32x4_t cx = vld1q_f32(&m_CenterX[block]), cy = vld1q_f32(&m_CenterY[block]), cz = vld1q_f32(&m_CenterZ[block]);
+		float32x4_t ex = vld1q_f32(&m_ExtentX[block]), ey = vld1q_f32(&m_ExtentY[block]), ez = vld1q_f32(&m_ExtentZ[block]);
+		uint32x4_t inside = vdupq_n_u32(0xFFFFFFFF);
+		for (const float* p : planes)
+		{
+			float32x4_t d = vmlaq_n_f32(vdupq_n_f32(p[3]), cx, p[0]);
+			d = vmlaq_n_f32(d, cy, p[1]);
+			d = vmlaq_n_f32(d, cz, p[2]);
+			d = vmlaq_n_f32(d, ex, p[4]);
+			d = vmlaq_n_f32(d, ey, p[5]);
+			d = vmlaq_n_f32(d, ez, p[6]);
+			inside = vandq_u32(inside, vcgeq_f32(d, vdupq_n_f32(0.0f)));
+		}
+		unsigned int mask = (vgetq_lane_u32(inside, 0) & 1) | (vgetq_lane_u32(inside, 1) & 2)
+			| (vgetq_lane_u32(inside, 2) & 4) | (vgetq_lane_u32(inside, 3) & 8);
+#else
+		unsigned int mask = 0;
+		for (size_t lane = 0; lane < LANES; lane++)
+		{
+			size_t i = block + lane;
+			bool inside = true;
+			for (const float* p : planes)
+			{
+				float d = m_CenterX[i] * p[0] + m_CenterY[i] * p[1] + m_CenterZ[i] * p[2] + p[3]
+					+ m_ExtentX[i] * p[4] + m_ExtentY[i] * p[5] + m_ExtentZ[i] * p[6];
+				if (d < 0.0f)
+				{
+					inside = false;
+					break;
+				}
+			}
+			mask |= (unsigned int)inside << lane;
+		}
+#endif
+		while (mask != 0)
+		{
+			visible.push_back((uint32_t)(block + std::countr_zero(mask)));
+			mask &= mask - 1;
+		}
+	}
+}
\ No newline at end of file
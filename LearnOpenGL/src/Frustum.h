@@ -0,0 +1,50 @@
+#pragma once
+#include "Bounds.h"
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// The six planes of a view-projection matrix (Gribb/Hartmann), normalized and
+// facing inwards, so a point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0.
+class Frustum
+{
+public:
+	enum Plane { Left, Right, Bottom, Top, Near, Far, PlaneCount };
+
+	explicit Frustum(const glm::mat4& viewProjection);
+
+	// Conservative: a box crossing two planes outside the corner may still pass
+	bool Intersects(const AABB& box) const;
+
+	inline const glm::vec4& GetPlane(Plane plane) const { return m_Planes[plane]; }
+private:
+	glm::vec4 m_Planes[PlaneCount];
+};
+
+// Boxes stored as separate center/extent arrays, so the frustum test runs on
+// a whole SIMD register of them at once: 8 with AVX, 4 with SSE2 or NEON.
+//
+//   CullingSet set;
+//   uint32_t id = set.Add(mesh.GetBounds().Transformed(model));
+//   set.Cull(Frustum(projection * view), visible);
+class CullingSet
+{
+public:
+	uint32_t Add(const AABB& box);
+	void Set(uint32_t index, const AABB& box);
+	void Clear();
+	void Reserve(size_t count);
+
+	// Replaces visible with the indices of the boxes at least partly inside, in order
+	void Cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+
+	inline size_t GetCount() const { return m_Count; }
+private:
+	// Padded to a whole register with boxes that can never pass
+	std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+	std::vector<float> m_ExtentX, m_ExtentY, m_ExtentZ;
+	size_t m_Count = 0;
+
+	void resize(size_t count);
+};
\ No newline at end of file
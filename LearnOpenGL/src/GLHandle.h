@@ -0,0 +1,78 @@
+#pragma once
+
+#include <glad/glad.h>
+#include "GLStateCache.h"
+#include "Renderer.h"
+
+// Move-only owner of an OpenGL object name. The Deleter is called with the
+// name when the handle is destroyed or reset, never for name 0.
+template<typename Deleter>
+class GLHandle
+{
+public:
+	GLHandle() = default;
+	explicit GLHandle(unsigned int id)
+		: m_ID(id)
+	{}
+	~GLHandle() { Reset(); }
+
+	GLHandle(const GLHandle&) = delete;
+	GLHandle& operator=(const GLHandle&) = delete;
+
+	GLHandle(GLHandle&& other) noexcept
+		: m_ID(other.Release())
+	{}
+	GLHandle& operator=(GLHandle&& other) noexcept
+	{
+		if (this != &other)
+			Reset(other.Release());
+		return *this;
+	}
+
+	inline unsigned int Get() const { return m_ID; }
+	inline explicit operator bool() const { return m_ID != 0; }
+
+	// Gives up ownership without deleting the object
+	unsigned int Release()
+	{
+		unsigned int id = m_ID;
+		m_ID = 0;
+		return id;
+	}
+
+	void Reset(unsigned int id = 0)
+	{
+		if (m_ID != 0)
+			Deleter()(m_ID);
+		m_ID = id;
+	}
+private:
+	unsigned int m_ID = 0;
+};
+
+struct BufferDeleter
+{
+	void operator()(unsigned int id) const
+	{
+		GLStateCache::Get().OnDeleteBuffer(id);
+		GLCall(glDeleteBuffers(1, &id));
+	}
+};
+
+struct VertexArrayDeleter
+{
+	void operator()(unsigned int id) const
+	{
+		GLStateCache::Get().OnDeleteVertexArray(id);
+		GLCall(glDeleteVertexArrays(1, &id));
+	}
+};
+
+struct TextureDeleter
+{
+	void operator()(unsigned int id) const
+	{
+		GLStateCache::Get().OnDeleteTexture(id);
+		GLCall(glDeleteTextures(1, &id));
+	}
+};
\ No newline at end of file
@@ -0,0 +1,236 @@
+#include "GLStateCache.h"
+
+#include "Profiler.h"
+#include "Renderer.h"
+
+GLStateCache& GLStateCache::Get()
+{
+	static GLStateCache cache;
+	return cache;
+}
+
+GLStateCache::GLStateCache()
+{
+	Invalidate();
+}
+
+// Whatever else touched the context, nothing is known until it's set again
+void GLStateCache::Invalidate()
+{
+	m_Program = Unknown;
+	m_VertexArray = Unknown;
+	for (unsigned int& buffer : m_Buffers)
+		buffer = Unknown;
+	m_ActiveUnit = Unknown;
+	for (auto& unit : m_Textures)
+	{
+		for (unsigned int& texture : unit)
+			texture = Unknown;
+	}
+	for (int8_t& capability : m_Capabilities)
+		capability = -1;
+	m_DepthMask = -1;
+	m_BlendSource = Unknown;
+	m_BlendDestination = Unknown;
+	m_RestartIndex = -1;
+}
+
+static inline bool elide()
+{
+	PROFILE_COUNT(StateChangesElided, 1);
+	return false;
+}
+
+bool GLStateCache::UseProgram(unsigned int program)
+{
+	if (m_Program == program)
+		return elide();
+	GLCall(glUseProgram(program));
+	m_Program = program;
+	PROFILE_COUNT(StateChanges, 1);
+	return true;
+}
+
+bool GLStateCache::BindVertexArray(unsigned int vertexArray)
+{
+	if (m_VertexArray == vertexArray)
+		return elide();
+	GLCall(glBindVertexArray(vertexArray));
+	m_VertexArray = vertexArray;
+	m_Buffers[ElementArrayBuffer] = Unknown;
+	PROFILE_COUNT(StateChanges, 1);
+	return true;
+}
+
+bool GLStateCache::BindBuffer(GLenum target, unsigned int buffer)
+{
+	int slot = bufferSlot(target);
+	if (slot >= 0 && m_Buffers[slot] == buffer)
+		return elide();
+	GLCall(glBindBuffer(target, buffer));
+	if (slot >= 0)
+		m_Buffers[slot] = buffer;
+	PROFILE_COUNT(StateChanges, 1);
+	return true;
+}
+
+bool GLStateCache::ActiveTexture(unsigned int unit)
+{
+	if (m_ActiveUnit == unit)
+		return elide();
+	GLCall(glActiveTexture(GL_TEXTURE0 + unit));
+	m_ActiveUnit = unit;
+	PROFILE_COUNT(StateChanges, 1);
+	return true;
+}
+
+bool GLStateCache::BindTexture(GLenum target, unsigned int texture)
+{
+	int slot = textureSlot(target);
+	if (m_ActiveUnit < MaxTextureUnits && slot >= 0)
+	{
+		if (m_Textures[m_ActiveUnit][slot] == texture)
+			return elide();
+		m_Textures[m_ActiveUnit][slot] = texture;
+	}
+	else if (m_ActiveUnit == Unknown && slot >= 0)
+	{
+		// It lands on whichever unit is active, so none of them can be trusted
+		for (auto& unit : m_Textures)
+			unit[slot] = Unknown;
+	}
+	GLCall(glBindTexture(target, texture));
+	PROFILE_COUNT(StateChanges, 1);
+	PROFILE_COUNT(TextureBinds, 1);
+	return true;
+}
+
+bool GLStateCache::BindTexture(unsigned int unit, GLenum target, unsigned int texture)
+{
+	int slot = textureSlot(target);
+	if (unit < MaxTextureUnits && slot >= 0 && m_Textures[unit][slot] == texture)
+		return elide();
+	ActiveTexture(unit);
+	return BindTexture(target, texture);
+}
+
+bool GLStateCache::SetEnabled(GLenum capability, bool enabled)
+{
+	int slot = capabilitySlot(capability);
+	if (slot >= 0 && m_Capabilities[slot] == (int8_t)enabled)
+		return elide();
+	if (enabled)
+	{
+		GLCall(glEnable(capability));
+	}
+	else
+	{
+		GLCall(glDisable(capability));
+	}
+	if (slot >= 0)
+		m_Capabilities[slot] = (int8_t)enabled;
+	PROFILE_COUNT(StateChanges, 1);
+	return true;
+}
+
+bool GLStateCache::DepthMask(bool write)
+{
+	if (m_DepthMask == (int8_t)write)
+		return elide();
+	GLCall(glDepthMask(write ? GL_TRUE : GL_FALSE));
+	m_DepthMask = (int8_t)write;
+	PROFILE_COUNT(StateChanges, 1);
+	return true;
+}
+
+bool GLStateCache::BlendFunc(GLenum source, GLenum destination)
+{
+	if (m_BlendSource == source && m_BlendDestination == destination)
+		return elide();
+	GLCall(glBlendFunc(source, destination));
+	m_BlendSource = source;
+	m_BlendDestination = destination;
+	PROFILE_COUNT(StateChanges, 1);
+	return true;
+}
+
+bool GLStateCache::PrimitiveRestartIndex(unsigned int index)
+{
+	if (m_RestartIndex == (int64_t)index)
+		return elide();
+	GLCall(glPrimitiveRestartIndex(index));
+	m_RestartIndex = index;
+	PROFILE_COUNT(StateChanges, 1);
+	return true;
+}
+
+void GLStateCache::OnDeleteBuffer(unsigned int buffer)
+{
+	for (unsigned int& bound : m_Buffers)
+	{
+		if (bound == buffer)
+			bound = 0;
+	}
+}
+
+void GLStateCache::OnDeleteVertexArray(unsigned int vertexArray)
+{
+	if (m_VertexArray == vertexArray)
+	{
+		m_VertexArray = 0;
+		m_Buffers[ElementArrayBuffer] = Unknown;
+	}
+}
+
+void GLStateCache::OnDeleteTexture(unsigned int texture)
+{
+	for (auto& unit : m_Textures)
+	{
+		for (unsigned int& bound : unit)
+		{
+			if (bound == texture)
+				bound = 0;
+		}
+	}
+}
+
+int GLStateCache::bufferSlot(GLenum target)
+{
+	switch (target)
+	{
+	case GL_ARRAY_BUFFER:         return ArrayBuffer;
+	case GL_ELEMENT_ARRAY_BUFFER: return ElementArrayBuffer;
+	case GL_PIXEL_UNPACK_BUFFER:  return PixelUnpackBuffer;
+	case GL_PIXEL_PACK_BUFFER:    return PixelPackBuffer;
+	case GL_COPY_READ_BUFFER:     return CopyReadBuffer;
+	case GL_COPY_WRITE_BUFFER:    return CopyWriteBuffer;
+	case GL_UNIFORM_BUFFER:       return UniformBuffer;
+	case GL_DRAW_INDIRECT_BUFFER: return DrawIndirectBuffer;
+	}
+	return -1;
+}
+
+int GLStateCache::textureSlot(GLenum target)
+{
+	switch (target)
+	{
+	case GL_TEXTURE_2D:       return Texture2D;
+	case GL_TEXTURE_2D_ARRAY: return Texture2DArray;
+	case GL_TEXTURE_CUBE_MAP: return TextureCubeMap;
+	}
+	return -1;
+}
+
+int GLStateCache::capabilitySlot(GLenum capability)
+{
+	switch (capability)
+	{
+	case GL_DEPTH_TEST:        return DepthTest;
+	case GL_BLEND:             return Blend;
+	case GL_CULL_FACE:         return CullFace;
+	case GL_SCISSOR_TEST:      return ScissorTest;
+	case GL_STENCIL_TEST:      return StencilTest;
+	case GL_PRIMITIVE_RESTART: return PrimitiveRestart;
+	}
+	return -1;
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+
+// Shadow copy of the context's bindings, so redundant binds never reach the
+// driver. Every program, vertex array, buffer and texture bind in the renderer
+// goes through here, as do the capabilities it toggles.
+//
+// Code that changes GL state behind the cache's back (a UI library, a capture
+// tool) must call Invalidate() afterwards; the next call of each kind then
+// always reaches GL. There is one context, so this is a singleton, and like
+// the context it must only be used from the GL thread.
+//
+// The element array buffer binding belongs to the vertex array, so binding a
+// different vertex array forgets it.
+class GLStateCache
+{
+public:
+	static GLStateCache& Get();
+
+	// Each returns true if it had to call into GL
+	bool UseProgram(unsigned int program);
+	bool BindVertexArray(unsigned int vertexArray);
+	bool BindBuffer(GLenum target, unsigned int buffer);
+	bool ActiveTexture(unsigned int unit);
+	// On the active unit, for uploads
+	bool BindTexture(GLenum target, unsigned int texture);
+	// Only switches the active unit if the texture isn't bound there already
+	bool BindTexture(unsigned int unit, GLenum target, unsigned int texture);
+	bool SetEnabled(GLenum capability, bool enabled);
+	bool DepthMask(bool write);
+	bool BlendFunc(GLenum source, GLenum destination);
+	bool PrimitiveRestartIndex(unsigned int index);
+
+	// GL unbinds a deleted object, so the deleters tell the cache
+	void OnDeleteBuffer(unsigned int buffer);
+	void OnDeleteVertexArray(unsigned int vertexArray);
+	void OnDeleteTexture(unsigned int texture);
+
+	void Invalidate();
+
+	static constexpr unsigned int MaxTextureUnits = 32;
+private:
+	GLStateCache();
+	GLStateCache(const GLStateCache&) = delete;
+	GLStateCache& operator=(const GLStateCache&) = delete;
+
+	// Targets and capabilities outside these lists pass straight through
+	enum BufferSlot { ArrayBuffer, ElementArrayBuffer, PixelUnpackBuffer, PixelPackBuffer,
+		CopyReadBuffer, CopyWriteBuffer, UniformBuffer, DrawIndirectBuffer, BufferSlotCount };
+	enum TextureSlot { Texture2D, Texture2DArray, TextureCubeMap, TextureSlotCount };
+	enum CapabilitySlot { DepthTest, Blend, CullFace, ScissorTest, StencilTest, PrimitiveRestart,
+		CapabilitySlotCount };
+
+	static int bufferSlot(GLenum target);
+	static int textureSlot(GLenum target);
+	static int capabilitySlot(GLenum capability);
+
+	static constexpr unsigned int Unknown = 0xFFFFFFFF;
+
+	unsigned int m_Program;
+	unsigned int m_VertexArray;
+	unsigned int m_Buffers[BufferSlotCount];
+	unsigned int m_ActiveUnit;
+	unsigned int m_Textures[MaxTextureUnits][TextureSlotCount];
+	int8_t m_Capabilities[CapabilitySlotCount]; // 0 off, 1 on, -1 unknown
+	int8_t m_DepthMask;
+	GLenum m_BlendSource;
+	GLenum m_BlendDestination;
+	int64_t m_RestartIndex; // -1 unknown, since every unsigned value is a valid index
+};
\ No newline at end of file
@@ -0,0 +1,247 @@
+#include "GeometryPool.h"
+
+#include "GLStateCache.h"
+#include "IndexBuffer.h"
+#include "Profiler.h"
+#include "Renderer.h"
+
+#include <algorithm>
+#include <iterator>
+
+void DrawRange::Draw() const
+{
+	IndexBuffer::ApplyRestartState(Primitive, IndexType);
+	GLCall(glDrawElementsBaseVertex(Primitive, IndexCount, IndexType, (const void*)IndexOffset, BaseVertex));
+}
+
+void DrawRange::DrawInstanced(unsigned int instanceCount) const
+{
+	IndexBuffer::ApplyRestartState(Primitive, IndexType);
+	GLCall(glDrawElementsInstancedBaseVertex(Primitive, IndexCount, IndexType, (const void*)IndexOffset,
+		instanceCount, BaseVertex));
+}
+
+// ========== RangeAllocator ==========
+
+RangeAllocator::RangeAllocator(size_t capacity)
+	: m_Capacity(capacity)
+{
+	if (capacity > 0)
+		insert(0, capacity);
+}
+
+size_t RangeAllocator::Allocate(size_t size)
+{
+	if (size == 0)
+		return 0;
+	auto fit = m_BySize.lower_bound({ size, 0 });
+	if (fit == m_BySize.end())
+		return Fail;
+	auto [available, offset] = *fit;
+	erase(m_ByOffset.find(offset));
+	if (available > size)
+		insert(offset + size, available - size);
+	m_Used += size;
+	return offset;
+}
+
+void RangeAllocator::Free(size_t offset, size_t size)
+{
+	if (size == 0)
+		return;
+	m_Used -= size;
+	auto next = m_ByOffset.lower_bound(offset);
+	if (next != m_ByOffset.end() && offset + size == next->first)
+	{
+		size += next->second;
+		next = erase(next);
+	}
+	if (next != m_ByOffset.begin())
+	{
+		auto previous = std::prev(next);
+		if (previous->first + previous->second == offset)
+		{
+			offset = previous->first;
+			size += previous->second;
+			erase(previous);
+		}
+	}
+	insert(offset, size);
+}
+
+void RangeAllocator::insert(size_t offset, size_t size)
+{
+	m_ByOffset.emplace(offset, size);
+	m_BySize.emplace(size, offset);
+}
+
+std::map<size_t, size_t>::iterator RangeAllocator::erase(std::map<size_t, size_t>::iterator range)
+{
+	m_BySize.erase({ range->second, range->first });
+	return m_ByOffset.erase(range);
+}
+
+// ========== GeometryPool ==========
+
+GeometryPool::GeometryPool(unsigned int pageVertices, unsigned int pageIndexBytes)
+	: m_PageVertices(pageVertices), m_PageIndexBytes(pageIndexBytes)
+{}
+
+GeometryAllocation GeometryPool::Allocate(std::span<const Vertex> vertices, std::span<const unsigned int> indices,
+	GLenum primitive)
+{
+	GLenum type = IndexBuffer::SelectType(IndexBuffer::MaxIndex(indices));
+	if (type == GL_UNSIGNED_INT)
+		return Allocate(vertices, indices.data(), (unsigned int)indices.size(), type, primitive);
+	std::vector<uint8_t> converted(indices.size() * IndexBuffer::TypeSize(type));
+	IndexBuffer::Convert(indices, type, converted.data());
+	return Allocate(vertices, converted.data(), (unsigned int)indices.size(), type, primitive);
+}
+
+GeometryAllocation GeometryPool::Allocate(std::span<const Vertex> vertices, const void* indices, unsigned int indexCount,
+	GLenum indexType, GLenum primitive)
+{
+	uint32_t id;
+	if (!m_FreeIDs.empty())
+	{
+		id = m_FreeIDs.back();
+		m_FreeIDs.pop_back();
+	}
+	else
+	{
+		id = (uint32_t)m_Allocations.size();
+		m_Allocations.emplace_back();
+	}
+
+	Allocation& allocation = m_Allocations[id];
+	size_t indexBytes = (size_t)indexCount * IndexBuffer::TypeSize(indexType);
+	allocation = Allocation();
+	allocation.Range.Primitive = primitive;
+	allocation.Range.IndexType = indexType;
+	allocation.Range.IndexCount = indexCount;
+	allocation.VertexCount = (unsigned int)vertices.size();
+	allocation.IndexUnits = (indexBytes + 3) / 4;
+	allocation.Live = true;
+	place(allocation);
+
+	// Through the copy target, so the upload doesn't disturb any vertex array's element buffer
+	Page& page = m_Pages[allocation.Page];
+	GLStateCache& state = GLStateCache::Get();
+	state.BindBuffer(GL_COPY_WRITE_BUFFER, page.Vertices.GetID());
+	GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)allocation.Range.BaseVertex * sizeof(Vertex),
+		vertices.size_bytes(), vertices.data()));
+	state.BindBuffer(GL_COPY_WRITE_BUFFER, page.Indices.Get());
+	GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.Range.IndexOffset, indexBytes, indices));
+	PROFILE_COUNT(BytesUploaded, vertices.size_bytes() + indexBytes);
+	return GeometryAllocation(this, id);
+}
+
+void GeometryPool::free(uint32_t id)
+{
+	Allocation& allocation = m_Allocations[id];
+	Page& page = m_Pages[allocation.Page];
+	page.VertexSpace.Free(allocation.Range.BaseVertex, allocation.VertexCount);
+	page.IndexSpace.Free(allocation.Range.IndexOffset / 4, allocation.IndexUnits);
+	allocation.Live = false;
+	m_FreeIDs.push_back(id);
+}
+
+GeometryPool::Page& GeometryPool::addPage(size_t vertexCount, size_t indexUnits)
+{
+	size_t vertices = std::max<size_t>(vertexCount, m_PageVertices);
+	size_t units = std::max<size_t>(indexUnits, m_PageIndexBytes / 4);
+
+	unsigned int indexBuffer;
+	GLCall(glGenBuffers(1, &indexBuffer));
+	GLStateCache& state = GLStateCache::Get();
+	state.BindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+	GLCall(glBufferData(GL_COPY_WRITE_BUFFER, units * 4, nullptr, GL_STATIC_DRAW));
+
+	Page& page = m_Pages.emplace_back(Page{ VertexBuffer(nullptr, (unsigned int)(vertices * sizeof(Vertex))),
+		GLHandle<BufferDeleter>(indexBuffer), VertexArray(), RangeAllocator(vertices), RangeAllocator(units) });
+	page.Array.AddBuffer(page.Vertices, VERTEX_LAYOUT);
+	// The element buffer binding is VAO state, so it has to be bound while the VAO is
+	state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	page.Array.Unbind();
+	return page;
+}
+
+void GeometryPool::place(Allocation& allocation)
+{
+	for (uint32_t i = 0; i <= m_Pages.size(); i++)
+	{
+		Page& page = i < m_Pages.size() ? m_Pages[i] : addPage(allocation.VertexCount, allocation.IndexUnits);
+		size_t baseVertex = page.VertexSpace.Allocate(allocation.VertexCount);
+		if (baseVertex == RangeAllocator::Fail)
+			continue;
+		size_t indexUnit = page.IndexSpace.Allocate(allocation.IndexUnits);
+		if (indexUnit == RangeAllocator::Fail)
+		{
+			page.VertexSpace.Free(baseVertex, allocation.VertexCount);
+			continue;
+		}
+		allocation.Page = i;
+		allocation.Range.VertexArray = page.Array.GetID();
+		allocation.Range.BaseVertex = (int)baseVertex;
+		allocation.Range.IndexOffset = indexUnit * 4;
+		return;
+	}
+}
+
+size_t GeometryPool::Defragment()
+{
+	PROFILE_SCOPE("GeometryPool::Defragment");
+	// Keep the current order, so meshes allocated together stay together
+	std::vector<uint32_t> live;
+	for (uint32_t id = 0; id < m_Allocations.size(); id++)
+	{
+		if (m_Allocations[id].Live)
+			live.push_back(id);
+	}
+	std::sort(live.begin(), live.end(), [&](uint32_t a, uint32_t b)
+	{
+		const Allocation& first = m_Allocations[a];
+		const Allocation& second = m_Allocations[b];
+		return first.Page != second.Page ? first.Page < second.Page : first.Range.BaseVertex < second.Range.BaseVertex;
+	});
+
+	std::vector<Page> oldPages;
+	oldPages.swap(m_Pages);
+	GLStateCache& state = GLStateCache::Get();
+	for (uint32_t id : live)
+	{
+		Allocation& allocation = m_Allocations[id];
+		const Page& from = oldPages[allocation.Page];
+		size_t oldBaseVertex = allocation.Range.BaseVertex;
+		size_t oldIndexOffset = allocation.Range.IndexOffset;
+		place(allocation);
+		const Page& to = m_Pages[allocation.Page];
+
+		state.BindBuffer(GL_COPY_READ_BUFFER, from.Vertices.GetID());
+		state.BindBuffer(GL_COPY_WRITE_BUFFER, to.Vertices.GetID());
+		GLCall(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, oldBaseVertex * sizeof(Vertex),
+			(size_t)allocation.Range.BaseVertex * sizeof(Vertex), (size_t)allocation.VertexCount * sizeof(Vertex)));
+		state.BindBuffer(GL_COPY_READ_BUFFER, from.Indices.Get());
+		state.BindBuffer(GL_COPY_WRITE_BUFFER, to.Indices.Get());
+		GLCall(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, oldIndexOffset,
+			allocation.Range.IndexOffset, allocation.IndexUnits * 4));
+	}
+	return oldPages.size() > m_Pages.size() ? oldPages.size() - m_Pages.size() : 0;
+}
+
+GeometryPoolStats GeometryPool::GetStats() const
+{
+	GeometryPoolStats stats;
+	stats.Pages = m_Pages.size();
+	stats.Allocations = m_Allocations.size() - m_FreeIDs.size();
+	for (const Page& page : m_Pages)
+	{
+		stats.VertexCapacity += page.VertexSpace.GetCapacity();
+		stats.VerticesUsed += page.VertexSpace.GetUsed();
+		stats.IndexCapacity += page.IndexSpace.GetCapacity() * 4;
+		stats.IndexBytesUsed += page.IndexSpace.GetUsed() * 4;
+		stats.FreeRanges += page.VertexSpace.GetFreeRangeCount() + page.IndexSpace.GetFreeRangeCount();
+		stats.LargestFreeVertices = std::max(stats.LargestFreeVertices, page.VertexSpace.GetLargestFreeRange());
+	}
+	return stats;
+}
\ No newline at end of file
@@ -0,0 +1,190 @@
+#pragma once
+#include "GLHandle.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "VertexLayout.h"
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <span>
+#include <vector>
+
+// Everything a draw needs from a mesh's geometry, whether the mesh owns its
+// buffers or lives in a GeometryPool
+struct DrawRange
+{
+	unsigned int VertexArray = 0;
+	GLenum Primitive = GL_TRIANGLES;
+	GLenum IndexType = GL_UNSIGNED_INT;
+	unsigned int IndexCount = 0;
+	size_t IndexOffset = 0; // bytes into the vertex array's element buffer
+	int BaseVertex = 0;     // added to every index
+
+	// Sets primitive restart and draws; VertexArray must be bound
+	void Draw() const;
+	void DrawInstanced(unsigned int instanceCount) const;
+};
+
+// Best-fit free list over [0, capacity). Free ranges are kept both by offset,
+// to merge a freed range with its neighbours, and by size, to find the
+// smallest one that fits (the lowest of equal ones); both are O(log ranges).
+class RangeAllocator
+{
+public:
+	static constexpr size_t Fail = SIZE_MAX;
+
+	explicit RangeAllocator(size_t capacity = 0);
+
+	// Offset of size free units, or Fail. Size 0 always succeeds at offset 0.
+	size_t Allocate(size_t size);
+	void Free(size_t offset, size_t size);
+
+	inline size_t GetCapacity() const { return m_Capacity; }
+	inline size_t GetUsed() const { return m_Used; }
+	inline size_t GetFreeRangeCount() const { return m_ByOffset.size(); }
+	inline size_t GetLargestFreeRange() const { return m_BySize.empty() ? 0 : m_BySize.rbegin()->first; }
+private:
+	std::map<size_t, size_t> m_ByOffset;          // offset -> size
+	std::set<std::pair<size_t, size_t>> m_BySize; // (size, offset)
+	size_t m_Capacity = 0;
+	size_t m_Used = 0;
+
+	void insert(size_t offset, size_t size);
+	std::map<size_t, size_t>::iterator erase(std::map<size_t, size_t>::iterator range);
+};
+
+struct GeometryPoolStats
+{
+	size_t Pages = 0;
+	size_t Allocations = 0;
+	size_t VertexCapacity = 0; // vertices
+	size_t VerticesUsed = 0;
+	size_t IndexCapacity = 0;  // bytes
+	size_t IndexBytesUsed = 0;
+	// Holes across all buffers. Unfragmented, each page has at most one free
+	// range per buffer, at its end.
+	size_t FreeRanges = 0;
+	size_t LargestFreeVertices = 0;
+};
+
+class GeometryAllocation;
+
+// Shared vertex and index buffers for meshes of VERTEX_LAYOUT, the format
+// every Mesh uses. Space is handed out of a few large pages, each one vertex
+// buffer, one index buffer and the vertex array over them. A mesh keeps a
+// DrawRange into its page and draws with glDrawElementsBaseVertex, so
+// meshes in the same page draw without switching vertex arrays or buffers,
+// and the driver tracks a handful of buffer objects instead of thousands.
+//
+// Indices stay local to their mesh, so each allocation still gets the
+// smallest index type that holds them (see IndexBuffer); index space is
+// handed out in 4-byte units to keep every type aligned. A mesh bigger than
+// a page gets a page of its own.
+//
+// Freeing leaves holes that later allocations fill best-fit. Defragment()
+// repacks everything when the holes add up. GL thread only, like the
+// buffers; the pool must outlive its allocations.
+class GeometryPool
+{
+public:
+	explicit GeometryPool(unsigned int pageVertices = 1 << 20, unsigned int pageIndexBytes = 16 << 20);
+
+	GeometryPool(const GeometryPool&) = delete;
+	GeometryPool& operator=(const GeometryPool&) = delete;
+
+	// Indices are a triangle list, or strips cut by IndexBuffer::RestartIndex
+	GeometryAllocation Allocate(std::span<const Vertex> vertices, std::span<const unsigned int> indices,
+		GLenum primitive = GL_TRIANGLES);
+	// Indices already converted to indexType (see IndexBuffer::Convert), e.g. from a baked mesh
+	GeometryAllocation Allocate(std::span<const Vertex> vertices, const void* indices, unsigned int indexCount,
+		GLenum indexType, GLenum primitive = GL_TRIANGLES);
+
+	// Valid until the next Allocate or Defragment
+	inline const DrawRange& GetDrawRange(uint32_t id) const { return m_Allocations[id].Range; }
+
+	// Copies every allocation, in order, tightly into as few pages as possible
+	// and releases the old ones. Needs room for both copies while it runs.
+	// Returns how many pages were released.
+	size_t Defragment();
+
+	GeometryPoolStats GetStats() const;
+private:
+	friend class GeometryAllocation;
+
+	struct Page
+	{
+		VertexBuffer Vertices;
+		GLHandle<BufferDeleter> Indices;
+		VertexArray Array;
+		RangeAllocator VertexSpace; // in vertices
+		RangeAllocator IndexSpace;  // in 4-byte units
+	};
+
+	struct Allocation
+	{
+		DrawRange Range;
+		uint32_t Page = 0;
+		unsigned int VertexCount = 0;
+		size_t IndexUnits = 0;
+		bool Live = false;
+	};
+
+	std::vector<Page> m_Pages;
+	std::vector<Allocation> m_Allocations;
+	std::vector<uint32_t> m_FreeIDs;
+	unsigned int m_PageVertices;
+	unsigned int m_PageIndexBytes;
+
+	void free(uint32_t id);
+	Page& addPage(size_t vertexCount, size_t indexUnits);
+	// Places the allocation in the first page with room, adding one if none has
+	void place(Allocation& allocation);
+};
+
+// One allocation in a GeometryPool, freed when destroyed
+class GeometryAllocation
+{
+public:
+	GeometryAllocation() = default;
+	~GeometryAllocation() { Reset(); }
+
+	GeometryAllocation(const GeometryAllocation&) = delete;
+	GeometryAllocation& operator=(const GeometryAllocation&) = delete;
+
+	GeometryAllocation(GeometryAllocation&& other) noexcept
+		: m_Pool(other.m_Pool), m_ID(other.m_ID)
+	{
+		other.m_Pool = nullptr;
+	}
+	GeometryAllocation& operator=(GeometryAllocation&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Reset();
+			m_Pool = other.m_Pool;
+			m_ID = other.m_ID;
+			other.m_Pool = nullptr;
+		}
+		return *this;
+	}
+
+	void Reset()
+	{
+		if (m_Pool)
+			m_Pool->free(m_ID);
+		m_Pool = nullptr;
+	}
+
+	inline explicit operator bool() const { return m_Pool != nullptr; }
+	// Valid until the pool's next Allocate or Defragment
+	inline const DrawRange& GetDrawRange() const { return m_Pool->GetDrawRange(m_ID); }
+private:
+	friend class GeometryPool;
+	GeometryAllocation(GeometryPool* pool, uint32_t id)
+		: m_Pool(pool), m_ID(id)
+	{}
+
+	GeometryPool* m_Pool = nullptr;
+	uint32_t m_ID = 0;
+};
\ No newline at end of file
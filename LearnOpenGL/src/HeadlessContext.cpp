@@ -0,0 +1,133 @@
+#include "HeadlessContext.h"
+
+#include <glad/glad.h>
+#include <iostream>
+
+#ifdef LEARNOPENGL_HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
+#include <GLFW/glfw3.h>
+#endif
+
+HeadlessContext::~HeadlessContext()
+{
+	Destroy();
+}
+
+#ifdef LEARNOPENGL_HEADLESS_EGL
+
+bool HeadlessContext::Create()
+{
+	// Prefer Mesa's surfaceless platform so no X11/Wayland connection is needed
+	EGLDisplay display = EGL_NO_DISPLAY;
+	auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay)
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+	{
+		std::cout << "Failed to initialize EGL" << std::endl;
+		return false;
+	}
+	m_Display = display;
+
+	// The default surface type is a window, which surfaceless displays don't offer
+	const EGLint configAttribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint configCount = 0;
+	if (!eglChooseConfig(display, configAttribs, &config, 1, &configCount) || configCount == 0)
+	{
+		std::cout << "No EGL config supports desktop OpenGL" << std::endl;
+		return false;
+	}
+
+	eglBindAPI(EGL_OPENGL_API);
+	const EGLint contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+	if (context == EGL_NO_CONTEXT)
+	{
+		std::cout << "Failed to create EGL context" << std::endl;
+		return false;
+	}
+	m_Context = context;
+
+	if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		std::cout << "Failed to make the surfaceless EGL context current" << std::endl;
+		return false;
+	}
+
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void HeadlessContext::Destroy()
+{
+	if (!m_Display)
+		return;
+
+	eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (m_Context)
+		eglDestroyContext(m_Display, m_Context);
+	eglTerminate(m_Display);
+	m_Context = nullptr;
+	m_Display = nullptr;
+}
+
+#else
+
+bool HeadlessContext::Create()
+{
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	// The window is never shown; rendering goes to a Framebuffer
+	GLFWwindow* window = glfwCreateWindow(1, 1, "LearnOpenGL (headless)", NULL, NULL);
+	if (!window)
+	{
+		std::cout << "Failed to create hidden GLFW window" << std::endl;
+		glfwTerminate();
+		return false;
+	}
+	m_Window = window;
+	glfwMakeContextCurrent(window);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void HeadlessContext::Destroy()
+{
+	if (!m_Window)
+		return;
+
+	glfwDestroyWindow((GLFWwindow*)m_Window);
+	glfwTerminate();
+	m_Window = nullptr;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+// An OpenGL context with no visible window, for running the renderer on
+// machines without a display (e.g. a build farm using Mesa's llvmpipe).
+//
+// With LEARNOPENGL_HEADLESS_EGL defined the context comes from EGL without any
+// surface (EGL_KHR_surfaceless_context, link against libEGL). Otherwise a hidden
+// GLFW window is used, which still needs a desktop session but no GPU output.
+// Either way, render into a Framebuffer rather than the default framebuffer.
+class HeadlessContext
+{
+public:
+	HeadlessContext() = default;
+	~HeadlessContext();
+
+	HeadlessContext(const HeadlessContext&) = delete;
+	HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+	// Creates a GL 3.3 core context, makes it current and loads GLAD
+	bool Create();
+	void Destroy();
+private:
+	void* m_Display = nullptr;
+	void* m_Context = nullptr;
+	void* m_Window = nullptr;
+};
\ No newline at end of file
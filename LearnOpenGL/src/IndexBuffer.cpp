@@ -1,36 +1,66 @@
 #include "IndexBuffer.h"
 
+#include "GLStateCache.h"
+#include "Profiler.h"
 #include "Renderer.h"
 
-IndexBuffer::IndexBuffer(std::vector<unsigned int> indices)
+#include <vector>
+
+// Each type keeps its largest value back for primitive restart
+static_assert(IndexBuffer::SelectType(0) == GL_UNSIGNED_SHORT);
+static_assert(IndexBuffer::SelectType(254, GL_UNSIGNED_BYTE) == GL_UNSIGNED_BYTE);
+static_assert(IndexBuffer::SelectType(255, GL_UNSIGNED_BYTE) == GL_UNSIGNED_SHORT);
+static_assert(IndexBuffer::SelectType(65534) == GL_UNSIGNED_SHORT);
+static_assert(IndexBuffer::SelectType(65535) == GL_UNSIGNED_INT);
+static_assert(IndexBuffer::SelectType(10, GL_UNSIGNED_INT) == GL_UNSIGNED_INT);
+
+IndexBuffer::IndexBuffer(std::span<const unsigned int> indices, GLenum primitive, GLenum minimumType)
+	: m_Count((unsigned int)indices.size()), m_Type(SelectType(MaxIndex(indices), minimumType)), m_Primitive(primitive)
 {
 	ASSERT(sizeof(unsigned int) == sizeof(GLuint));
-	GLCall(glGenBuffers(1, &m_RendererID));
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
-	GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW));
+	if (m_Type == GL_UNSIGNED_INT)
+	{
+		upload(indices.data());
+		return;
+	}
+	std::vector<uint8_t> converted(GetSize());
+	Convert(indices, m_Type, converted.data());
+	upload(converted.data());
 }
 
-IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count)
-	: m_Count(count)
+IndexBuffer::IndexBuffer(const void* data, unsigned int count, GLenum type, GLenum primitive)
+	: m_Count(count), m_Type(type), m_Primitive(primitive)
 {
-	ASSERT(sizeof(unsigned int) == sizeof(GLuint));
-
-	GLCall(glGenBuffers(1, &m_RendererID));
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
-	GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));
+	upload(data);
 }
 
-IndexBuffer::~IndexBuffer()
+void IndexBuffer::upload(const void* data)
 {
-	GLCall(glDeleteBuffers(1, &m_RendererID));
+	unsigned int id;
+	GLCall(glGenBuffers(1, &id));
+	m_Handle.Reset(id);
+	// Element buffer bindings are vertex array state, so keep this off whichever one is bound
+	GLStateCache::Get().BindVertexArray(0);
+	GLStateCache::Get().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Handle.Get());
+	GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, GetSize(), data, GL_STATIC_DRAW));
+	PROFILE_COUNT(BytesUploaded, GetSize());
 }
 
 void IndexBuffer::Bind() const
 {
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+	GLStateCache::Get().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Handle.Get());
 }
 
 void IndexBuffer::Unbind() const
 {
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+	GLStateCache::Get().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void IndexBuffer::ApplyRestartState(GLenum primitive, GLenum type)
+{
+	GLStateCache& state = GLStateCache::Get();
+	bool strip = primitive == GL_TRIANGLE_STRIP;
+	state.SetEnabled(GL_PRIMITIVE_RESTART, strip);
+	if (strip)
+		state.PrimitiveRestartIndex(TypeRestartIndex(type));
 }
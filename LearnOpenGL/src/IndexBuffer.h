@@ -1,20 +1,95 @@
 #pragma once
+#include "GLHandle.h"
 #include "VertexLayout.h"
-#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <span>
 
+// Indices live on the GPU in the smallest type that holds them: a mesh of
+// fewer than 65535 vertices, which is most of them, takes 16 bits an index
+// instead of 32. The largest value of each type is kept back as its primitive
+// restart index; put RestartIndex in the input to cut a triangle strip there.
 class IndexBuffer
 {
 public:
+	static constexpr unsigned int RestartIndex = 0xFFFFFFFF;
+
 	IndexBuffer() = default;
-	IndexBuffer(std::vector<unsigned int> indices);
-	IndexBuffer(const unsigned int* data, unsigned int count);
-	~IndexBuffer();
+	// 8-bit indices save a few bytes on tiny meshes at best, and some hardware
+	// widens them on every draw, so they are only used if minimumType asks for them
+	IndexBuffer(std::span<const unsigned int> indices, GLenum primitive = GL_TRIANGLES, GLenum minimumType = GL_UNSIGNED_SHORT);
+	// Indices already converted to type (see Convert), e.g. from a baked mesh
+	IndexBuffer(const void* data, unsigned int count, GLenum type, GLenum primitive = GL_TRIANGLES);
+
+	// Owns the GL buffer, so it can be moved but never copied
+	IndexBuffer(const IndexBuffer&) = delete;
+	IndexBuffer& operator=(const IndexBuffer&) = delete;
+	IndexBuffer(IndexBuffer&&) noexcept = default;
+	IndexBuffer& operator=(IndexBuffer&&) noexcept = default;
 
 	void Bind() const;
 	void Unbind() const;
+	// Primitive restart on with the type's restart index for strips, off
+	// otherwise; call before drawing indices of that type
+	static void ApplyRestartState(GLenum primitive, GLenum type);
 
 	inline unsigned int GetCount() const { return m_Count; }
+	inline GLenum GetType() const { return m_Type; }
+	inline GLenum GetPrimitive() const { return m_Primitive; }
+	inline size_t GetSize() const { return (size_t)m_Count * TypeSize(m_Type); }
+
+	// Smallest type, no smaller than minimumType, whose restart index is above maxIndex
+	static constexpr GLenum SelectType(unsigned int maxIndex, GLenum minimumType = GL_UNSIGNED_SHORT)
+	{
+		if (minimumType == GL_UNSIGNED_BYTE && maxIndex < 0xFF)
+			return GL_UNSIGNED_BYTE;
+		if (minimumType != GL_UNSIGNED_INT && maxIndex < 0xFFFF)
+			return GL_UNSIGNED_SHORT;
+		return GL_UNSIGNED_INT;
+	}
+	static constexpr unsigned int TypeSize(GLenum type)
+	{
+		return type == GL_UNSIGNED_BYTE ? 1 : type == GL_UNSIGNED_SHORT ? 2 : 4;
+	}
+	static constexpr unsigned int TypeRestartIndex(GLenum type)
+	{
+		return type == GL_UNSIGNED_BYTE ? 0xFF : type == GL_UNSIGNED_SHORT ? 0xFFFF : RestartIndex;
+	}
+	// Largest index other than RestartIndex
+	static unsigned int MaxIndex(std::span<const unsigned int> indices)
+	{
+		unsigned int max = 0;
+		for (unsigned int index : indices)
+		{
+			if (index != RestartIndex && index > max)
+				max = index;
+		}
+		return max;
+	}
+	// Writes indices to out as type, RestartIndex becoming the type's restart index.
+	// out needs room for indices.size() * TypeSize(type) bytes.
+	static void Convert(std::span<const unsigned int> indices, GLenum type, void* out)
+	{
+		if (type == GL_UNSIGNED_BYTE)
+			narrow((uint8_t*)out, indices);
+		else if (type == GL_UNSIGNED_SHORT)
+			narrow((uint16_t*)out, indices);
+		else
+			std::copy(indices.begin(), indices.end(), (uint32_t*)out);
+	}
 private:
-	unsigned int m_RendererID = 0;
+	GLHandle<BufferDeleter> m_Handle;
 	unsigned int m_Count = 0;
+	GLenum m_Type = GL_UNSIGNED_INT;
+	GLenum m_Primitive = GL_TRIANGLES;
+
+	// RestartIndex truncates to all ones, the narrow type's restart index
+	template<typename T>
+	static void narrow(T* out, std::span<const unsigned int> indices)
+	{
+		for (size_t i = 0; i < indices.size(); i++)
+			out[i] = (T)indices[i];
+	}
+
+	void upload(const void* data);
 };
\ No newline at end of file
@@ -1,47 +1,173 @@
 #include "Mesh.h"
 
-Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures)
+#include "GLStateCache.h"
+
+#include <iostream>
+
+Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures, GLenum primitive)
+	: m_Vertices(std::move(vertices)), m_Indices(std::move(indices)), m_Textures(std::move(textures))
 {
-	this->m_Vertices = vertices;
-	this->m_Indices  = indices;
-	this->m_Textures = textures;
+	for (const Vertex& vertex : m_Vertices)
+		m_Bounds.Expand(vertex.Position);
+	setupMesh(VertexBuffer(m_Vertices), VERTEX_LAYOUT, IndexBuffer(m_Indices, primitive));
+	setupTextures();
+}
 
-	setupMesh();
+Mesh::Mesh(std::span<const Vertex> vertices, IndexBuffer indices, std::vector<Texture> textures, const AABB& bounds)
+	: m_Textures(std::move(textures)), m_Bounds(bounds)
+{
+	setupMesh(VertexBuffer(vertices), VERTEX_LAYOUT, std::move(indices));
+	setupTextures();
+}
+
+Mesh::Mesh(GeometryAllocation geometry, std::vector<Texture> textures, const AABB& bounds)
+	: m_Textures(std::move(textures)), m_Geometry(std::move(geometry)), m_Bounds(bounds)
+{
+	setupTextures();
+}
+
+Mesh::Mesh(const QuantizedMesh& vertices, IndexBuffer indices, std::vector<Texture> textures, const AABB& bounds)
+	: m_Textures(std::move(textures)), m_Bounds(bounds), m_Quantized(true),
+	m_DecodeMin(vertices.BoundsMin), m_DecodeExtent(vertices.BoundsExtent)
+{
+	VertexBuffer vb(vertices.Vertices.data(), (unsigned int)(vertices.Vertices.size() * sizeof(QuantizedVertex)));
+	setupMesh(std::move(vb), QUANTIZED_VERTEX_LAYOUT, std::move(indices));
+	setupTextures();
+}
+
+void Mesh::ReleaseCPUData()
+{
+	std::vector<Vertex>().swap(m_Vertices);
+	std::vector<unsigned int>().swap(m_Indices);
 }
 
 void Mesh::Draw(Shader & shader)
 {
-    unsigned int diffuseNum = 1;
-    unsigned int specularNum = 1;
-    for (unsigned int i = 0; i < m_Textures.size(); i++)
+    bindTextures(shader);
+    BindQuantization(shader);
+
+    // draw mesh
+    DrawRange range = GetDrawRange();
+    GLStateCache::Get().BindVertexArray(range.VertexArray);
+    range.Draw();
+    PROFILE_COUNT(DrawCalls, 1);
+}
+
+void Mesh::AddInstanceBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, unsigned int divisor)
+{
+    ASSERT(!m_Geometry);
+    m_VertexArray->AddBuffer(vb, layout, divisor);
+    m_VertexArray->Unbind();
+}
+
+void Mesh::DrawInstanced(Shader& shader, unsigned int instanceCount)
+{
+    bindTextures(shader);
+    BindQuantization(shader);
+
+    // one draw call for every instance in the bound instance buffers
+    DrawRange range = GetDrawRange();
+    GLStateCache::Get().BindVertexArray(range.VertexArray);
+    range.DrawInstanced(instanceCount);
+    PROFILE_COUNT(DrawCalls, 1);
+}
+
+DrawRange Mesh::GetDrawRange() const
+{
+    if (m_Geometry)
+        return m_Geometry.GetDrawRange();
+    DrawRange range;
+    range.VertexArray = m_VertexArray->GetID();
+    range.Primitive = m_IndexBuffer.GetPrimitive();
+    range.IndexType = m_IndexBuffer.GetType();
+    range.IndexCount = m_IndexBuffer.GetCount();
+    return range;
+}
+
+void Mesh::BindSamplers(Shader& shader)
+{
+    if (shader.ID == m_SamplerShader)
+        return;
+
+    for (TextureBinding& binding : m_TextureBindings)
     {
-        GLCall(glActiveTexture(GL_TEXTURE0 + i)); // activate proper texture unit before binding
-        // retrieve texture number (the N in diffuse_textureN)
-        std::string number;
-        std::string name = m_Textures[i].type;
-        if (name == "texture_diffuse")
-            number = std::to_string(diffuseNum++);
-        else if (name == "texture_specular")
-            number = std::to_string(specularNum++);
-
-        shader.setInt(("material." + name + number).c_str(), i);
-        GLCall(glBindTexture(GL_TEXTURE_2D, m_Textures[i].id));
+        shader.set(shader.getUniformHandle(binding.uniform), (int)binding.unit);
+        if (binding.layer >= 0)
+            binding.layerLocation = shader.getUniformHandle(binding.layerUniform);
     }
-    GLCall(glActiveTexture(GL_TEXTURE0));
+    m_SamplerShader = shader.ID;
+}
 
-    // draw mesh
-    m_VertexArray.Bind();
-    GLCall(glDrawElements(GL_TRIANGLES, m_Indices.size(), GL_UNSIGNED_INT, 0));
-    GLCall(glBindVertexArray(0));
+void Mesh::BindLayers(Shader& shader) const
+{
+    for (const TextureBinding& binding : m_TextureBindings)
+    {
+        if (binding.layer >= 0)
+            shader.set(binding.layerLocation, binding.layer);
+    }
+}
+
+void Mesh::BindQuantization(Shader& shader) const
+{
+    if (!m_Quantized)
+        return;
+
+    static const std::string boundsMin = "boundsMin", boundsExtent = "boundsExtent";
+    shader.set(shader.getUniformHandle(boundsMin), m_DecodeMin);
+    shader.set(shader.getUniformHandle(boundsExtent), m_DecodeExtent);
+}
+
+void Mesh::bindTextures(Shader& shader)
+{
+    BindSamplers(shader);
+    GLStateCache& state = GLStateCache::Get();
+    for (const TextureBinding& binding : m_TextureBindings)
+        state.BindTexture(binding.unit, binding.target, binding.id);
+    BindLayers(shader);
+}
+
+void Mesh::setupTextures()
+{
+    unsigned int counts[(size_t)TextureType::Count] = {};
+    for (const Texture& texture : m_Textures)
+    {
+        unsigned int& count = counts[(size_t)texture.type];
+        if (count == MaxTexturesPerType)
+        {
+            std::cout << "Mesh has more than " << MaxTexturesPerType << " " << TextureTypeName(texture.type)
+                << " textures, ignoring the rest" << std::endl;
+            continue;
+        }
+        unsigned int unit = (unsigned int)texture.type * MaxTexturesPerType + count++;
+        TextureBinding binding = { texture.id, unit,
+            std::string("material.") + TextureTypeName(texture.type) + std::to_string(count) };
+        if (texture.layer >= 0)
+        {
+            // "material.texture_diffuse1" -> "material.layer_diffuse1"
+            binding.target = GL_TEXTURE_2D_ARRAY;
+            binding.layer = texture.layer;
+            binding.layerUniform = "material.layer" + binding.uniform.substr(binding.uniform.find('_'));
+        }
+        m_TextureBindings.push_back(std::move(binding));
+    }
+
+    // FNV-1a over the (texture, unit) pairs
+    m_MaterialKey = 2166136261u;
+    for (const TextureBinding& binding : m_TextureBindings)
+    {
+        m_MaterialKey = (m_MaterialKey ^ binding.id) * 16777619u;
+        m_MaterialKey = (m_MaterialKey ^ binding.unit) * 16777619u;
+    }
 }
 
-void Mesh::setupMesh()
+template<size_t N>
+void Mesh::setupMesh(VertexBuffer vertices, const StaticVertexLayout<N>& layout, IndexBuffer indices)
 {
-	m_VertexBuffer = VertexBuffer(this->m_Vertices);
-	m_IndexBuffer = IndexBuffer(this->m_Indices);
-	m_Layout.Push<float>(3); // Vertex
-	m_Layout.Push<float>(3); // Normals
-	m_Layout.Push<float>(2); // Texture Coords
-	
-	m_VertexArray.AddBuffer(m_VertexBuffer, m_Layout);
+	m_VertexBuffer = std::move(vertices);
+	m_IndexBuffer = std::move(indices);
+	m_VertexArray.emplace();
+	m_VertexArray->AddBuffer(m_VertexBuffer, layout);
+	// The element buffer binding is VAO state, so it has to be bound while the VAO is
+	m_IndexBuffer.Bind();
+	m_VertexArray->Unbind();
 }
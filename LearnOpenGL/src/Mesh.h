@@ -1,12 +1,18 @@
 #pragma once
 #include <glm/glm.hpp>
+#include <cstdint>
+#include <optional>
+#include <span>
 #include <string>
 #include <vector>
+#include "Bounds.h"
+#include "GeometryPool.h"
 #include "Shader.h"
 #include "IndexBuffer.h"
 #include "VertexArray.h"
 #include "VertexBuffer.h"
 #include "VertexLayout.h"
+#include "VertexQuantization.h"
 
 
 class Mesh
@@ -16,15 +22,81 @@ public:
 	std::vector<unsigned int> m_Indices;
 	std::vector<Texture>      m_Textures;
 
-	Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures);
+	// Takes ownership of the geometry; pass rvalues (std::move) to avoid copying it.
+	// Indices form a triangle list, or strips cut by IndexBuffer::RestartIndex.
+	Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures,
+		GLenum primitive = GL_TRIANGLES);
+	// Uploads straight from memory the caller owns (a mapped file, say) without
+	// touching each vertex; m_Vertices/m_Indices stay empty
+	Mesh(std::span<const Vertex> vertices, IndexBuffer indices, std::vector<Texture> textures, const AABB& bounds);
+	// Geometry in a GeometryPool instead of buffers of its own. Pooled meshes
+	// share their page's vertex array, so they can't take instance buffers.
+	Mesh(GeometryAllocation geometry, std::vector<Texture> textures, const AABB& bounds);
+	// Half-size QuantizedVertex data, drawn with 3.3.shader.quantized.vs; m_Vertices stays empty
+	Mesh(const QuantizedMesh& vertices, IndexBuffer indices, std::vector<Texture> textures, const AABB& bounds);
 	void Draw(Shader& shader);
 
+	// Frees m_Vertices/m_Indices once they live on the GPU. Drawing keeps working.
+	void ReleaseCPUData();
+
+	// Per-instance attributes (e.g. a mat4 model matrix) follow the vertex attributes
+	void AddInstanceBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, unsigned int divisor = 1);
+	void DrawInstanced(Shader& shader, unsigned int instanceCount);
+
+	// Each material sampler gets a fixed unit: texture_diffuseN uses unit N - 1,
+	// texture_specularN unit MaxTexturesPerType + N - 1, and so on. Every mesh
+	// agrees on the sampler uniforms, so they only need setting when the shader changes.
+	static constexpr unsigned int MaxTexturesPerType = 4;
+
+	struct TextureBinding
+	{
+		unsigned int id;
+		unsigned int unit;
+		std::string uniform; // "material.texture_diffuse1"
+		GLenum target = GL_TEXTURE_2D;
+		// Texture array layer (see Texture::layer) and its uniform, "material.layer_diffuse1"
+		int layer = -1;
+		std::string layerUniform = {};
+		UniformHandle layerLocation = {};
+	};
+
+	// The pieces of Draw, for callers that order state changes themselves (RenderQueue)
+	void BindSamplers(Shader& shader);
+	// Meshes sharing a texture array differ only in their layers, so these are set every draw
+	void BindLayers(Shader& shader) const;
+	// Sets boundsMin/boundsExtent for the quantized vertex shader; does nothing for other meshes
+	void BindQuantization(Shader& shader) const;
+	inline const std::vector<TextureBinding>& GetTextureBindings() const { return m_TextureBindings; }
+	DrawRange GetDrawRange() const;
+	inline unsigned int GetIndexCount() const { return GetDrawRange().IndexCount; }
+	inline bool IsPooled() const { return (bool)m_Geometry; }
+	inline bool IsQuantized() const { return m_Quantized; }
+	// Equal for meshes with the same textures on the same units
+	inline uint32_t GetMaterialKey() const { return m_MaterialKey; }
+
+	// Model space, computed from the vertices at construction unless given
+	inline const AABB& GetBounds() const { return m_Bounds; }
+
 private:
-	VertexArray m_VertexArray;
+
+	// Either these, or an allocation in a pool
+	std::optional<VertexArray> m_VertexArray;
 	VertexBuffer m_VertexBuffer;
 	IndexBuffer m_IndexBuffer;
+	GeometryAllocation m_Geometry;
 
-	VertexBufferLayout m_Layout;
+	// Built once from m_Textures so drawing allocates nothing
+	std::vector<TextureBinding> m_TextureBindings;
+	unsigned int m_SamplerShader = 0;
+	uint32_t m_MaterialKey = 0;
+	AABB m_Bounds;
+	// Where quantized positions decode to
+	bool m_Quantized = false;
+	glm::vec3 m_DecodeMin = glm::vec3(0.0f);
+	glm::vec3 m_DecodeExtent = glm::vec3(0.0f);
 
-	void setupMesh();
-};
\ No newline at end of file
+	template<size_t N>
+	void setupMesh(VertexBuffer vertices, const StaticVertexLayout<N>& layout, IndexBuffer indices);
+	void setupTextures();
+	void bindTextures(Shader& shader);
+};
@@ -0,0 +1,447 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+static constexpr unsigned int NONE = UINT32_MAX;
+
+// Cache lines the fetch analysis keeps, 4 KB worth
+static constexpr size_t FETCH_CACHE_LINES = 64;
+static constexpr size_t FETCH_LINE_SIZE = 64;
+
+// FIFO cache with timestamps: a vertex is cached if fewer than cacheSize
+// misses happened since it was last loaded. Bumping the clock by
+// cacheSize + 1 empties the whole cache in O(1).
+class VertexCacheModel
+{
+public:
+	VertexCacheModel(size_t vertexCount, unsigned int cacheSize)
+		: m_Loaded(vertexCount, 0), m_Time(cacheSize + 1), m_CacheSize(cacheSize)
+	{}
+
+	// Returns 1 on a miss
+	inline unsigned int Access(unsigned int vertex)
+	{
+		if (m_Time - m_Loaded[vertex] <= m_CacheSize)
+			return 0;
+		m_Loaded[vertex] = m_Time++;
+		return 1;
+	}
+
+	inline void Flush() { m_Time += m_CacheSize + 1; }
+
+	// How long ago (in misses) the vertex was loaded
+	inline unsigned int Age(unsigned int vertex) const { return m_Time - m_Loaded[vertex]; }
+private:
+	std::vector<unsigned int> m_Loaded;
+	unsigned int m_Time;
+	unsigned int m_CacheSize;
+};
+
+VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize)
+{
+	VertexCacheStats stats;
+	VertexCacheModel cache(vertexCount, cacheSize);
+	std::vector<bool> used(vertexCount, false);
+	size_t misses = 0, usedCount = 0;
+	for (unsigned int index : indices)
+	{
+		if (index >= vertexCount)
+			continue;
+		misses += cache.Access(index);
+		if (!used[index])
+		{
+			used[index] = true;
+			usedCount++;
+		}
+	}
+	if (indices.size() >= 3)
+		stats.ACMR = (float)misses / (float)(indices.size() / 3);
+	if (usedCount > 0)
+		stats.ATVR = (float)misses / (float)usedCount;
+	return stats;
+}
+
+float AnalyzeVertexFetch(const std::vector<unsigned int>& indices, size_t vertexCount, size_t vertexSize)
+{
+	size_t lineCount = (vertexCount * vertexSize + FETCH_LINE_SIZE - 1) / FETCH_LINE_SIZE;
+	std::vector<size_t> loaded(lineCount, 0);
+	std::vector<bool> used(vertexCount, false);
+	size_t time = FETCH_CACHE_LINES + 1, bytesFetched = 0, usedCount = 0;
+	for (unsigned int index : indices)
+	{
+		if (index >= vertexCount)
+			continue;
+		if (!used[index])
+		{
+			used[index] = true;
+			usedCount++;
+		}
+		size_t first = index * vertexSize / FETCH_LINE_SIZE;
+		size_t last = ((size_t)index * vertexSize + vertexSize - 1) / FETCH_LINE_SIZE;
+		for (size_t line = first; line <= last; line++)
+		{
+			if (time - loaded[line] > FETCH_CACHE_LINES)
+			{
+				loaded[line] = time++;
+				bytesFetched += FETCH_LINE_SIZE;
+			}
+		}
+	}
+	return usedCount > 0 ? (float)bytesFetched / (float)(usedCount * vertexSize) : 0.0f;
+}
+
+MeshStats AnalyzeMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+	MeshStats stats;
+	stats.VertexCount = vertices.size();
+	stats.TriangleCount = indices.size() / 3;
+	stats.Cache = AnalyzeVertexCache(indices, vertices.size());
+	stats.Overfetch = AnalyzeVertexFetch(indices, vertices.size(), sizeof(Vertex));
+	return stats;
+}
+
+static inline uint32_t hashVertex(const Vertex& vertex)
+{
+	uint32_t words[sizeof(Vertex) / 4];
+	memcpy(words, &vertex, sizeof(words));
+	uint32_t h = 2166136261u;
+	for (uint32_t word : words)
+	{
+		h = (h ^ word) * 16777619u;
+		h ^= h >> 15;
+	}
+	return h;
+}
+
+size_t WeldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	size_t mask = std::bit_ceil(std::max<size_t>(vertices.size() * 2, 16)) - 1;
+	std::vector<unsigned int> table(mask + 1, NONE);
+	std::vector<unsigned int> remap(vertices.size());
+	size_t unique = 0;
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		// Unique vertices are compacted in place, so the table refers to their new slots
+		size_t slot = hashVertex(vertices[i]) & mask;
+		while (table[slot] != NONE && memcmp(&vertices[table[slot]], &vertices[i], sizeof(Vertex)) != 0)
+			slot = (slot + 1) & mask;
+		if (table[slot] == NONE)
+		{
+			vertices[unique] = vertices[i];
+			table[slot] = (unsigned int)unique++;
+		}
+		remap[i] = table[slot];
+	}
+
+	for (unsigned int& index : indices)
+	{
+		if (index < remap.size())
+			index = remap[index];
+	}
+	size_t removed = vertices.size() - unique;
+	vertices.resize(unique);
+	return removed;
+}
+
+void OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize, std::vector<unsigned int>* clusters)
+{
+	if (clusters)
+		clusters->clear();
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	// Triangles around each vertex, and how many of them are still to be emitted
+	std::vector<unsigned int> live(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		live[indices[i]]++;
+	std::vector<unsigned int> offsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++)
+		offsets[v + 1] = offsets[v] + live[v];
+	std::vector<unsigned int> adjacency(triangleCount * 3);
+	{
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < triangleCount * 3; i++)
+			adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+	}
+
+	VertexCacheModel cache(vertexCount, cacheSize);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned int> deadEnds;
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> result;
+	deadEnds.reserve(triangleCount * 3);
+	result.reserve(triangleCount * 3);
+	size_t cursor = 0;
+	unsigned int fan = indices[0];
+	bool restarted = true;
+	while (fan != NONE)
+	{
+		if (restarted && clusters)
+			clusters->push_back((unsigned int)(result.size() / 3));
+
+		// Emit every remaining triangle around the fanning vertex
+		candidates.clear();
+		for (unsigned int i = offsets[fan]; i < offsets[fan + 1]; i++)
+		{
+			unsigned int triangle = adjacency[i];
+			if (emitted[triangle])
+				continue;
+			emitted[triangle] = true;
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				unsigned int vertex = indices[triangle * 3 + corner];
+				result.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				live[vertex]--;
+				cache.Access(vertex);
+			}
+		}
+
+		// Next fan: the oldest candidate that stays cached while its own
+		// triangles are emitted (each can add two new vertices), else any with triangles left
+		fan = NONE;
+		int64_t best = -1;
+		for (unsigned int vertex : candidates)
+		{
+			if (live[vertex] == 0)
+				continue;
+			int64_t priority = 0;
+			if (cache.Age(vertex) + 2 * live[vertex] <= cacheSize)
+				priority = cache.Age(vertex);
+			if (priority > best)
+			{
+				best = priority;
+				fan = vertex;
+			}
+		}
+
+		// Dead end: the most recent vertex with triangles left, else the next one in index order
+		restarted = fan == NONE;
+		while (fan == NONE && !deadEnds.empty())
+		{
+			unsigned int vertex = deadEnds.back();
+			deadEnds.pop_back();
+			if (live[vertex] > 0)
+				fan = vertex;
+		}
+		while (fan == NONE && cursor < vertexCount)
+		{
+			if (live[cursor] > 0)
+				fan = (unsigned int)cursor;
+			cursor++;
+		}
+	}
+	indices.swap(result);
+}
+
+void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices,
+	const std::vector<unsigned int>& clusters, float threshold, unsigned int cacheSize)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0 || clusters.empty())
+		return;
+
+	// Split each cluster as soon as its running ACMR is within threshold of
+	// what the whole cluster achieves, so the pieces cost little cache efficiency
+	VertexCacheModel cache(vertices.size(), cacheSize);
+	std::vector<unsigned int> boundaries;
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		size_t start = clusters[c];
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+		if (start >= end)
+			continue;
+
+		cache.Flush();
+		unsigned int misses = 0;
+		for (size_t i = start * 3; i < end * 3; i++)
+			misses += cache.Access(indices[i]);
+		float target = threshold * (float)misses / (float)(end - start);
+
+		cache.Flush();
+		boundaries.push_back((unsigned int)start);
+		unsigned int runningMisses = 0, runningTriangles = 0;
+		for (size_t t = start; t < end; t++)
+		{
+			for (size_t i = t * 3; i < t * 3 + 3; i++)
+				runningMisses += cache.Access(indices[i]);
+			runningTriangles++;
+			if ((float)runningMisses <= target * (float)runningTriangles)
+			{
+				boundaries.push_back((unsigned int)(t + 1));
+				cache.Flush();
+				runningMisses = runningTriangles = 0;
+			}
+		}
+		// The tail after the last split never reached the target; merge it
+		// into the piece before (this also drops a split at end)
+		if (boundaries.back() != start)
+			boundaries.pop_back();
+	}
+
+	// Outward facing clusters first: sort by how far each cluster lies from
+	// the mesh centroid along its average normal
+	glm::dvec3 meshCentroid(0.0);
+	double meshArea = 0.0;
+	std::vector<glm::dvec3> centroids(boundaries.size(), glm::dvec3(0.0));
+	std::vector<glm::dvec3> normals(boundaries.size(), glm::dvec3(0.0));
+	std::vector<double> areas(boundaries.size(), 0.0);
+	for (size_t c = 0; c < boundaries.size(); c++)
+	{
+		size_t end = c + 1 < boundaries.size() ? boundaries[c + 1] : triangleCount;
+		for (size_t t = boundaries[c]; t < end; t++)
+		{
+			glm::dvec3 a = vertices[indices[t * 3]].Position;
+			glm::dvec3 b = vertices[indices[t * 3 + 1]].Position;
+			glm::dvec3 d = vertices[indices[t * 3 + 2]].Position;
+			glm::dvec3 normal = glm::cross(b - a, d - a);
+			double area = glm::length(normal);
+			centroids[c] += (a + b + d) * (area / 3.0);
+			normals[c] += normal;
+			areas[c] += area;
+		}
+		meshCentroid += centroids[c];
+		meshArea += areas[c];
+	}
+	if (meshArea > 0.0)
+		meshCentroid /= meshArea;
+
+	std::vector<double> keys(boundaries.size(), 0.0);
+	for (size_t c = 0; c < boundaries.size(); c++)
+	{
+		double length = glm::length(normals[c]);
+		if (areas[c] > 0.0 && length > 0.0)
+			keys[c] = glm::dot(centroids[c] / areas[c] - meshCentroid, normals[c] / length);
+	}
+	std::vector<unsigned int> order(boundaries.size());
+	for (size_t c = 0; c < order.size(); c++)
+		order[c] = (unsigned int)c;
+	std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return keys[a] > keys[b]; });
+
+	std::vector<unsigned int> result;
+	result.reserve(triangleCount * 3);
+	for (unsigned int c : order)
+	{
+		size_t end = c + 1 < boundaries.size() ? boundaries[c + 1] : triangleCount;
+		result.insert(result.end(), indices.begin() + boundaries[c] * 3, indices.begin() + end * 3);
+	}
+	indices.swap(result);
+}
+
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	std::vector<unsigned int> remap(vertices.size(), NONE);
+	std::vector<Vertex> result;
+	result.reserve(vertices.size());
+	for (unsigned int& index : indices)
+	{
+		if (remap[index] == NONE)
+		{
+			remap[index] = (unsigned int)result.size();
+			result.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	vertices.swap(result);
+}
+
+MeshOptimizerStats OptimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	MeshOptimizerStats stats;
+	stats.Before = AnalyzeMesh(vertices, indices);
+	indices.resize(indices.size() - indices.size() % 3);
+	WeldVertices(vertices, indices);
+	std::vector<unsigned int> clusters;
+	OptimizeVertexCache(indices, vertices.size(), VERTEX_CACHE_SIZE, &clusters);
+	OptimizeOverdraw(indices, vertices, clusters);
+	OptimizeVertexFetch(vertices, indices);
+	stats.After = AnalyzeMesh(vertices, indices);
+	return stats;
+}
+
+// Triangles the strip generator looks ahead over for one that continues the strip
+static constexpr size_t STRIP_LOOKAHEAD = 16;
+
+// Third vertex of triangle t if it has the directed edge from -> to, NONE otherwise
+static inline unsigned int stripNext(const unsigned int* t, unsigned int from, unsigned int to)
+{
+	for (int r = 0; r < 3; r++)
+	{
+		if (t[r] == from && t[(r + 1) % 3] == to)
+			return t[(r + 2) % 3];
+	}
+	return NONE;
+}
+
+std::vector<unsigned int> GenerateTriangleStrips(const std::vector<unsigned int>& indices)
+{
+	size_t triangleCount = indices.size() / 3;
+	std::vector<unsigned int> strip;
+	strip.reserve(indices.size());
+
+	unsigned int buffer[STRIP_LOOKAHEAD][3];
+	size_t buffered = 0, next = 0;
+	// Last two vertices of the current strip and how many triangles it has
+	unsigned int a = 0, b = 0;
+	size_t length = 0;
+	while (true)
+	{
+		for (; buffered < STRIP_LOOKAHEAD && next < triangleCount; next++, buffered++)
+			memcpy(buffer[buffered], &indices[next * 3], sizeof(buffer[0]));
+		if (buffered == 0)
+			break;
+
+		// Strip triangle k is (v[k], v[k+1], v[k+2]), flipped for odd k to keep the winding
+		size_t found = NONE;
+		if (length > 0)
+		{
+			unsigned int from = length % 2 == 0 ? a : b, to = length % 2 == 0 ? b : a;
+			for (size_t i = 0; i < buffered && found == NONE; i++)
+			{
+				unsigned int c = stripNext(buffer[i], from, to);
+				if (c != NONE)
+				{
+					strip.push_back(c);
+					a = b;
+					b = c;
+					length++;
+					found = i;
+				}
+			}
+		}
+
+		if (found == NONE)
+		{
+			// Start over from the oldest triangle, rotated so the strip can leave
+			// through an edge some other buffered triangle shares
+			const unsigned int* t = buffer[0];
+			int rotation = -1;
+			for (int r = 0; r < 3 && rotation < 0; r++)
+			{
+				unsigned int y = t[(r + 1) % 3], z = t[(r + 2) % 3];
+				for (size_t i = 1; i < buffered && rotation < 0; i++)
+				{
+					if (stripNext(buffer[i], z, y) != NONE)
+						rotation = r;
+				}
+			}
+			rotation = std::max(rotation, 0);
+			if (!strip.empty())
+				strip.push_back(STRIP_RESTART_INDEX);
+			strip.insert(strip.end(), { t[rotation], t[(rotation + 1) % 3], t[(rotation + 2) % 3] });
+			a = t[(rotation + 1) % 3];
+			b = t[(rotation + 2) % 3];
+			length = 1;
+			found = 0;
+		}
+
+		memmove(buffer[found], buffer[found + 1], (buffered - found - 1) * sizeof(buffer[0]));
+		buffered--;
+	}
+	return strip;
+}
\ No newline at end of file
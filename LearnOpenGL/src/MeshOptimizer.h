@@ -0,0 +1,84 @@
+#pragma once
+#include "VertexLayout.h"
+
+#include <cstddef>
+#include <vector>
+
+// Reordering of indexed triangle lists for the GPU. None of it changes what
+// is drawn, only the order vertices are stored and triangles are submitted in:
+//
+//   WeldVertices         merges vertices that are bitwise identical
+//   OptimizeVertexCache  Tipsify (Sander et al. 2007): fans triangles around
+//                        recently used vertices so the post-transform cache
+//                        hits more often, in linear time
+//   OptimizeOverdraw     splits that order into clusters where it costs little
+//                        cache efficiency and draws outward facing clusters
+//                        first, so the depth test rejects more of what follows
+//   OptimizeVertexFetch  stores vertices in the order the indices first use
+//                        them, so fetches walk memory forward
+//
+// GenerateTriangleStrips then turns a list into strips joined by primitive
+// restarts, for meshes where that takes fewer indices.
+//
+// OptimizeMesh runs all four. It is meant for import time or offline
+// (MeshConverter), not per frame: everything is O(triangles) but allocates.
+
+// Post-transform cache modelled as a FIFO of this many vertices, a fair
+// middle ground between older hardware and what modern GPUs behave like
+constexpr unsigned int VERTEX_CACHE_SIZE = 16;
+
+// Separates strips; the same value as IndexBuffer::RestartIndex
+constexpr unsigned int STRIP_RESTART_INDEX = 0xFFFFFFFF;
+
+struct VertexCacheStats
+{
+	float ACMR = 0.0f; // transformed vertices per triangle: 0.5 at best for big grids, 3 at worst
+	float ATVR = 0.0f; // transformed vertices per vertex: 1 is ideal
+};
+
+struct MeshStats
+{
+	size_t VertexCount = 0;
+	size_t TriangleCount = 0;
+	VertexCacheStats Cache;
+	float Overfetch = 0.0f; // bytes of vertex memory read per byte of vertex data, 1 is ideal
+};
+
+struct MeshOptimizerStats
+{
+	MeshStats Before;
+	MeshStats After;
+};
+
+// Simulates the FIFO cache over the triangle list
+VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount,
+	unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// Simulates 64-byte cache lines over vertex reads, with room for a few KB of lines
+float AnalyzeVertexFetch(const std::vector<unsigned int>& indices, size_t vertexCount, size_t vertexSize);
+
+MeshStats AnalyzeMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+
+// Returns how many vertices were removed
+size_t WeldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+// clusters, if given, receives the first triangle of every run that had to
+// restart away from the previous one: the boundaries OptimizeOverdraw may reorder at
+void OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount,
+	unsigned int cacheSize = VERTEX_CACHE_SIZE, std::vector<unsigned int>* clusters = nullptr);
+
+// indices must come from OptimizeVertexCache with the same clusters. threshold
+// is how much worse than each cluster's own ACMR a split may make it: 1.05 allows 5%.
+void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices,
+	const std::vector<unsigned int>& clusters, float threshold = 1.05f, unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// Drops vertices no triangle uses
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+MeshOptimizerStats OptimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+// Greedy: each strip continues with whichever of the next few triangles shares
+// its last edge with matching winding, so the list order (and with it the
+// vertex cache behaviour) is mostly kept. Triangles that connect to nothing cost
+// four indices instead of three, so compare sizes before using the result.
+std::vector<unsigned int> GenerateTriangleStrips(const std::vector<unsigned int>& indices);
\ No newline at end of file
@@ -0,0 +1,368 @@
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIP_SSE2 1
+#include <emmintrin.h>
+#if defined(__AVX__)
+#define MIP_AVX 1
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON)
+#define MIP_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Working texels are four floats: linear color (premultiplied when the image
+// has alpha and options ask for it) followed by alpha. Each kernel works on
+// one texel at a time; MipOptions::simd picks between them.
+struct ScalarKernel
+{
+	struct Texel { float v[4]; };
+	static inline Texel zero() { return { { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+	static inline Texel load(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+	static inline void store(float* p, Texel t) { std::copy(t.v, t.v + 4, p); }
+	static inline Texel mulAdd(Texel acc, Texel t, float w)
+	{
+		for (int i = 0; i < 4; i++)
+			acc.v[i] += t.v[i] * w;
+		return acc;
+	}
+	static inline Texel average4(Texel a, Texel b, Texel c, Texel d)
+	{
+		for (int i = 0; i < 4; i++)
+			a.v[i] = (a.v[i] + b.v[i] + c.v[i] + d.v[i]) * 0.25f;
+		return a;
+	}
+};
+
+#if MIP_SSE2
+struct VectorKernel
+{
+	typedef __m128 Texel;
+	static inline Texel zero() { return _mm_setzero_ps(); }
+	static inline Texel load(const float* p) { return _mm_loadu_ps(p); }
+	static inline void store(float* p, Texel t) { _mm_storeu_ps(p, t); }
+	static inline Texel mulAdd(Texel acc, Texel t, float w) { return _mm_add_ps(acc, _mm_mul_ps(t, _mm_set1_ps(w))); }
+	static inline Texel average4(Texel a, Texel b, Texel c, Texel d)
+	{
+		return _mm_mul_ps(_mm_add_ps(_mm_add_ps(a, b), _mm_add_ps(c, d)), _mm_set1_ps(0.25f));
+	}
+};
+#elif MIP_NEON
+struct VectorKernel
+{
+	typedef float32x4_t Texel;
+	static inline Texel zero() { return vdupq_n_f32(0.0f); }
+	static inline Texel load(const float* p) { return vld1q_f32(p); }
+	static inline void store(float* p, Texel t) { vst1q_f32(p, t); }
+	static inline Texel mulAdd(Texel acc, Texel t, float w) { return vmlaq_n_f32(acc, t, w); }
+	static inline Texel average4(Texel a, Texel b, Texel c, Texel d)
+	{
+		return vmulq_n_f32(vaddq_f32(vaddq_f32(a, b), vaddq_f32(c, d)), 0.25f);
+	}
+};
+#else
+typedef ScalarKernel VectorKernel;
+#endif
+
+static constexpr unsigned int FROM_LINEAR_SIZE = 16384; // fine enough to resolve the darkest sRGB steps
+
+struct ColorTables
+{
+	float srgbToLinear[256];
+	float unormToFloat[256];
+	uint8_t linearToSrgb[FROM_LINEAR_SIZE];
+
+	ColorTables()
+	{
+		for (int i = 0; i < 256; i++)
+		{
+			float c = i / 255.0f;
+			srgbToLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			unormToFloat[i] = c;
+		}
+		for (unsigned int i = 0; i < FROM_LINEAR_SIZE; i++)
+		{
+			float l = (float)i / (FROM_LINEAR_SIZE - 1);
+			float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+			linearToSrgb[i] = (uint8_t)std::clamp((int)(c * 255.0f + 0.5f), 0, 255);
+		}
+	}
+};
+
+static const ColorTables& colorTables()
+{
+	static const ColorTables tables;
+	return tables;
+}
+
+struct ChannelLayout
+{
+	unsigned int colorCount;
+	int alphaIndex; // -1 without alpha
+};
+
+static ChannelLayout channelLayout(unsigned int channels)
+{
+	switch (channels)
+	{
+	case 1: return { 1, -1 };
+	case 2: return { 1, 1 };
+	case 3: return { 3, -1 };
+	default: return { 3, 3 };
+	}
+}
+
+// Source texels overlapping one destination texel along an axis, weighted by coverage
+struct Taps
+{
+	unsigned int first;
+	unsigned int count;
+	float weights[3];
+};
+
+static std::vector<Taps> computeTaps(unsigned int srcSize, unsigned int dstSize)
+{
+	std::vector<Taps> taps(dstSize);
+	double scale = (double)srcSize / dstSize;
+	for (unsigned int i = 0; i < dstSize; i++)
+	{
+		double lo = i * scale, hi = (i + 1) * scale;
+		Taps& t = taps[i];
+		t.first = (unsigned int)lo;
+		unsigned int last = std::min(srcSize, (unsigned int)std::ceil(hi - 1e-9));
+		t.count = std::min(3u, last - t.first);
+		for (unsigned int j = 0; j < t.count; j++)
+		{
+			double overlap = std::min(hi, (double)(t.first + j + 1)) - std::max(lo, (double)(t.first + j));
+			t.weights[j] = (float)(overlap / scale);
+		}
+	}
+	return taps;
+}
+
+static void decodeRow(const uint8_t* src, unsigned int width, unsigned int channels, const MipOptions& options, float* out)
+{
+	const ColorTables& tables = colorTables();
+	const float* toLinear = options.srgb ? tables.srgbToLinear : tables.unormToFloat;
+	ChannelLayout layout = channelLayout(channels);
+	bool premultiply = options.premultiplyAlpha && layout.alphaIndex >= 0;
+	for (unsigned int x = 0; x < width; x++, src += channels, out += 4)
+	{
+		float alpha = layout.alphaIndex >= 0 ? tables.unormToFloat[src[layout.alphaIndex]] : 1.0f;
+		float scale = premultiply ? alpha : 1.0f;
+		out[0] = toLinear[src[0]] * scale;
+		out[1] = layout.colorCount > 1 ? toLinear[src[1]] * scale : 0.0f;
+		out[2] = layout.colorCount > 2 ? toLinear[src[2]] * scale : 0.0f;
+		out[3] = alpha;
+	}
+}
+
+// One row of the even-size 2x2 average. With AVX the vector kernel does two
+// destination texels per register: the four source texels of a row pair up
+// as [t0, t2] + [t1, t3].
+template<typename Kernel>
+static void averageRows(const float* row0, const float* row1, unsigned int dstWidth, float* out)
+{
+	unsigned int x = 0;
+#if MIP_AVX
+	if constexpr (std::is_same_v<Kernel, VectorKernel>)
+	{
+		const __m256 quarter = _mm256_set1_ps(0.25f);
+		for (; x + 2 <= dstWidth; x += 2, row0 += 16, row1 += 16, out += 8)
+		{
+			__m256 a0 = _mm256_loadu_ps(row0), b0 = _mm256_loadu_ps(row0 + 8);
+			__m256 a1 = _mm256_loadu_ps(row1), b1 = _mm256_loadu_ps(row1 + 8);
+			__m256 even = _mm256_add_ps(_mm256_permute2f128_ps(a0, b0, 0x20), _mm256_permute2f128_ps(a1, b1, 0x20));
+			__m256 odd = _mm256_add_ps(_mm256_permute2f128_ps(a0, b0, 0x31), _mm256_permute2f128_ps(a1, b1, 0x31));
+			_mm256_storeu_ps(out, _mm256_mul_ps(_mm256_add_ps(even, odd), quarter));
+		}
+	}
+#endif
+	for (; x < dstWidth; x++, row0 += 8, row1 += 8, out += 4)
+		Kernel::store(out, Kernel::average4(Kernel::load(row0), Kernel::load(row0 + 4), Kernel::load(row1), Kernel::load(row1 + 4)));
+}
+
+template<typename Kernel, typename GetRow>
+static void downsample(GetRow getRow, unsigned int srcWidth, unsigned int srcHeight, unsigned int dstWidth, unsigned int dstHeight,
+	float* dst)
+{
+	// Even sizes are the common case and always a plain 2x2 average
+	if (srcWidth == dstWidth * 2 && srcHeight == dstHeight * 2)
+	{
+		for (unsigned int y = 0; y < dstHeight; y++)
+		{
+			averageRows<Kernel>(getRow(y * 2), getRow(y * 2 + 1), dstWidth, dst + (size_t)y * dstWidth * 4);
+		}
+		return;
+	}
+
+	std::vector<Taps> xTaps = computeTaps(srcWidth, dstWidth);
+	std::vector<Taps> yTaps = computeTaps(srcHeight, dstHeight);
+	for (unsigned int y = 0; y < dstHeight; y++)
+	{
+		const Taps& ty = yTaps[y];
+		const float* rows[3];
+		for (unsigned int i = 0; i < ty.count; i++)
+			rows[i] = getRow(ty.first + i);
+
+		for (unsigned int x = 0; x < dstWidth; x++)
+		{
+			const Taps& tx = xTaps[x];
+			typename Kernel::Texel sum = Kernel::zero();
+			for (unsigned int i = 0; i < ty.count; i++)
+			{
+				const float* row = rows[i] + tx.first * 4;
+				for (unsigned int j = 0; j < tx.count; j++)
+					sum = Kernel::mulAdd(sum, Kernel::load(row + j * 4), ty.weights[i] * tx.weights[j]);
+			}
+			Kernel::store(dst + ((size_t)y * dstWidth + x) * 4, sum);
+		}
+	}
+}
+
+// Texels as 8-bit values: color through the sRGB table (or scaled to 255), alpha scaled to 255
+template<typename Kernel>
+static void quantizeTexels(const float* texels, size_t count, bool unpremultiply, bool srgb, int* out)
+{
+	float colorScale = srgb ? (float)(FROM_LINEAR_SIZE - 1) : 255.0f;
+	size_t i = 0;
+#if MIP_SSE2
+	if constexpr (std::is_same_v<Kernel, VectorKernel>)
+	{
+#if MIP_AVX
+		const __m256 zero8 = _mm256_setzero_ps();
+		const __m256 one8 = _mm256_set1_ps(1.0f);
+		const __m256 half8 = _mm256_set1_ps(0.5f);
+		const __m256 scale8 = _mm256_setr_ps(colorScale, colorScale, colorScale, 255.0f, colorScale, colorScale, colorScale, 255.0f);
+		const __m256 alphaLanes = _mm256_castsi256_ps(_mm256_setr_epi32(0, 0, 0, -1, 0, 0, 0, -1));
+		for (; i + 2 <= count; i += 2)
+		{
+			__m256 t = _mm256_loadu_ps(texels + i * 4);
+			if (unpremultiply)
+			{
+				__m256 alpha = _mm256_shuffle_ps(t, t, _MM_SHUFFLE(3, 3, 3, 3));
+				__m256 inverse = _mm256_and_ps(_mm256_cmp_ps(alpha, zero8, _CMP_GT_OQ), _mm256_div_ps(one8, alpha));
+				t = _mm256_blendv_ps(_mm256_mul_ps(t, inverse), t, alphaLanes);
+			}
+			t = _mm256_min_ps(_mm256_max_ps(t, zero8), one8);
+			_mm256_storeu_si256((__m256i*)(out + i * 4), _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(t, scale8), half8)));
+		}
+#endif
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 scale = _mm_setr_ps(colorScale, colorScale, colorScale, 255.0f);
+		const __m128 alphaLane = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+		for (; i < count; i++)
+		{
+			__m128 t = _mm_loadu_ps(texels + i * 4);
+			if (unpremultiply)
+			{
+				__m128 alpha = _mm_shuffle_ps(t, t, _MM_SHUFFLE(3, 3, 3, 3));
+				__m128 inverse = _mm_and_ps(_mm_cmpgt_ps(alpha, zero), _mm_div_ps(one, alpha));
+				__m128 color = _mm_mul_ps(t, inverse);
+				t = _mm_or_ps(_mm_andnot_ps(alphaLane, color), _mm_and_ps(alphaLane, t));
+			}
+			t = _mm_min_ps(_mm_max_ps(t, zero), one);
+			_mm_storeu_si128((__m128i*)(out + i * 4), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(t, scale), half)));
+		}
+	}
+#endif
+	for (; i < count; i++)
+	{
+		const float* t = texels + i * 4;
+		float inverse = unpremultiply && t[3] > 0.0f ? 1.0f / t[3] : 1.0f;
+		for (int c = 0; c < 3; c++)
+			out[i * 4 + c] = (int)(std::clamp(t[c] * inverse, 0.0f, 1.0f) * colorScale + 0.5f);
+		out[i * 4 + 3] = (int)(std::clamp(t[3], 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+}
+
+template<typename Kernel>
+static void encodeLevel(const float* texels, size_t count, unsigned int channels, const MipOptions& options, uint8_t* out)
+{
+	const ColorTables& tables = colorTables();
+	ChannelLayout layout = channelLayout(channels);
+	bool unpremultiply = options.premultiplyAlpha && layout.alphaIndex >= 0;
+
+	// Quantize in batches so the integer scratch stays small
+	int quantized[256 * 4];
+	for (size_t start = 0; start < count; start += 256)
+	{
+		size_t batch = std::min<size_t>(256, count - start);
+		quantizeTexels<Kernel>(texels + start * 4, batch, unpremultiply, options.srgb, quantized);
+		for (size_t i = 0; i < batch; i++, out += channels)
+		{
+			const int* q = quantized + i * 4;
+			for (unsigned int c = 0; c < layout.colorCount; c++)
+				out[c] = options.srgb ? tables.linearToSrgb[q[c]] : (uint8_t)q[c];
+			if (layout.alphaIndex >= 0)
+				out[layout.alphaIndex] = (uint8_t)q[3];
+		}
+	}
+}
+
+template<typename Kernel>
+static std::vector<MipLevel> generateMips(const uint8_t* pixels, unsigned int width, unsigned int height, unsigned int channels,
+	const MipOptions& options)
+{
+	std::vector<MipLevel> levels;
+
+	std::vector<float> current, next;
+	// The first level reads the 8-bit source through a few decoded rows
+	// rather than converting the whole image to float up front
+	std::vector<float> decodedRows(4 * (size_t)width * 4);
+	unsigned int decodedIndex[4] = { UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX };
+
+	unsigned int srcWidth = width, srcHeight = height;
+	while (srcWidth > 1 || srcHeight > 1)
+	{
+		unsigned int dstWidth = std::max(1u, srcWidth / 2);
+		unsigned int dstHeight = std::max(1u, srcHeight / 2);
+		next.resize((size_t)dstWidth * dstHeight * 4);
+
+		if (levels.empty())
+		{
+			auto sourceRow = [&](unsigned int row) -> const float*
+			{
+				float* slot = decodedRows.data() + (size_t)(row % 4) * width * 4;
+				if (decodedIndex[row % 4] != row)
+				{
+					decodeRow(pixels + (size_t)row * width * channels, width, channels, options, slot);
+					decodedIndex[row % 4] = row;
+				}
+				return slot;
+			};
+			downsample<Kernel>(sourceRow, srcWidth, srcHeight, dstWidth, dstHeight, next.data());
+		}
+		else
+		{
+			auto levelRow = [&](unsigned int row) -> const float* { return current.data() + (size_t)row * srcWidth * 4; };
+			downsample<Kernel>(levelRow, srcWidth, srcHeight, dstWidth, dstHeight, next.data());
+		}
+
+		MipLevel level = { dstWidth, dstHeight, std::vector<uint8_t>((size_t)dstWidth * dstHeight * channels) };
+		encodeLevel<Kernel>(next.data(), (size_t)dstWidth * dstHeight, channels, options, level.pixels.data());
+		levels.push_back(std::move(level));
+
+		std::swap(current, next);
+		srcWidth = dstWidth;
+		srcHeight = dstHeight;
+	}
+	return levels;
+}
+
+std::vector<MipLevel> GenerateMips(const uint8_t* pixels, unsigned int width, unsigned int height, unsigned int channels,
+	const MipOptions& options)
+{
+	if (!pixels || width == 0 || height == 0 || channels == 0 || channels > 4)
+		return {};
+	if (options.simd)
+		return generateMips<VectorKernel>(pixels, width, height, channels, options);
+	return generateMips<ScalarKernel>(pixels, width, height, channels, options);
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+struct MipOptions
+{
+	bool srgb = true;             // filter in linear light, store sRGB again
+	bool premultiplyAlpha = true; // keeps transparent texels from bleeding their color into edges
+	bool simd = true;             // false runs the scalar kernels, for comparing against them
+};
+
+struct MipLevel
+{
+	unsigned int width;
+	unsigned int height;
+	std::vector<uint8_t> pixels; // same channel layout as the source
+};
+
+// Builds every level below the source image, down to 1x1, on the CPU.
+// Each level is a box filter of the one above it; odd sizes are handled by
+// weighting the source texels by how much of each one a destination texel
+// covers. Filtering runs in float with SSE2 or NEON, one RGBA texel per
+// vector, and each level is filtered from the previous float level so the
+// chain doesn't pick up 8-bit rounding error on the way down. Builds with AVX
+// (-mavx2, /arch:AVX2) do two texels per vector on the even-size path and in
+// the conversion back to 8 bits.
+//
+// channels is 1-4 as returned by stb_image; with 2 the second channel is alpha.
+std::vector<MipLevel> GenerateMips(const uint8_t* pixels, unsigned int width, unsigned int height, unsigned int channels,
+	const MipOptions& options = MipOptions());
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "Model.h"
+
+#include "BakedMeshFormat.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+// A texture of its own, kept alive by the model, or a layer of one of arrays
+static Texture acquireTexture(const std::string& path, TextureType type, TextureCache& cache,
+	TextureArrayAllocator* arrays, Model& model)
+{
+	if (arrays)
+	{
+		TextureLayer layer = cache.AcquireLayer(path, *arrays);
+		return { layer.Array->GetID(), type, (int)layer.Layer };
+	}
+	TextureHandle handle = cache.Acquire(path);
+	Texture texture = { handle.GetID(), type };
+	model.Textures.push_back(std::move(handle));
+	return texture;
+}
+
+Model Model::Create(ModelData& data, TextureCache& cache, GeometryPool* pool, bool quantize, TextureArrayAllocator* arrays)
+{
+	Model model;
+	std::vector<std::vector<Texture>> materialTextures(data.Materials.size());
+	for (size_t i = 0; i < data.Materials.size(); i++)
+	{
+		for (size_t type = 0; type < (size_t)TextureType::Count; type++)
+		{
+			const std::string& path = data.Materials[i].Textures[type];
+			if (!path.empty())
+				materialTextures[i].push_back(acquireTexture(path, (TextureType)type, cache, arrays, model));
+		}
+	}
+
+	model.Meshes.reserve(data.Meshes.size());
+	for (const MeshData& mesh : data.Meshes)
+	{
+		std::vector<Texture> meshTextures;
+		if (mesh.Material < materialTextures.size())
+			meshTextures = materialTextures[mesh.Material];
+		if (pool)
+			model.Meshes.emplace_back(pool->Allocate(mesh.Vertices, mesh.Indices, mesh.Primitive), std::move(meshTextures), mesh.Bounds);
+		else if (quantize)
+			model.Meshes.emplace_back(QuantizeVertices(mesh.Vertices), IndexBuffer(mesh.Indices, mesh.Primitive),
+				std::move(meshTextures), mesh.Bounds);
+		else
+			model.Meshes.emplace_back(std::span<const Vertex>(mesh.Vertices), IndexBuffer(mesh.Indices, mesh.Primitive),
+				std::move(meshTextures), mesh.Bounds);
+		model.Bounds.Expand(mesh.Bounds);
+	}
+	data.Meshes.clear();
+	return model;
+}
+
+// Section of the given type, checked to lie inside the file and hold count elements of elementSize
+static const uint8_t* findSection(const MappedFile& file, const BakedMeshSection* sections, uint32_t sectionCount,
+	uint32_t type, size_t elementSize, uint64_t& count)
+{
+	for (uint32_t i = 0; i < sectionCount; i++)
+	{
+		const BakedMeshSection& section = sections[i];
+		if (section.Type != type)
+			continue;
+		if (section.Offset > file.GetSize() || section.Size > file.GetSize() - section.Offset
+			|| section.Count > section.Size / elementSize)
+			return nullptr;
+		count = section.Count;
+		return file.GetData() + section.Offset;
+	}
+	return nullptr;
+}
+
+bool Model::LoadBaked(const std::string& path, TextureCache& cache, Model& model, GeometryPool* pool,
+	TextureArrayAllocator* arrays)
+{
+	PROFILE_SCOPE("LoadBakedMesh");
+	model = Model();
+	MappedFile file(path);
+	if (!file.IsOpen() || file.GetSize() < sizeof(BakedMeshHeader))
+	{
+		std::cout << "Can't open " << path << std::endl;
+		return false;
+	}
+
+	const BakedMeshHeader* header = (const BakedMeshHeader*)file.GetData();
+	if (memcmp(header->Magic, BAKED_MESH_MAGIC, 4) != 0 || header->Version != BAKED_MESH_VERSION
+		|| sizeof(BakedMeshHeader) + (uint64_t)header->SectionCount * sizeof(BakedMeshSection) > file.GetSize())
+	{
+		std::cout << path << " is not a baked mesh of version " << BAKED_MESH_VERSION << std::endl;
+		return false;
+	}
+	const BakedMeshSection* sections = (const BakedMeshSection*)(header + 1);
+
+	uint64_t attributeCount = 0, vertexCount = 0, indexBytes = 0, submeshCount = 0, materialCount = 0, stringBytes = 0;
+	auto attributes = (const BakedVertexAttribute*)findSection(file, sections, header->SectionCount,
+		BAKED_MESH_LAYOUT, sizeof(BakedVertexAttribute), attributeCount);
+	auto vertices = (const Vertex*)findSection(file, sections, header->SectionCount,
+		BAKED_MESH_VERTICES, sizeof(Vertex), vertexCount);
+	auto indices = findSection(file, sections, header->SectionCount, BAKED_MESH_INDICES, 1, indexBytes);
+	auto submeshes = (const BakedSubmesh*)findSection(file, sections, header->SectionCount,
+		BAKED_MESH_SUBMESHES, sizeof(BakedSubmesh), submeshCount);
+	auto materials = (const BakedMaterial*)findSection(file, sections, header->SectionCount,
+		BAKED_MESH_MATERIALS, sizeof(BakedMaterial), materialCount);
+	auto strings = (const char*)findSection(file, sections, header->SectionCount,
+		BAKED_MESH_STRINGS, 1, stringBytes);
+	if (!attributes || !vertices || !indices || !submeshes)
+	{
+		std::cout << path << " is missing sections or has sections past its end" << std::endl;
+		return false;
+	}
+
+	// The vertices go to the GPU as they are, so they must be what Mesh expects
+	bool layoutMatches = header->VertexStride == VERTEX_LAYOUT.Stride && attributeCount == VERTEX_LAYOUT.Elements.size();
+	for (size_t i = 0; layoutMatches && i < attributeCount; i++)
+	{
+		const VertexBufferElement& element = VERTEX_LAYOUT.Elements[i];
+		layoutMatches = attributes[i].GLType == element.type && attributes[i].Count == element.count
+			&& attributes[i].Normalized == element.normalized && attributes[i].Offset == element.offset;
+	}
+	if (!layoutMatches)
+	{
+		std::cout << path << " was baked for a different vertex layout, convert it again" << std::endl;
+		return false;
+	}
+
+	// Texture paths are stored relative to the file
+	std::filesystem::path directory = std::filesystem::path(path).parent_path();
+	auto string = [&](uint32_t offset) -> const char*
+	{
+		if (!strings || offset >= stringBytes || !memchr(strings + offset, '\0', stringBytes - offset))
+			return nullptr;
+		return strings + offset;
+	};
+	std::vector<std::vector<Texture>> materialTextures(materials ? materialCount : 0);
+	for (size_t i = 0; i < materialTextures.size(); i++)
+	{
+		for (size_t type = 0; type < (size_t)TextureType::Count; type++)
+		{
+			const char* texture = string(materials[i].Textures[type]);
+			if (texture)
+				materialTextures[i].push_back(acquireTexture((directory / texture).lexically_normal().string(),
+					(TextureType)type, cache, arrays, model));
+		}
+	}
+
+	model.Meshes.reserve(submeshCount);
+	for (size_t i = 0; i < submeshCount; i++)
+	{
+		const BakedSubmesh& submesh = submeshes[i];
+		bool validIndices = (submesh.IndexType == GL_UNSIGNED_BYTE || submesh.IndexType == GL_UNSIGNED_SHORT
+			|| submesh.IndexType == GL_UNSIGNED_INT) && (submesh.Primitive == GL_TRIANGLES || submesh.Primitive == GL_TRIANGLE_STRIP);
+		uint64_t indexSize = IndexBuffer::TypeSize(submesh.IndexType);
+		if (!validIndices || submesh.FirstVertex > vertexCount || submesh.VertexCount > vertexCount - submesh.FirstVertex
+			|| submesh.IndexOffset % indexSize != 0 || submesh.IndexOffset > indexBytes
+			|| submesh.IndexCount > (indexBytes - submesh.IndexOffset) / indexSize)
+		{
+			std::cout << path << ": submesh " << i << " lies outside the vertex or index data, skipped" << std::endl;
+			continue;
+		}
+		AABB bounds(glm::vec3(submesh.BoundsMin[0], submesh.BoundsMin[1], submesh.BoundsMin[2]),
+			glm::vec3(submesh.BoundsMax[0], submesh.BoundsMax[1], submesh.BoundsMax[2]));
+		std::vector<Texture> textures;
+		if (submesh.Material < materialTextures.size())
+			textures = materialTextures[submesh.Material];
+		std::span<const Vertex> submeshVertices(vertices + submesh.FirstVertex, submesh.VertexCount);
+		const uint8_t* submeshIndices = indices + submesh.IndexOffset;
+		if (pool)
+			model.Meshes.emplace_back(pool->Allocate(submeshVertices, submeshIndices, submesh.IndexCount, submesh.IndexType,
+				submesh.Primitive), std::move(textures), bounds);
+		else
+			model.Meshes.emplace_back(submeshVertices, IndexBuffer(submeshIndices, submesh.IndexCount, submesh.IndexType,
+				submesh.Primitive), std::move(textures), bounds);
+		model.Bounds.Expand(bounds);
+	}
+	return true;
+}
\ No newline at end of file
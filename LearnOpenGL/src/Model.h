@@ -0,0 +1,31 @@
+#pragma once
+#include "Bounds.h"
+#include "Mesh.h"
+#include "ModelImporter.h"
+#include "TextureCache.h"
+
+#include <string>
+#include <vector>
+
+// Meshes and the textures they use, which stay loaded as long as the model lives
+struct Model
+{
+	std::vector<Mesh> Meshes;
+	std::vector<TextureHandle> Textures; // not texture array layers, which the allocator owns
+	AABB Bounds;
+
+	// Uploads imported geometry, leaving data without meshes; textures come from
+	// cache. With a pool the meshes are allocated from it instead of owning buffers.
+	// quantize uploads QuantizedVertex data instead (Mesh::IsQuantized), which
+	// pools can't hold, so it is ignored with one. With arrays every material
+	// texture goes into a texture array layer (TextureCache::AcquireLayer), and
+	// the meshes are drawn with 3.3.shader.material.array.fs.
+	static Model Create(ModelData& data, TextureCache& cache, GeometryPool* pool = nullptr, bool quantize = false,
+		TextureArrayAllocator* arrays = nullptr);
+
+	// Loads a baked mesh (.bmesh, see BakedMeshFormat.h). Vertex and index
+	// buffers are filled straight from the mapped file. Prints what went wrong
+	// and returns false if the file is damaged or was baked for another vertex layout.
+	static bool LoadBaked(const std::string& path, TextureCache& cache, Model& model, GeometryPool* pool = nullptr,
+		TextureArrayAllocator* arrays = nullptr);
+};
\ No newline at end of file
@@ -0,0 +1,1095 @@
+#include "ModelImporter.h"
+
+#include "MappedFile.h"
+#include "Profiler.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string_view>
+#include <thread>
+
+static constexpr uint32_t NONE = UINT32_MAX;
+
+// Runs task(0) .. task(count - 1), handing indices out to threads as they finish
+static void parallelFor(size_t count, unsigned int threadCount, const std::function<void(size_t)>& task)
+{
+	threadCount = (unsigned int)std::min<size_t>(threadCount, count);
+	if (threadCount <= 1)
+	{
+		for (size_t i = 0; i < count; i++)
+			task(i);
+		return;
+	}
+
+	std::atomic<size_t> next = 0;
+	auto worker = [&]()
+	{
+		for (size_t i = next++; i < count; i = next++)
+			task(i);
+	};
+	std::vector<std::thread> threads;
+	for (unsigned int i = 1; i < threadCount; i++)
+		threads.emplace_back(worker);
+	worker();
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+// Area-weighted face normals summed into every vertex that came without one
+static void generateNormals(MeshData& mesh, const std::vector<bool>& missing)
+{
+	for (size_t i = 0; i + 2 < mesh.Indices.size(); i += 3)
+	{
+		Vertex& a = mesh.Vertices[mesh.Indices[i]];
+		Vertex& b = mesh.Vertices[mesh.Indices[i + 1]];
+		Vertex& c = mesh.Vertices[mesh.Indices[i + 2]];
+		glm::vec3 normal = glm::cross(b.Position - a.Position, c.Position - a.Position);
+		for (unsigned int index : { mesh.Indices[i], mesh.Indices[i + 1], mesh.Indices[i + 2] })
+		{
+			if (missing[index])
+				mesh.Vertices[index].Normal += normal;
+		}
+	}
+	for (size_t i = 0; i < mesh.Vertices.size(); i++)
+	{
+		if (!missing[i])
+			continue;
+		float length = glm::length(mesh.Vertices[i].Normal);
+		mesh.Vertices[i].Normal = length > 0.0f ? mesh.Vertices[i].Normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+	}
+}
+
+static std::string resolvePath(const std::filesystem::path& directory, std::string_view relative)
+{
+	return (directory / std::filesystem::path(relative)).lexically_normal().string();
+}
+
+ModelImporter::ModelImporter(unsigned int threadCount)
+	: m_ThreadCount(threadCount != 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency()))
+{}
+
+bool ModelImporter::Import(const std::string& path, ModelData& model)
+{
+	PROFILE_SCOPE("ImportModel");
+	model = ModelData();
+	std::string extension = std::filesystem::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	bool imported = false;
+	if (extension == ".obj")
+		imported = importObj(path, model);
+	else if (extension == ".glb")
+		imported = importGlb(path, model);
+	else
+		std::cout << "Can't import " << path << ": only .obj and .glb are supported" << std::endl;
+
+	if (imported && (m_OptimizeMeshes || m_GenerateStrips))
+	{
+		PROFILE_SCOPE("OptimizeMeshes");
+		parallelFor(model.Meshes.size(), m_ThreadCount, [&](size_t i)
+		{
+			MeshData& mesh = model.Meshes[i];
+			if (m_OptimizeMeshes)
+				mesh.Optimization = OptimizeMesh(mesh.Vertices, mesh.Indices);
+			if (m_GenerateStrips)
+			{
+				std::vector<unsigned int> strip = GenerateTriangleStrips(mesh.Indices);
+				if (strip.size() < mesh.Indices.size())
+				{
+					mesh.Indices.swap(strip);
+					mesh.Primitive = GL_TRIANGLE_STRIP;
+				}
+			}
+		});
+	}
+	return imported;
+}
+
+// ========== OBJ ==========
+
+static inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+static inline void skipSpaces(const char*& p, const char* end)
+{
+	while (p < end && isSpace(*p))
+		p++;
+}
+
+static inline std::string_view nextToken(const char*& p, const char* end)
+{
+	skipSpaces(p, end);
+	const char* start = p;
+	while (p < end && !isSpace(*p))
+		p++;
+	return std::string_view(start, p - start);
+}
+
+// The rest of the line without surrounding whitespace, for names with spaces in them
+static inline std::string_view restOfLine(const char* p, const char* end)
+{
+	skipSpaces(p, end);
+	while (end > p && isSpace(end[-1]))
+		end--;
+	return std::string_view(p, end - p);
+}
+
+static inline bool parseFloat(const char*& p, const char* end, float& value)
+{
+	skipSpaces(p, end);
+	if (p < end && *p == '+')
+		p++;
+	std::from_chars_result result = std::from_chars(p, end, value);
+	if (result.ec != std::errc())
+		return false;
+	p = result.ptr;
+	return true;
+}
+
+// Face indices are most of an OBJ file, so this skips from_chars' generality
+static inline bool parseInt(const char*& p, const char* end, int& value)
+{
+	bool negative = p < end && *p == '-';
+	const char* digits = p + negative;
+	const char* q = digits;
+	int64_t result = 0;
+	while (q < end && (unsigned char)(*q - '0') < 10 && q - digits < 10)
+		result = result * 10 + (*q++ - '0');
+	if (q == digits || result > INT32_MAX)
+		return false;
+	value = (int)(negative ? -result : result);
+	p = q;
+	return true;
+}
+
+// 1-based, or negative counting back from the last element so far
+static inline uint32_t resolveIndex(int index, size_t countSoFar)
+{
+	if (index > 0)
+		return (uint32_t)(index - 1);
+	if (index < 0 && (size_t)-index <= countSoFar)
+		return (uint32_t)(countSoFar + index);
+	return NONE;
+}
+
+struct ObjCorner
+{
+	uint32_t Position;
+	uint32_t TexCoord;
+	uint32_t Normal;
+
+	inline bool operator==(const ObjCorner& other) const
+	{
+		return Position == other.Position && TexCoord == other.TexCoord && Normal == other.Normal;
+	}
+};
+
+struct ObjEvent
+{
+	size_t Corner;  // takes effect from this corner on
+	bool Material;  // usemtl, otherwise o/g
+	std::string_view Name;
+};
+
+struct ObjChunk
+{
+	const char* Begin;
+	const char* End;
+	size_t PositionBase = 0, TexCoordBase = 0, NormalBase = 0;
+	size_t Positions = 0, TexCoords = 0, Normals = 0, Faces = 0;
+	std::vector<ObjCorner> Corners = {}; // three per triangle
+	std::vector<ObjEvent> Events = {};
+	std::vector<std::string_view> Libraries = {};
+};
+
+static inline const char* lineEnd(const char* p, const char* end)
+{
+	const char* newline = (const char*)memchr(p, '\n', end - p);
+	return newline ? newline : end;
+}
+
+static void countObjElements(ObjChunk& chunk)
+{
+	for (const char* p = chunk.Begin; p < chunk.End;)
+	{
+		const char* end = lineEnd(p, chunk.End);
+		skipSpaces(p, end);
+		if (end - p >= 2 && p[0] == 'v')
+		{
+			if (isSpace(p[1]))
+				chunk.Positions++;
+			else if (p[1] == 't')
+				chunk.TexCoords++;
+			else if (p[1] == 'n')
+				chunk.Normals++;
+		}
+		else if (end - p >= 2 && p[0] == 'f' && isSpace(p[1]))
+			chunk.Faces++;
+		p = end + 1;
+	}
+}
+
+static void parseObjChunk(ObjChunk& chunk, glm::vec3* positions, glm::vec2* texCoords, glm::vec3* normals)
+{
+	size_t position = chunk.PositionBase, texCoord = chunk.TexCoordBase, normal = chunk.NormalBase;
+	std::vector<ObjCorner> polygon;
+	chunk.Corners.reserve(chunk.Faces * 3);
+	for (const char* p = chunk.Begin; p < chunk.End;)
+	{
+		const char* end = lineEnd(p, chunk.End);
+		const char* line = p;
+		p = end + 1;
+		std::string_view keyword = nextToken(line, end);
+		if (keyword == "v")
+		{
+			glm::vec3& v = positions[position++];
+			if (!parseFloat(line, end, v.x) || !parseFloat(line, end, v.y) || !parseFloat(line, end, v.z))
+				v = glm::vec3(0.0f);
+		}
+		else if (keyword == "vt")
+		{
+			glm::vec2& v = texCoords[texCoord++];
+			if (!parseFloat(line, end, v.x))
+				v.x = 0.0f;
+			if (!parseFloat(line, end, v.y))
+				v.y = 0.0f;
+		}
+		else if (keyword == "vn")
+		{
+			glm::vec3& v = normals[normal++];
+			if (!parseFloat(line, end, v.x) || !parseFloat(line, end, v.y) || !parseFloat(line, end, v.z))
+				v = glm::vec3(0.0f);
+		}
+		else if (keyword == "f")
+		{
+			// v, v/vt, v//vn or v/vt/vn; polygons are fanned into triangles
+			polygon.clear();
+			for (std::string_view token = nextToken(line, end); !token.empty(); token = nextToken(line, end))
+			{
+				const char* t = token.data();
+				const char* tokenEnd = t + token.size();
+				int index = 0;
+				ObjCorner corner = { NONE, NONE, NONE };
+				if (!parseInt(t, tokenEnd, index))
+					break;
+				corner.Position = resolveIndex(index, position);
+				if (t < tokenEnd && *t == '/')
+				{
+					t++;
+					if (t < tokenEnd && *t != '/' && parseInt(t, tokenEnd, index))
+						corner.TexCoord = resolveIndex(index, texCoord);
+					if (t < tokenEnd && *t == '/')
+					{
+						t++;
+						if (parseInt(t, tokenEnd, index))
+							corner.Normal = resolveIndex(index, normal);
+					}
+				}
+				polygon.push_back(corner);
+			}
+			for (size_t i = 2; i < polygon.size(); i++)
+			{
+				chunk.Corners.push_back(polygon[0]);
+				chunk.Corners.push_back(polygon[i - 1]);
+				chunk.Corners.push_back(polygon[i]);
+			}
+		}
+		else if (keyword == "o" || keyword == "g")
+			chunk.Events.push_back({ chunk.Corners.size(), false, restOfLine(line, end) });
+		else if (keyword == "usemtl")
+			chunk.Events.push_back({ chunk.Corners.size(), true, restOfLine(line, end) });
+		else if (keyword == "mtllib")
+			chunk.Libraries.push_back(restOfLine(line, end));
+	}
+}
+
+static void parseMtl(const std::string& path, ModelData& model, std::map<std::string, uint32_t, std::less<>>& materials)
+{
+	MappedFile file(path);
+	if (!file.IsOpen())
+	{
+		std::cout << "Can't open material library " << path << std::endl;
+		return;
+	}
+	std::filesystem::path directory = std::filesystem::path(path).parent_path();
+	const char* p = (const char*)file.GetData();
+	const char* fileEnd = p + file.GetSize();
+	MaterialData* material = nullptr;
+	while (p < fileEnd)
+	{
+		const char* end = lineEnd(p, fileEnd);
+		const char* line = p;
+		p = end + 1;
+		std::string_view keyword = nextToken(line, end);
+		if (keyword == "newmtl")
+		{
+			std::string name(restOfLine(line, end));
+			auto it = materials.find(name);
+			if (it == materials.end())
+			{
+				it = materials.emplace(name, (uint32_t)model.Materials.size()).first;
+				model.Materials.push_back({ name, {} });
+			}
+			material = &model.Materials[it->second];
+			continue;
+		}
+
+		TextureType type = TextureType::Count;
+		if (keyword == "map_Kd")
+			type = TextureType::Diffuse;
+		else if (keyword == "map_Ks")
+			type = TextureType::Specular;
+		else if (keyword == "map_Bump" || keyword == "map_bump" || keyword == "bump" || keyword == "norm")
+			type = TextureType::Normal;
+		else if (keyword == "disp" || keyword == "map_disp")
+			type = TextureType::Height;
+		if (!material || type == TextureType::Count)
+			continue;
+
+		// Options like "-bm 0.5" come first, the file name is the last token
+		std::string_view file;
+		for (std::string_view token = nextToken(line, end); !token.empty(); token = nextToken(line, end))
+			file = token;
+		if (!file.empty())
+			material->Textures[(size_t)type] = resolvePath(directory, file);
+	}
+}
+
+// Open addressing over (position, texcoord, normal) triples, mapping each to its welded vertex.
+// Faces mostly reference positions close to each other in the file, so the
+// home slot is the position index itself: lookups walk the table nearly in
+// order instead of missing the cache on every corner. Corners sharing a
+// position (hard edges, UV seams) land in the slots right after it.
+class CornerMap
+{
+public:
+	explicit CornerMap(size_t expected)
+	{
+		m_Slots.resize(std::bit_ceil(std::max<size_t>(expected * 2, 64)), Slot{ { NONE, NONE, NONE }, NONE });
+	}
+
+	// Returns the existing vertex, or inserts next and returns it
+	uint32_t Insert(const ObjCorner& corner, uint32_t next)
+	{
+		if (m_Count * 2 >= m_Slots.size())
+			grow();
+		size_t mask = m_Slots.size() - 1;
+		for (size_t i = hash(corner) & mask;; i = (i + 1) & mask)
+		{
+			Slot& slot = m_Slots[i];
+			if (slot.Vertex == NONE)
+			{
+				slot = { corner, next };
+				m_Count++;
+				return next;
+			}
+			if (slot.Key == corner)
+				return slot.Vertex;
+		}
+	}
+private:
+	struct Slot
+	{
+		ObjCorner Key;
+		uint32_t Vertex;
+	};
+	std::vector<Slot> m_Slots;
+	size_t m_Count = 0;
+
+	static inline size_t hash(const ObjCorner& corner)
+	{
+		return (size_t)corner.Position * 2;
+	}
+
+	void grow()
+	{
+		std::vector<Slot> old(m_Slots.size() * 2, Slot{ { NONE, NONE, NONE }, NONE });
+		old.swap(m_Slots);
+		size_t mask = m_Slots.size() - 1;
+		for (const Slot& slot : old)
+		{
+			if (slot.Vertex == NONE)
+				continue;
+			size_t i = hash(slot.Key) & mask;
+			while (m_Slots[i].Vertex != NONE)
+				i = (i + 1) & mask;
+			m_Slots[i] = slot;
+		}
+	}
+};
+
+bool ModelImporter::importObj(const std::string& path, ModelData& model)
+{
+	MappedFile file(path);
+	if (!file.IsOpen())
+	{
+		std::cout << "Can't open " << path << std::endl;
+		return false;
+	}
+	const char* data = (const char*)file.GetData();
+	const char* dataEnd = data + file.GetSize();
+
+	// Line-aligned chunks of a few MB, several per thread so they balance out
+	size_t chunkSize = std::max<size_t>(4 << 20, file.GetSize() / (m_ThreadCount * 4) + 1);
+	std::vector<ObjChunk> chunks;
+	for (const char* begin = data; begin < dataEnd;)
+	{
+		const char* end = begin + std::min<size_t>(chunkSize, dataEnd - begin);
+		end = end < dataEnd ? lineEnd(end, dataEnd) + 1 : dataEnd;
+		chunks.push_back({ begin, std::min(end, dataEnd) });
+		begin = end;
+	}
+
+	// Count first, so every chunk knows where its elements go and what
+	// relative (negative) indices refer to before anything is parsed
+	parallelFor(chunks.size(), m_ThreadCount, [&](size_t i) { countObjElements(chunks[i]); });
+	size_t positionCount = 0, texCoordCount = 0, normalCount = 0;
+	for (ObjChunk& chunk : chunks)
+	{
+		chunk.PositionBase = positionCount;
+		chunk.TexCoordBase = texCoordCount;
+		chunk.NormalBase = normalCount;
+		positionCount += chunk.Positions;
+		texCoordCount += chunk.TexCoords;
+		normalCount += chunk.Normals;
+	}
+	std::vector<glm::vec3> positions(positionCount);
+	std::vector<glm::vec2> texCoords(texCoordCount);
+	std::vector<glm::vec3> normals(normalCount);
+	parallelFor(chunks.size(), m_ThreadCount, [&](size_t i)
+	{
+		parseObjChunk(chunks[i], positions.data(), texCoords.data(), normals.data());
+	});
+
+	// Materials
+	std::filesystem::path directory = std::filesystem::path(path).parent_path();
+	std::map<std::string, uint32_t, std::less<>> materials;
+	for (const ObjChunk& chunk : chunks)
+	{
+		for (std::string_view library : chunk.Libraries)
+			parseMtl(resolvePath(directory, library), model, materials);
+	}
+	auto findMaterial = [&](std::string_view name)
+	{
+		if (name.empty())
+			return NONE;
+		auto it = materials.find(name);
+		if (it == materials.end())
+		{
+			it = materials.emplace(std::string(name), (uint32_t)model.Materials.size()).first;
+			model.Materials.push_back({ std::string(name), {} });
+		}
+		return it->second;
+	};
+
+	// Group the triangles into meshes by object and material, cutting big ones into parts
+	struct Range
+	{
+		const ObjChunk* Chunk;
+		size_t Begin, End;
+	};
+	struct Part
+	{
+		std::string_view Name;
+		uint32_t Material;
+		std::vector<Range> Ranges = {};
+		size_t Corners = 0;
+	};
+	std::vector<Part> parts;
+	std::map<std::pair<std::string_view, uint32_t>, size_t> openParts;
+	std::string_view object;
+	uint32_t material = NONE;
+	auto addRange = [&](const ObjChunk& chunk, size_t begin, size_t end)
+	{
+		while (begin < end)
+		{
+			auto [it, inserted] = openParts.try_emplace({ object, material }, parts.size());
+			if (inserted || parts[it->second].Corners >= MaxTrianglesPerMesh * 3)
+			{
+				it->second = parts.size();
+				parts.push_back({ object, material });
+			}
+			Part& part = parts[it->second];
+			size_t take = std::min(end - begin, MaxTrianglesPerMesh * 3 - part.Corners);
+			part.Ranges.push_back({ &chunk, begin, begin + take });
+			part.Corners += take;
+			begin += take;
+		}
+	};
+	for (const ObjChunk& chunk : chunks)
+	{
+		size_t corner = 0;
+		for (const ObjEvent& event : chunk.Events)
+		{
+			addRange(chunk, corner, event.Corner);
+			corner = event.Corner;
+			if (event.Material)
+				material = findMaterial(event.Name);
+			else
+				object = event.Name;
+		}
+		addRange(chunk, corner, chunk.Corners.size());
+	}
+
+	// Weld each part into indexed vertices
+	model.Meshes.resize(parts.size());
+	std::atomic<size_t> badIndices = 0;
+	parallelFor(parts.size(), m_ThreadCount, [&](size_t i)
+	{
+		const Part& part = parts[i];
+		MeshData& mesh = model.Meshes[i];
+		mesh.Name = std::string(part.Name);
+		mesh.Material = part.Material;
+		mesh.Indices.reserve(part.Corners);
+		CornerMap map(part.Corners / 6);
+		std::vector<bool> missingNormals;
+		bool anyMissing = false;
+		for (const Range& range : part.Ranges)
+		{
+			const ObjCorner* corners = range.Chunk->Corners.data();
+			for (size_t c = range.Begin; c < range.End; c += 3)
+			{
+				if (corners[c].Position >= positionCount || corners[c + 1].Position >= positionCount || corners[c + 2].Position >= positionCount)
+				{
+					badIndices++;
+					continue;
+				}
+				for (size_t k = c; k < c + 3; k++)
+				{
+					ObjCorner corner = corners[k];
+					if (corner.TexCoord >= texCoordCount)
+						corner.TexCoord = NONE;
+					if (corner.Normal >= normalCount)
+						corner.Normal = NONE;
+					uint32_t index = map.Insert(corner, (uint32_t)mesh.Vertices.size());
+					if (index == mesh.Vertices.size())
+					{
+						Vertex vertex;
+						vertex.Position = positions[corner.Position];
+						vertex.TexCoords = corner.TexCoord != NONE ? texCoords[corner.TexCoord] : glm::vec2(0.0f);
+						vertex.Normal = corner.Normal != NONE ? normals[corner.Normal] : glm::vec3(0.0f);
+						mesh.Vertices.push_back(vertex);
+						mesh.Bounds.Expand(vertex.Position);
+						missingNormals.push_back(corner.Normal == NONE);
+						anyMissing |= corner.Normal == NONE;
+					}
+					mesh.Indices.push_back(index);
+				}
+			}
+		}
+		if (anyMissing)
+			generateNormals(mesh, missingNormals);
+	});
+	if (badIndices > 0)
+		std::cout << path << ": skipped " << badIndices << " faces with out of range indices" << std::endl;
+
+	model.Meshes.erase(std::remove_if(model.Meshes.begin(), model.Meshes.end(),
+		[](const MeshData& mesh) { return mesh.Indices.empty(); }), model.Meshes.end());
+	return true;
+}
+
+// ========== glTF ==========
+
+// Just enough JSON for a glTF header. Strings point into the file and keep
+// their escapes; glTF names and URIs practically never use any.
+class JsonDocument
+{
+public:
+	struct Value
+	{
+		enum class Type : uint8_t { Null, Bool, Number, String, Array, Object };
+		Type Kind = Type::Null;
+		double Number = 0.0;
+		std::string_view String;
+		uint32_t First = 0, Count = 0; // children, for arrays and objects
+	};
+
+	bool Parse(std::string_view text)
+	{
+		m_Text = text;
+		m_Position = 0;
+		m_Values.clear();
+		m_Children.clear();
+		m_Keys.clear();
+		m_Values.push_back({});
+		return parseValue(0) && (skipSpace(), m_Position == m_Text.size());
+	}
+
+	inline const Value& GetRoot() const { return m_Values[0]; }
+
+	const Value* Get(const Value& object, std::string_view key) const
+	{
+		if (object.Kind != Value::Type::Object)
+			return nullptr;
+		for (uint32_t i = 0; i < object.Count; i++)
+		{
+			if (m_Keys[object.First + i] == key)
+				return &m_Values[m_Children[object.First + i]];
+		}
+		return nullptr;
+	}
+
+	const Value* At(const Value* array, size_t index) const
+	{
+		if (!array || array->Kind != Value::Type::Array || index >= array->Count)
+			return nullptr;
+		return &m_Values[m_Children[array->First + index]];
+	}
+
+	const Value* Get(const Value* object, std::string_view key) const { return object ? Get(*object, key) : nullptr; }
+
+	double GetNumber(const Value* object, std::string_view key, double fallback) const
+	{
+		const Value* value = Get(object, key);
+		return value && value->Kind == Value::Type::Number ? value->Number : fallback;
+	}
+
+	size_t GetIndex(const Value* object, std::string_view key) const
+	{
+		const Value* value = Get(object, key);
+		return value && value->Kind == Value::Type::Number && value->Number >= 0.0 ? (size_t)value->Number : SIZE_MAX;
+	}
+
+	std::string_view GetString(const Value* object, std::string_view key) const
+	{
+		const Value* value = Get(object, key);
+		return value && value->Kind == Value::Type::String ? value->String : std::string_view();
+	}
+private:
+	std::string_view m_Text;
+	size_t m_Position = 0;
+	std::vector<Value> m_Values;
+	std::vector<uint32_t> m_Children;
+	std::vector<std::string_view> m_Keys;
+
+	void skipSpace()
+	{
+		while (m_Position < m_Text.size() && (m_Text[m_Position] == ' ' || m_Text[m_Position] == '\n'
+			|| m_Text[m_Position] == '\r' || m_Text[m_Position] == '\t'))
+			m_Position++;
+	}
+
+	bool parseString(std::string_view& out)
+	{
+		if (m_Position >= m_Text.size() || m_Text[m_Position] != '"')
+			return false;
+		size_t start = ++m_Position;
+		while (m_Position < m_Text.size() && m_Text[m_Position] != '"')
+			m_Position += m_Text[m_Position] == '\\' ? 2 : 1;
+		if (m_Position >= m_Text.size())
+			return false;
+		out = m_Text.substr(start, m_Position++ - start);
+		return true;
+	}
+
+	bool parseValue(uint32_t index)
+	{
+		skipSpace();
+		if (m_Position >= m_Text.size())
+			return false;
+		char c = m_Text[m_Position];
+		if (c == '{' || c == '[')
+		{
+			bool object = c == '{';
+			char close = object ? '}' : ']';
+			m_Position++;
+			// Children are parsed (and nest) first, then appended together so they stay contiguous
+			std::vector<uint32_t> children;
+			std::vector<std::string_view> keys;
+			skipSpace();
+			if (m_Position < m_Text.size() && m_Text[m_Position] == close)
+				m_Position++;
+			else
+			{
+				for (;;)
+				{
+					std::string_view key;
+					if (object)
+					{
+						skipSpace();
+						if (!parseString(key))
+							return false;
+						skipSpace();
+						if (m_Position >= m_Text.size() || m_Text[m_Position++] != ':')
+							return false;
+					}
+					uint32_t child = (uint32_t)m_Values.size();
+					m_Values.push_back({});
+					if (!parseValue(child))
+						return false;
+					children.push_back(child);
+					keys.push_back(key);
+					skipSpace();
+					if (m_Position >= m_Text.size())
+						return false;
+					char next = m_Text[m_Position++];
+					if (next == close)
+						break;
+					if (next != ',')
+						return false;
+				}
+			}
+			Value& value = m_Values[index];
+			value.Kind = object ? Value::Type::Object : Value::Type::Array;
+			value.First = (uint32_t)m_Children.size();
+			value.Count = (uint32_t)children.size();
+			m_Children.insert(m_Children.end(), children.begin(), children.end());
+			m_Keys.insert(m_Keys.end(), keys.begin(), keys.end());
+			return true;
+		}
+		if (c == '"')
+		{
+			std::string_view text;
+			if (!parseString(text))
+				return false;
+			m_Values[index].Kind = Value::Type::String;
+			m_Values[index].String = text;
+			return true;
+		}
+		for (std::string_view literal : { "true", "false", "null" })
+		{
+			if (m_Text.substr(m_Position, literal.size()) == literal)
+			{
+				m_Position += literal.size();
+				m_Values[index].Kind = literal == "null" ? Value::Type::Null : Value::Type::Bool;
+				m_Values[index].Number = literal == "true" ? 1.0 : 0.0;
+				return true;
+			}
+		}
+		const char* begin = m_Text.data() + m_Position;
+		std::from_chars_result result = std::from_chars(begin, m_Text.data() + m_Text.size(), m_Values[index].Number);
+		if (result.ec != std::errc())
+			return false;
+		m_Values[index].Kind = Value::Type::Number;
+		m_Position += result.ptr - begin;
+		return true;
+	}
+};
+
+static constexpr uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+static constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+static constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+// Typed view of an accessor's elements inside the binary chunk
+struct GltfAccessor
+{
+	const uint8_t* Data = nullptr;
+	size_t Count = 0;
+	size_t Stride = 0;
+	unsigned int ComponentType = 0;
+	unsigned int Components = 0;
+	bool Normalized = false;
+
+	// Element i converted to floats, normalizing integer types when asked to
+	void Read(size_t i, float* out) const
+	{
+		const uint8_t* element = Data + i * Stride;
+		for (unsigned int c = 0; c < Components; c++)
+		{
+			switch (ComponentType)
+			{
+			case GL_FLOAT:          { float v; memcpy(&v, element + c * 4, 4); out[c] = v; break; }
+			case GL_UNSIGNED_BYTE:  out[c] = Normalized ? element[c] / 255.0f : element[c]; break;
+			case GL_BYTE:           out[c] = Normalized ? std::max(((int8_t)element[c]) / 127.0f, -1.0f) : (int8_t)element[c]; break;
+			case GL_UNSIGNED_SHORT: { uint16_t v; memcpy(&v, element + c * 2, 2); out[c] = Normalized ? v / 65535.0f : v; break; }
+			case GL_SHORT:          { int16_t v; memcpy(&v, element + c * 2, 2); out[c] = Normalized ? std::max(v / 32767.0f, -1.0f) : v; break; }
+			default:                out[c] = 0.0f;
+			}
+		}
+	}
+
+	uint32_t ReadIndex(size_t i) const
+	{
+		const uint8_t* element = Data + i * Stride;
+		switch (ComponentType)
+		{
+		case GL_UNSIGNED_BYTE:  return element[0];
+		case GL_UNSIGNED_SHORT: { uint16_t v; memcpy(&v, element, 2); return v; }
+		case GL_UNSIGNED_INT:   { uint32_t v; memcpy(&v, element, 4); return v; }
+		}
+		return 0;
+	}
+};
+
+static bool gltfAccessor(const JsonDocument& json, const uint8_t* bin, size_t binSize, size_t index, GltfAccessor& accessor)
+{
+	const JsonDocument::Value& root = json.GetRoot();
+	const JsonDocument::Value* desc = json.At(json.Get(root, "accessors"), index);
+	if (!desc)
+		return false;
+	const JsonDocument::Value* view = json.At(json.Get(root, "bufferViews"), json.GetIndex(desc, "bufferView"));
+	if (!view || json.GetIndex(view, "buffer") != 0)
+		return false;
+
+	static const std::pair<std::string_view, unsigned int> types[] = {
+		{ "SCALAR", 1 }, { "VEC2", 2 }, { "VEC3", 3 }, { "VEC4", 4 } };
+	std::string_view type = json.GetString(desc, "type");
+	accessor.Components = 0;
+	for (const auto& [name, components] : types)
+	{
+		if (name == type)
+			accessor.Components = components;
+	}
+	accessor.ComponentType = (unsigned int)json.GetNumber(desc, "componentType", 0);
+	unsigned int componentSize = accessor.ComponentType == GL_FLOAT || accessor.ComponentType == GL_UNSIGNED_INT ? 4
+		: accessor.ComponentType == GL_SHORT || accessor.ComponentType == GL_UNSIGNED_SHORT ? 2 : 1;
+	size_t elementSize = (size_t)componentSize * accessor.Components;
+	accessor.Count = (size_t)json.GetNumber(desc, "count", 0);
+	accessor.Stride = (size_t)json.GetNumber(view, "byteStride", (double)elementSize);
+	accessor.Normalized = json.Get(desc, "normalized") && json.Get(desc, "normalized")->Number != 0.0;
+
+	size_t viewOffset = (size_t)json.GetNumber(view, "byteOffset", 0);
+	size_t viewLength = (size_t)json.GetNumber(view, "byteLength", 0);
+	size_t offset = (size_t)json.GetNumber(desc, "byteOffset", 0);
+	if (accessor.Components == 0 || viewOffset + viewLength > binSize || accessor.Count == 0
+		|| offset + (accessor.Count - 1) * accessor.Stride + elementSize > viewLength)
+		return false;
+	accessor.Data = bin + viewOffset + offset;
+	return true;
+}
+
+static glm::mat4 gltfNodeTransform(const JsonDocument& json, const JsonDocument::Value* node)
+{
+	const JsonDocument::Value* matrix = json.Get(node, "matrix");
+	if (matrix && matrix->Count == 16)
+	{
+		glm::mat4 result;
+		for (int i = 0; i < 16; i++)
+			result[i / 4][i % 4] = (float)json.At(matrix, i)->Number;
+		return result;
+	}
+	auto vector = [&](std::string_view key, glm::vec4 fallback)
+	{
+		const JsonDocument::Value* value = json.Get(node, key);
+		for (uint32_t i = 0; value && i < value->Count && i < 4; i++)
+			fallback[i] = (float)json.At(value, i)->Number;
+		return fallback;
+	};
+	glm::vec4 t = vector("translation", glm::vec4(0.0f));
+	glm::vec4 r = vector("rotation", glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	glm::vec4 s = vector("scale", glm::vec4(1.0f));
+	// Quaternion (x, y, z, w) to a rotation matrix
+	glm::mat4 rotation(1.0f);
+	rotation[0] = glm::vec4(1 - 2 * (r.y * r.y + r.z * r.z), 2 * (r.x * r.y + r.z * r.w), 2 * (r.x * r.z - r.y * r.w), 0);
+	rotation[1] = glm::vec4(2 * (r.x * r.y - r.z * r.w), 1 - 2 * (r.x * r.x + r.z * r.z), 2 * (r.y * r.z + r.x * r.w), 0);
+	rotation[2] = glm::vec4(2 * (r.x * r.z + r.y * r.w), 2 * (r.y * r.z - r.x * r.w), 1 - 2 * (r.x * r.x + r.y * r.y), 0);
+	glm::mat4 result = glm::translate(glm::mat4(1.0f), glm::vec3(t)) * rotation;
+	return glm::scale(result, glm::vec3(s));
+}
+
+static std::string percentDecode(std::string_view uri)
+{
+	std::string result;
+	for (size_t i = 0; i < uri.size(); i++)
+	{
+		int value;
+		if (uri[i] == '%' && i + 2 < uri.size() && std::from_chars(uri.data() + i + 1, uri.data() + i + 3, value, 16).ec == std::errc())
+		{
+			result += (char)value;
+			i += 2;
+		}
+		else
+			result += uri[i];
+	}
+	return result;
+}
+
+bool ModelImporter::importGlb(const std::string& path, ModelData& model)
+{
+	MappedFile file(path);
+	const uint8_t* data = file.GetData();
+	uint32_t header[5];
+	if (!file.IsOpen() || file.GetSize() < sizeof(header))
+	{
+		std::cout << "Can't open " << path << std::endl;
+		return false;
+	}
+	memcpy(header, data, sizeof(header));
+	if (header[0] != GLB_MAGIC || header[1] != 2 || header[4] != GLB_CHUNK_JSON || 20 + (size_t)header[3] > file.GetSize())
+	{
+		std::cout << path << " is not a binary glTF 2.0 file" << std::endl;
+		return false;
+	}
+	std::string_view text((const char*)data + 20, header[3]);
+	const uint8_t* bin = nullptr;
+	size_t binSize = 0;
+	size_t binHeader = 20 + (size_t)header[3];
+	if (binHeader + 8 <= file.GetSize())
+	{
+		uint32_t chunk[2];
+		memcpy(chunk, data + binHeader, sizeof(chunk));
+		if (chunk[1] == GLB_CHUNK_BIN && binHeader + 8 + chunk[0] <= file.GetSize())
+		{
+			bin = data + binHeader + 8;
+			binSize = chunk[0];
+		}
+	}
+
+	JsonDocument json;
+	if (!json.Parse(text))
+	{
+		std::cout << path << ": malformed glTF JSON" << std::endl;
+		return false;
+	}
+	const JsonDocument::Value& root = json.GetRoot();
+	std::filesystem::path directory = std::filesystem::path(path).parent_path();
+
+	// Materials: base color becomes the diffuse texture
+	const JsonDocument::Value* materials = json.Get(root, "materials");
+	bool embeddedImages = false;
+	auto texturePath = [&](const JsonDocument::Value* textureInfo)
+	{
+		const JsonDocument::Value* texture = json.At(json.Get(root, "textures"), json.GetIndex(textureInfo, "index"));
+		const JsonDocument::Value* image = json.At(json.Get(root, "images"), json.GetIndex(texture, "source"));
+		std::string_view uri = json.GetString(image, "uri");
+		if (uri.empty() || uri.starts_with("data:"))
+		{
+			embeddedImages |= image != nullptr;
+			return std::string();
+		}
+		return resolvePath(directory, percentDecode(uri));
+	};
+	for (uint32_t i = 0; materials && i < materials->Count; i++)
+	{
+		const JsonDocument::Value* material = json.At(materials, i);
+		MaterialData result;
+		result.Name = std::string(json.GetString(material, "name"));
+		result.Textures[(size_t)TextureType::Diffuse] = texturePath(json.Get(json.Get(material, "pbrMetallicRoughness"), "baseColorTexture"));
+		result.Textures[(size_t)TextureType::Normal] = texturePath(json.Get(material, "normalTexture"));
+		model.Materials.push_back(std::move(result));
+	}
+	if (embeddedImages)
+		std::cout << path << ": images embedded in the file aren't supported, those textures are left out" << std::endl;
+
+	// Every primitive of every mesh node in the scene, with its world transform
+	struct Task
+	{
+		const JsonDocument::Value* Mesh;
+		const JsonDocument::Value* Primitive;
+		glm::mat4 Transform;
+	};
+	std::vector<Task> tasks;
+	const JsonDocument::Value* nodes = json.Get(root, "nodes");
+	const JsonDocument::Value* meshes = json.Get(root, "meshes");
+	std::function<void(size_t, const glm::mat4&, unsigned int)> visit = [&](size_t index, const glm::mat4& parent, unsigned int depth)
+	{
+		const JsonDocument::Value* node = json.At(nodes, index);
+		if (!node || depth > 64)
+			return;
+		glm::mat4 transform = parent * gltfNodeTransform(json, node);
+		const JsonDocument::Value* mesh = json.At(meshes, json.GetIndex(node, "mesh"));
+		const JsonDocument::Value* primitives = json.Get(mesh, "primitives");
+		for (uint32_t i = 0; primitives && i < primitives->Count; i++)
+			tasks.push_back({ mesh, json.At(primitives, i), transform });
+		const JsonDocument::Value* children = json.Get(node, "children");
+		for (uint32_t i = 0; children && i < children->Count; i++)
+			visit((size_t)json.At(children, i)->Number, transform, depth + 1);
+	};
+	const JsonDocument::Value* scene = json.At(json.Get(root, "scenes"), (size_t)json.GetNumber(&root, "scene", 0));
+	const JsonDocument::Value* sceneNodes = json.Get(scene, "nodes");
+	if (sceneNodes)
+	{
+		for (uint32_t i = 0; i < sceneNodes->Count; i++)
+			visit((size_t)json.At(sceneNodes, i)->Number, glm::mat4(1.0f), 0);
+	}
+	else
+	{
+		// No scene: every mesh once, untransformed
+		for (uint32_t m = 0; meshes && m < meshes->Count; m++)
+		{
+			const JsonDocument::Value* primitives = json.Get(json.At(meshes, m), "primitives");
+			for (uint32_t i = 0; primitives && i < primitives->Count; i++)
+				tasks.push_back({ json.At(meshes, m), json.At(primitives, i), glm::mat4(1.0f) });
+		}
+	}
+
+	model.Meshes.resize(tasks.size());
+	std::atomic<size_t> skipped = 0;
+	parallelFor(tasks.size(), m_ThreadCount, [&](size_t t)
+	{
+		const Task& task = tasks[t];
+		MeshData& mesh = model.Meshes[t];
+		const JsonDocument::Value* attributes = json.Get(task.Primitive, "attributes");
+		GltfAccessor positions, normals, texCoords, indices;
+		if (json.GetNumber(task.Primitive, "mode", 4) != 4
+			|| !gltfAccessor(json, bin, binSize, json.GetIndex(attributes, "POSITION"), positions) || positions.Components != 3)
+		{
+			skipped++;
+			return;
+		}
+		bool hasNormals = gltfAccessor(json, bin, binSize, json.GetIndex(attributes, "NORMAL"), normals)
+			&& normals.Components == 3 && normals.Count == positions.Count;
+		bool hasTexCoords = gltfAccessor(json, bin, binSize, json.GetIndex(attributes, "TEXCOORD_0"), texCoords)
+			&& texCoords.Components == 2 && texCoords.Count == positions.Count;
+
+		mesh.Name = std::string(json.GetString(task.Mesh, "name"));
+		size_t material = json.GetIndex(task.Primitive, "material");
+		mesh.Material = material < model.Materials.size() ? (uint32_t)material : NONE;
+
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(task.Transform)));
+		mesh.Vertices.resize(positions.Count);
+		for (size_t i = 0; i < positions.Count; i++)
+		{
+			Vertex& vertex = mesh.Vertices[i];
+			float value[3];
+			positions.Read(i, value);
+			vertex.Position = glm::vec3(task.Transform * glm::vec4(value[0], value[1], value[2], 1.0f));
+			mesh.Bounds.Expand(vertex.Position);
+			if (hasNormals)
+			{
+				normals.Read(i, value);
+				glm::vec3 normal = normalMatrix * glm::vec3(value[0], value[1], value[2]);
+				float length = glm::length(normal);
+				vertex.Normal = length > 0.0f ? normal / length : normal;
+			}
+			else
+				vertex.Normal = glm::vec3(0.0f);
+			if (hasTexCoords)
+			{
+				// glTF puts the texture origin at the top left, GL at the bottom left
+				texCoords.Read(i, value);
+				vertex.TexCoords = glm::vec2(value[0], 1.0f - value[1]);
+			}
+			else
+				vertex.TexCoords = glm::vec2(0.0f);
+		}
+
+		if (gltfAccessor(json, bin, binSize, json.GetIndex(task.Primitive, "indices"), indices) && indices.Components == 1)
+		{
+			mesh.Indices.resize(indices.Count - indices.Count % 3);
+			for (size_t i = 0; i < mesh.Indices.size(); i++)
+			{
+				uint32_t index = indices.ReadIndex(i);
+				mesh.Indices[i] = index < positions.Count ? index : 0;
+			}
+		}
+		else
+		{
+			mesh.Indices.resize(positions.Count - positions.Count % 3);
+			for (size_t i = 0; i < mesh.Indices.size(); i++)
+				mesh.Indices[i] = (uint32_t)i;
+		}
+
+		// A mirroring transform turns the triangles inside out
+		if (glm::determinant(glm::mat3(task.Transform)) < 0.0f)
+		{
+			for (size_t i = 0; i < mesh.Indices.size(); i += 3)
+				std::swap(mesh.Indices[i + 1], mesh.Indices[i + 2]);
+		}
+		if (!hasNormals)
+			generateNormals(mesh, std::vector<bool>(mesh.Vertices.size(), true));
+	});
+	if (skipped > 0)
+		std::cout << path << ": skipped " << skipped << " primitives that aren't triangle lists with positions" << std::endl;
+
+	model.Meshes.erase(std::remove_if(model.Meshes.begin(), model.Meshes.end(),
+		[](const MeshData& mesh) { return mesh.Indices.empty(); }), model.Meshes.end());
+	return true;
+}
\ No newline at end of file
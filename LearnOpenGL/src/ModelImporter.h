@@ -0,0 +1,76 @@
+#pragma once
+#include "Bounds.h"
+#include "MeshOptimizer.h"
+#include "VertexLayout.h"
+
+#include <string>
+#include <vector>
+
+// Texture paths of one material, resolved against the model's directory
+struct MaterialData
+{
+	std::string Name;
+	std::string Textures[(size_t)TextureType::Count];
+};
+
+// Geometry of one mesh, ready for the GPU but not on it yet
+struct MeshData
+{
+	std::string Name;
+	std::vector<Vertex> Vertices;
+	std::vector<unsigned int> Indices;
+	GLenum Primitive = GL_TRIANGLES; // GL_TRIANGLE_STRIP once the importer generated strips
+	uint32_t Material = UINT32_MAX; // index into ModelData::Materials
+	AABB Bounds;
+	MeshOptimizerStats Optimization; // filled in when the importer optimizes meshes
+};
+
+struct ModelData
+{
+	std::vector<MeshData> Meshes;
+	std::vector<MaterialData> Materials;
+};
+
+// Loads Wavefront OBJ (with its MTL) and binary glTF 2.0 (.glb).
+//
+// Import() does no GL work and can run on any thread, or in a tool (see
+// MeshConverter). The file is memory mapped and parsed in place with
+// std::from_chars; nothing is copied into strings. Both formats are parsed
+// with one task per independent unit:
+//   OBJ   line-aligned chunks of the file, then one task per mesh to weld
+//         the position/texcoord/normal triples into indexed vertices
+//   glTF  one task per primitive of every mesh node in the scene, with the
+//         node's transform baked into the vertices
+// Very large OBJ groups are cut into meshes of at most MaxTrianglesPerMesh so
+// welding them also spreads over the threads. With SetOptimizeMeshes every
+// mesh then goes through OptimizeMesh (see MeshOptimizer.h), again one task each,
+// and with SetGenerateStrips through GenerateTriangleStrips.
+//
+// Model::Create() then uploads everything on the GL thread:
+//
+//   ModelData data;
+//   if (importer.Import("sponza.obj", data))
+//       Model model = Model::Create(data, textureCache);
+class ModelImporter
+{
+public:
+	// threadCount 0 uses every hardware thread
+	explicit ModelImporter(unsigned int threadCount = 0);
+
+	// Prints what went wrong and returns false if the file can't be read
+	bool Import(const std::string& path, ModelData& model);
+
+	// Reorder vertices and triangles for the GPU after importing, off by default
+	inline void SetOptimizeMeshes(bool enabled) { m_OptimizeMeshes = enabled; }
+	// Store meshes as triangle strips where that takes fewer indices, off by default
+	inline void SetGenerateStrips(bool enabled) { m_GenerateStrips = enabled; }
+
+	static constexpr size_t MaxTrianglesPerMesh = 1 << 20;
+private:
+	unsigned int m_ThreadCount;
+	bool m_OptimizeMeshes = false;
+	bool m_GenerateStrips = false;
+
+	bool importObj(const std::string& path, ModelData& model);
+	bool importGlb(const std::string& path, ModelData& model);
+};
\ No newline at end of file
@@ -0,0 +1,267 @@
+#include "Profiler.h"
+
+#include "Renderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+RenderCounters g_RenderCounters;
+
+static int64_t steadyMicros()
+{
+	using namespace std::chrono;
+	return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+Profiler& Profiler::Get()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+Profiler::Profiler()
+	: m_StartTicks(steadyMicros())
+{}
+
+// The GL context is normally gone by the time statics are destroyed, so the
+// query objects are left for the driver to clean up with the context
+Profiler::~Profiler() = default;
+
+int64_t Profiler::NowMicros() const
+{
+	return steadyMicros() - m_StartTicks;
+}
+
+Profiler::ThreadBuffer& Profiler::threadBuffer()
+{
+	thread_local ThreadBuffer* buffer = nullptr;
+	if (!buffer)
+	{
+		std::lock_guard<std::mutex> lock(m_BuffersMutex);
+		m_Buffers.push_back(std::make_unique<ThreadBuffer>());
+		buffer = m_Buffers.back().get();
+		buffer->Thread = (uint32_t)m_Buffers.size();
+	}
+	return *buffer;
+}
+
+void Profiler::RecordCpuEvent(const char* name, int64_t startMicros, int64_t durationMicros)
+{
+	ThreadBuffer& buffer = threadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.Mutex);
+	buffer.Events.push_back({ name, startMicros, durationMicros, buffer.Thread });
+}
+
+void Profiler::BeginFrame()
+{
+	if (!m_GpuInitialized)
+	{
+		for (GpuFrame& frame : m_GpuFrames)
+		{
+			frame.Queries.resize(MaxGpuScopesPerFrame * 2);
+			GLCall(glGenQueries((GLsizei)frame.Queries.size(), frame.Queries.data()));
+		}
+		m_GpuInitialized = true;
+	}
+
+	// Reuse the oldest slot; its queries were issued GpuFrameLatency frames ago
+	m_GpuFrameIndex = (m_GpuFrameIndex + 1) % GpuFrameLatency;
+	GpuFrame& frame = m_GpuFrames[m_GpuFrameIndex];
+	collectGpuFrame(frame);
+	frame.Used = 0;
+	frame.Scopes.clear();
+
+	m_InFrame = true;
+	m_FrameStart = NowMicros();
+}
+
+void Profiler::collectGpuFrame(GpuFrame& frame)
+{
+	for (unsigned int i = 0; i < frame.Used; i++)
+	{
+		// Results that still aren't ready are dropped rather than waited for
+		GLuint available = 0;
+		GLCall(glGetQueryObjectuiv(frame.Queries[i * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available));
+		if (!available)
+			continue;
+
+		GLuint64 begin = 0, end = 0;
+		GLCall(glGetQueryObjectui64v(frame.Queries[i * 2], GL_QUERY_RESULT, &begin));
+		GLCall(glGetQueryObjectui64v(frame.Queries[i * 2 + 1], GL_QUERY_RESULT, &end));
+		int64_t durationMicros = (int64_t)((end - begin) / 1000);
+
+		// GPU clocks aren't synchronized with the CPU; place the event where the CPU issued it
+		if (m_GpuEvents.size() < MaxTraceEvents)
+			m_GpuEvents.push_back({ frame.Scopes[i].Name, frame.Scopes[i].CpuStart, durationMicros, 0 });
+		m_FrameTotals[std::string("GPU ") + frame.Scopes[i].Name] += (end - begin) / 1.0e6;
+	}
+}
+
+int Profiler::BeginGpuScope(const char* name)
+{
+	if (!m_InFrame)
+		return -1;
+
+	GpuFrame& frame = m_GpuFrames[m_GpuFrameIndex];
+	if (frame.Used >= MaxGpuScopesPerFrame)
+		return -1;
+
+	GLCall(glQueryCounter(frame.Queries[frame.Used * 2], GL_TIMESTAMP));
+	frame.Scopes.push_back({ name, NowMicros() });
+	return (int)frame.Used++;
+}
+
+void Profiler::EndGpuScope(int token)
+{
+	if (token < 0)
+		return;
+
+	GpuFrame& frame = m_GpuFrames[m_GpuFrameIndex];
+	GLCall(glQueryCounter(frame.Queries[token * 2 + 1], GL_TIMESTAMP));
+}
+
+void Profiler::EndFrame()
+{
+	if (!m_InFrame)
+		return;
+	m_InFrame = false;
+
+	int64_t now = NowMicros();
+	m_FrameTotals["Frame"] += (now - m_FrameStart) / 1000.0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_BuffersMutex);
+		for (auto& buffer : m_Buffers)
+		{
+			std::lock_guard<std::mutex> bufferLock(buffer->Mutex);
+			for (size_t i = buffer->Aggregated; i < buffer->Events.size(); i++)
+				m_FrameTotals[buffer->Events[i].Name] += buffer->Events[i].Duration / 1000.0;
+			// Keep the start of the capture for the trace, but never grow without bound
+			if (buffer->Events.size() > MaxTraceEvents)
+				buffer->Events.resize(MaxTraceEvents);
+			buffer->Aggregated = buffer->Events.size();
+		}
+	}
+
+	m_FrameTotals["DrawCalls"] = (double)g_RenderCounters.DrawCalls;
+	m_FrameTotals["StateChanges"] = (double)g_RenderCounters.StateChanges;
+	m_FrameTotals["TextureBinds"] = (double)g_RenderCounters.TextureBinds;
+	m_FrameTotals["StateChangesElided"] = (double)g_RenderCounters.StateChangesElided;
+	m_FrameTotals["UniformUploads"] = (double)g_RenderCounters.UniformUploads;
+	m_FrameTotals["BytesUploaded"] = (double)g_RenderCounters.BytesUploaded;
+	if (m_CounterTrace.size() < MaxTraceEvents)
+		m_CounterTrace.push_back({ m_FrameStart, g_RenderCounters });
+	g_RenderCounters = RenderCounters();
+
+	for (auto& [name, value] : m_FrameTotals)
+	{
+		std::vector<double>& history = m_History[name];
+		if (history.size() >= MaxHistoryFrames)
+			history.erase(history.begin());
+		history.push_back(value);
+	}
+	m_FrameTotals.clear();
+}
+
+std::vector<ProfileStats> Profiler::GetStats() const
+{
+	std::vector<ProfileStats> stats;
+	for (const auto& [name, history] : m_History)
+	{
+		if (history.empty())
+			continue;
+
+		std::vector<double> sorted = history;
+		std::sort(sorted.begin(), sorted.end());
+		double total = 0.0;
+		for (double value : sorted)
+			total += value;
+
+		ProfileStats entry;
+		entry.Name = name;
+		entry.Min = sorted.front();
+		entry.Max = sorted.back();
+		entry.Avg = total / sorted.size();
+		entry.P99 = sorted[(sorted.size() - 1) * 99 / 100];
+		entry.Frames = sorted.size();
+		stats.push_back(entry);
+	}
+	std::sort(stats.begin(), stats.end(),
+		[](const ProfileStats& a, const ProfileStats& b) { return a.Name < b.Name; });
+	return stats;
+}
+
+void Profiler::PrintStats(std::ostream& out) const
+{
+	out << std::left << std::setw(24) << "scope" << std::right
+		<< std::setw(12) << "min" << std::setw(12) << "avg"
+		<< std::setw(12) << "p99" << std::setw(12) << "max" << std::setw(8) << "frames" << std::endl;
+	for (const ProfileStats& entry : GetStats())
+	{
+		out << std::left << std::setw(24) << entry.Name << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(12) << entry.Min << std::setw(12) << entry.Avg
+			<< std::setw(12) << entry.P99 << std::setw(12) << entry.Max
+			<< std::setw(8) << entry.Frames << std::endl;
+	}
+	out << std::defaultfloat;
+}
+
+static void writeJsonString(std::ostream& out, const char* text)
+{
+	out << '"';
+	for (const char* c = text; *c; c++)
+	{
+		if (*c == '"' || *c == '\\')
+			out << '\\';
+		out << *c;
+	}
+	out << '"';
+}
+
+bool Profiler::WriteChromeTrace(const char* path) const
+{
+	std::ofstream out(path);
+	if (!out)
+	{
+		std::cout << "Failed to open " << path << std::endl;
+		return false;
+	}
+
+	out << "{\"traceEvents\":[\n";
+	out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+
+	auto writeEvent = [&out](const TraceEvent& event) {
+		out << ",\n{\"name\":";
+		writeJsonString(out, event.Name);
+		out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.Thread
+			<< ",\"ts\":" << event.Start << ",\"dur\":" << event.Duration << "}";
+	};
+
+	{
+		std::lock_guard<std::mutex> lock(m_BuffersMutex);
+		for (const auto& buffer : m_Buffers)
+		{
+			std::lock_guard<std::mutex> bufferLock(buffer->Mutex);
+			for (const TraceEvent& event : buffer->Events)
+				writeEvent(event);
+		}
+	}
+	for (const TraceEvent& event : m_GpuEvents)
+		writeEvent(event);
+
+	for (const auto& [timestamp, counters] : m_CounterTrace)
+	{
+		out << ",\n{\"name\":\"RenderCounters\",\"ph\":\"C\",\"pid\":1,\"ts\":" << timestamp
+			<< ",\"args\":{\"DrawCalls\":" << counters.DrawCalls
+			<< ",\"StateChanges\":" << counters.StateChanges
+			<< ",\"TextureBinds\":" << counters.TextureBinds
+			<< ",\"StateChangesElided\":" << counters.StateChangesElided
+			<< ",\"UniformUploads\":" << counters.UniformUploads
+			<< ",\"BytesUploaded\":" << counters.BytesUploaded << "}}";
+	}
+	out << "\n]}\n";
+	return (bool)out;
+}
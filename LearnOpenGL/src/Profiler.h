@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifndef PROFILE_ENABLED
+#define PROFILE_ENABLED 1
+#endif
+
+// Work done by the renderer during the current frame. Bumped through
+// PROFILE_COUNT from GLStateCache, Shader and the draw calls.
+struct RenderCounters
+{
+	uint64_t DrawCalls = 0;
+	uint64_t StateChanges = 0;   // program, VAO, buffer, texture and capability changes
+	uint64_t TextureBinds = 0;   // the texture part of StateChanges
+	uint64_t StateChangesElided = 0; // redundant changes GLStateCache skipped
+	uint64_t UniformUploads = 0;
+	uint64_t BytesUploaded = 0;
+};
+extern RenderCounters g_RenderCounters;
+
+// min/avg/p99 of one scope or counter over the recorded frames, in ms for scopes
+struct ProfileStats
+{
+	std::string Name;
+	double Min = 0.0;
+	double Avg = 0.0;
+	double P99 = 0.0;
+	double Max = 0.0;
+	size_t Frames = 0;
+};
+
+// Collects CPU scopes (into per-thread buffers) and GPU scopes
+// (GL_TIMESTAMP queries read back a few frames later so they never stall),
+// aggregates them per frame and exports a Chrome trace (chrome://tracing, Perfetto).
+//
+//   profiler.BeginFrame();
+//   { PROFILE_SCOPE("Update"); ... }
+//   { PROFILE_GPU_SCOPE("Opaque"); ... }
+//   profiler.EndFrame();
+class Profiler
+{
+public:
+	static Profiler& Get();
+
+	void BeginFrame();
+	void EndFrame();
+
+	void RecordCpuEvent(const char* name, int64_t startMicros, int64_t durationMicros);
+	// Returns a token for EndGpuScope, or -1 if no query was available
+	int BeginGpuScope(const char* name);
+	void EndGpuScope(int token);
+
+	std::vector<ProfileStats> GetStats() const;
+	void PrintStats(std::ostream& out) const;
+	bool WriteChromeTrace(const char* path) const;
+
+	int64_t NowMicros() const;
+
+	// Per-frame history kept for the stats; trace events are capped separately
+	static constexpr size_t MaxHistoryFrames = 4096;
+	static constexpr size_t MaxTraceEvents = 1 << 20;
+private:
+	Profiler();
+	~Profiler();
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	struct TraceEvent
+	{
+		const char* Name;
+		int64_t Start;    // microseconds since the profiler started
+		int64_t Duration;
+		uint32_t Thread;
+	};
+
+	struct ThreadBuffer
+	{
+		std::mutex Mutex; // only contended while the GL thread aggregates
+		std::vector<TraceEvent> Events;
+		size_t Aggregated = 0;
+		uint32_t Thread;
+	};
+
+	// GPU queries live in a ring of frames so results are read once they're ready
+	static constexpr unsigned int GpuFrameLatency = 4;
+	static constexpr unsigned int MaxGpuScopesPerFrame = 64;
+	struct GpuScope
+	{
+		const char* Name;
+		int64_t CpuStart;
+	};
+	struct GpuFrame
+	{
+		std::vector<unsigned int> Queries; // begin/end pairs
+		std::vector<GpuScope> Scopes;
+		unsigned int Used = 0;
+	};
+
+	ThreadBuffer& threadBuffer();
+	void collectGpuFrame(GpuFrame& frame);
+	void addSample(const std::string& name, double value);
+
+	int64_t m_StartTicks;
+	bool m_InFrame = false;
+	int64_t m_FrameStart = 0;
+
+	mutable std::mutex m_BuffersMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> m_Buffers;
+	std::vector<TraceEvent> m_GpuEvents;
+	std::vector<std::pair<int64_t, RenderCounters>> m_CounterTrace;
+
+	GpuFrame m_GpuFrames[GpuFrameLatency];
+	unsigned int m_GpuFrameIndex = 0;
+	bool m_GpuInitialized = false;
+
+	// Scope name -> duration per frame (ms), and the counters per frame
+	std::unordered_map<std::string, std::vector<double>> m_History;
+	std::unordered_map<std::string, double> m_FrameTotals;
+};
+
+// Times the enclosing block on the CPU
+class ProfileScope
+{
+public:
+	ProfileScope(const char* name)
+		: m_Name(name), m_Start(Profiler::Get().NowMicros())
+	{}
+	~ProfileScope()
+	{
+		Profiler& profiler = Profiler::Get();
+		profiler.RecordCpuEvent(m_Name, m_Start, profiler.NowMicros() - m_Start);
+	}
+private:
+	const char* m_Name;
+	int64_t m_Start;
+};
+
+// Times the GL commands issued in the enclosing block on the GPU
+class GpuProfileScope
+{
+public:
+	GpuProfileScope(const char* name)
+		: m_Token(Profiler::Get().BeginGpuScope(name))
+	{}
+	~GpuProfileScope()
+	{
+		Profiler::Get().EndGpuScope(m_Token);
+	}
+private:
+	int m_Token;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if PROFILE_ENABLED
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+#define PROFILE_COUNT(counter, n) (g_RenderCounters.counter += (n))
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_GPU_SCOPE(name)
+#define PROFILE_COUNT(counter, n)
+#endif
\ No newline at end of file
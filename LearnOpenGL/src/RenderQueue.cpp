@@ -0,0 +1,151 @@
+#include "RenderQueue.h"
+
+#include "GLStateCache.h"
+#include "Profiler.h"
+#include "Renderer.h"
+
+#include <algorithm>
+
+static constexpr unsigned int DEPTH_BITS = 24;
+static constexpr unsigned int VAO_BITS = 13;
+static constexpr unsigned int MATERIAL_BITS = 16;
+static constexpr unsigned int SHADER_BITS = 10;
+
+static inline uint64_t bits(uint64_t value, unsigned int count)
+{
+	return value & ((1ull << count) - 1);
+}
+
+void RenderQueue::Begin(const glm::vec3& viewPosition, float farPlane)
+{
+	m_ViewPosition = viewPosition;
+	m_InverseFar = 1.0f / farPlane;
+	m_Entries.clear();
+	m_Packets.clear();
+}
+
+void RenderQueue::Submit(Mesh& mesh, Shader& shader, const glm::mat4& model, bool translucent)
+{
+	glm::vec3 offset = glm::vec3(model[3]) - m_ViewPosition;
+	float distance = std::min(glm::length(offset) * m_InverseFar, 1.0f);
+	uint64_t depth = (uint64_t)(distance * ((1u << DEPTH_BITS) - 1));
+	uint64_t state = bits(shader.ID, SHADER_BITS) << (MATERIAL_BITS + VAO_BITS)
+		| bits(mesh.GetMaterialKey(), MATERIAL_BITS) << VAO_BITS
+		| bits(mesh.GetDrawRange().VertexArray, VAO_BITS);
+
+	uint64_t key;
+	if (translucent)
+		key = 1ull << 63 | bits(~depth, DEPTH_BITS) << (SHADER_BITS + MATERIAL_BITS + VAO_BITS) | state;
+	else
+		key = state << DEPTH_BITS | depth;
+
+	m_Entries.push_back({ key, (uint32_t)m_Packets.size() });
+	m_Packets.push_back({ &mesh, &shader, model, translucent });
+}
+
+// LSD radix sort, one byte per pass. Passes where every key has the same
+// byte are skipped, which for typical scenes removes most of them.
+void RenderQueue::sort()
+{
+	size_t count = m_Entries.size();
+	uint32_t histograms[8][256] = {};
+	for (const SortEntry& entry : m_Entries)
+	{
+		for (unsigned int pass = 0; pass < 8; pass++)
+			histograms[pass][(entry.key >> (pass * 8)) & 0xFF]++;
+	}
+
+	m_Scratch.resize(count);
+	SortEntry* src = m_Entries.data();
+	SortEntry* dst = m_Scratch.data();
+	for (unsigned int pass = 0; pass < 8; pass++)
+	{
+		uint32_t* histogram = histograms[pass];
+		if (histogram[(src[0].key >> (pass * 8)) & 0xFF] == count)
+			continue;
+
+		uint32_t offsets[256];
+		uint32_t sum = 0;
+		for (unsigned int i = 0; i < 256; i++)
+		{
+			offsets[i] = sum;
+			sum += histogram[i];
+		}
+		for (size_t i = 0; i < count; i++)
+			dst[offsets[(src[i].key >> (pass * 8)) & 0xFF]++] = src[i];
+		std::swap(src, dst);
+	}
+	if (src != m_Entries.data())
+		m_Entries.swap(m_Scratch);
+}
+
+RenderQueueStats RenderQueue::Flush()
+{
+	PROFILE_SCOPE("RenderQueue::Flush");
+	RenderQueueStats stats;
+	stats.Packets = m_Packets.size();
+	if (m_Entries.empty())
+		return stats;
+
+	sort();
+
+	GLStateCache& state = GLStateCache::Get();
+	Shader* shader = nullptr;
+	UniformHandle modelLoc;
+	uint32_t material = 0;
+	bool firstMaterial = true;
+	bool translucent = false;
+
+	for (const SortEntry& entry : m_Entries)
+	{
+		Packet& packet = m_Packets[entry.packet];
+		if (packet.translucent && !translucent)
+		{
+			state.SetEnabled(GL_BLEND, true);
+			state.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			state.DepthMask(false);
+			translucent = true;
+		}
+
+		if (packet.shader != shader)
+		{
+			shader = packet.shader;
+			shader->use();
+			modelLoc = shader->getUniformHandle(m_ModelUniform);
+			stats.ShaderChanges++;
+		}
+
+		packet.mesh->BindSamplers(*shader);
+		packet.mesh->BindLayers(*shader);
+		if (firstMaterial || packet.mesh->GetMaterialKey() != material)
+		{
+			material = packet.mesh->GetMaterialKey();
+			firstMaterial = false;
+			stats.MaterialChanges++;
+		}
+		for (const Mesh::TextureBinding& binding : packet.mesh->GetTextureBindings())
+		{
+			if (state.BindTexture(binding.unit, binding.target, binding.id))
+				stats.TextureBinds++;
+		}
+
+		DrawRange range = packet.mesh->GetDrawRange();
+		if (state.BindVertexArray(range.VertexArray))
+			stats.VertexArrayChanges++;
+
+		shader->set(modelLoc, packet.model);
+		packet.mesh->BindQuantization(*shader);
+		range.Draw();
+		PROFILE_COUNT(DrawCalls, 1);
+	}
+
+	if (translucent)
+	{
+		state.DepthMask(true);
+		state.SetEnabled(GL_BLEND, false);
+	}
+
+	m_Packets.clear();
+	m_Entries.clear();
+	return stats;
+}
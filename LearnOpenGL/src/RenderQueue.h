@@ -0,0 +1,65 @@
+#pragma once
+#include "Mesh.h"
+#include "Shader.h"
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+struct RenderQueueStats
+{
+	size_t Packets = 0;
+	size_t ShaderChanges = 0;
+	size_t MaterialChanges = 0;
+	size_t TextureBinds = 0;
+	size_t VertexArrayChanges = 0;
+};
+
+// Collects draws for a frame and submits them sorted by a packed 64-bit key,
+// so state only changes where the key does:
+//
+//   opaque       0 | shader:10 | material:16 | vertex array:13 | depth:24
+//   translucent  1 | ~depth:24 | shader:10 | material:16 | vertex array:13
+//
+// Opaque draws are grouped by state and go front to back within a group;
+// translucent draws come last, back to front, with blending on and depth
+// writes off. The ids in the key are truncated, so a collision only costs a
+// state change; submission compares the real bindings.
+//
+// Every shader is expected to have a "model" uniform. Per-frame uniforms
+// (view, projection) are the caller's to set before Flush().
+class RenderQueue
+{
+public:
+	// Depth keys are the distance to viewPosition as a fraction of farPlane
+	void Begin(const glm::vec3& viewPosition, float farPlane);
+	void Submit(Mesh& mesh, Shader& shader, const glm::mat4& model, bool translucent = false);
+	RenderQueueStats Flush();
+
+	inline size_t GetPacketCount() const { return m_Packets.size(); }
+private:
+	struct Packet
+	{
+		Mesh* mesh;
+		Shader* shader;
+		glm::mat4 model;
+		bool translucent;
+	};
+
+	struct SortEntry
+	{
+		uint64_t key;
+		uint32_t packet;
+	};
+
+	void sort();
+
+	glm::vec3 m_ViewPosition = glm::vec3(0.0f);
+	float m_InverseFar = 0.01f;
+	std::vector<Packet> m_Packets;
+	// Kept between frames so a steady scene doesn't allocate
+	std::vector<SortEntry> m_Entries;
+	std::vector<SortEntry> m_Scratch;
+	const std::string m_ModelUniform = "model";
+};
\ No newline at end of file
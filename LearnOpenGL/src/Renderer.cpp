@@ -2,6 +2,8 @@
 
 #include <iostream>
 
+GLCallSite g_GLCallSite;
+
 void GLClearError()
 {
 	while (glGetError() != GL_NO_ERROR);
@@ -17,3 +19,47 @@ bool GLLogCall(const char* function, const char* file, int line)
 	}
 	return true;
 }
+
+#if GL_ERROR_CHECK == GL_ERROR_CHECK_CALLBACK
+static void APIENTRY GLDebugCallback(GLenum, GLenum, GLuint id, GLenum severity,
+	GLsizei, const GLchar* message, const void*)
+{
+	if (severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+		return;
+
+	std::cout << "[OpenGL Debug] (" << id << "): " << message << std::endl
+		<< "    near " << g_GLCallSite.function << " "
+		<< g_GLCallSite.file << ":line " << g_GLCallSite.line << std::endl;
+}
+#endif
+
+void GLInitErrorChecking()
+{
+#if GL_ERROR_CHECK == GL_ERROR_CHECK_CALLBACK
+	if (!GLAD_GL_VERSION_4_3)
+	{
+		std::cout << "[OpenGL] glDebugMessageCallback needs GL 4.3, errors won't be reported" << std::endl;
+		return;
+	}
+	// Not GL_DEBUG_OUTPUT_SYNCHRONOUS: the driver may report on its own schedule,
+	// which is what keeps this mode free of per-call round trips
+	glEnable(GL_DEBUG_OUTPUT);
+	glDebugMessageCallback(GLDebugCallback, nullptr);
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+#endif
+}
+
+bool GLCheckFrameErrors([[maybe_unused]] const char* label)
+{
+#if GL_ERROR_CHECK == GL_ERROR_CHECK_FRAME
+	bool ok = true;
+	while (GLenum error = glGetError())
+	{
+		std::cout << "[OpenGL Error] (" << error << "): during " << label << std::endl;
+		ok = false;
+	}
+	return ok;
+#else
+	return true;
+#endif
+}
@@ -1,10 +1,70 @@
 #pragma once
 
 #include <glad/glad.h>
-#define ASSERT(x) if (!(x)) __debugbreak();
+
+#if defined(_MSC_VER)
+#define DEBUG_BREAK() __debugbreak()
+#elif defined(__GNUC__) || defined(__clang__)
+#define DEBUG_BREAK() __builtin_trap()
+#else
+#include <cstdlib>
+#define DEBUG_BREAK() std::abort()
+#endif
+
+#define ASSERT(x) if (!(x)) DEBUG_BREAK();
+
+// How GLCall checks for OpenGL errors. Define GL_ERROR_CHECK to one of these in
+// the project's preprocessor definitions to override the default:
+//   GL_ERROR_CHECK_NONE      GLCall(x) is just x. Default for release builds.
+//   GL_ERROR_CHECK_CALL      glGetError before and after every call, break on error. Default for debug builds.
+//   GL_ERROR_CHECK_FRAME     no per-call checks, GLCheckFrameErrors() reports once per frame.
+//   GL_ERROR_CHECK_CALLBACK  the driver reports errors asynchronously through glDebugMessageCallback
+//                            (needs a GL 4.3 context); GLCall only records the call site.
+#define GL_ERROR_CHECK_NONE     0
+#define GL_ERROR_CHECK_CALL     1
+#define GL_ERROR_CHECK_FRAME    2
+#define GL_ERROR_CHECK_CALLBACK 3
+
+#ifndef GL_ERROR_CHECK
+#ifdef NDEBUG
+#define GL_ERROR_CHECK GL_ERROR_CHECK_NONE
+#else
+#define GL_ERROR_CHECK GL_ERROR_CHECK_CALL
+#endif
+#endif
+
+#if GL_ERROR_CHECK == GL_ERROR_CHECK_CALL
 #define GLCall(x) GLClearError();\
 	x;\
 	ASSERT(GLLogCall(#x, __FILE__, __LINE__))
+#elif GL_ERROR_CHECK == GL_ERROR_CHECK_CALLBACK
+#define GLCall(x) GLSetCallSite(#x, __FILE__, __LINE__);\
+	x
+#else
+#define GLCall(x) x
+#endif
 
 void GLClearError();
 bool GLLogCall(const char* function, const char* file, int line);
+
+// Call once the context is current and GLAD is loaded; installs the debug callback if enabled
+void GLInitErrorChecking();
+// Drains glGetError once per frame in GL_ERROR_CHECK_FRAME mode, no-op otherwise
+bool GLCheckFrameErrors(const char* label);
+
+// Last GLCall, used by the debug callback to tell roughly where an error came from.
+// Messages are asynchronous, so it may be a few calls past the one that failed.
+struct GLCallSite
+{
+	const char* function = "";
+	const char* file = "";
+	int line = 0;
+};
+extern GLCallSite g_GLCallSite;
+
+inline void GLSetCallSite(const char* function, const char* file, int line)
+{
+	g_GLCallSite.function = function;
+	g_GLCallSite.file = file;
+	g_GLCallSite.line = line;
+}
@@ -6,8 +6,19 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "GLStateCache.h"
+#include "Profiler.h"
 #include "Renderer.h"
 
+// A uniform location resolved ahead of time, for setting uniforms in hot loops
+struct UniformHandle
+{
+	int location = -1;
+};
+
 class Shader
 {
 public:
@@ -92,66 +103,176 @@ public:
 		// Delete the shaders that are no longer necessary now that they're linked
 		GLCall(glDeleteShader(vertex));
 		GLCall(glDeleteShader(fragment));
+
+		cacheUniformLocations();
 	}
 	// use/activate shader
 	void use()
 	{
-		GLCall(glUseProgram(ID));
+		GLStateCache::Get().UseProgram(ID);
 	}
 
 	// Utility uniform functions
 	void setBool(const std::string& name, bool value) const
 	{
-		GLCall(glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value));
+		GLCall(glUniform1i(getUniformLocation(name), (int)value));
+		PROFILE_COUNT(UniformUploads, 1);
 	}
 	void setInt(const std::string& name, int value) const
 	{
-		GLCall(glUniform1i(glGetUniformLocation(ID, name.c_str()), value));
+		GLCall(glUniform1i(getUniformLocation(name), value));
+		PROFILE_COUNT(UniformUploads, 1);
 	}
 	void setFloat(const std::string& name, float value) const
 	{
-		GLCall(glUniform1f(glGetUniformLocation(ID, name.c_str()), value));
+		GLCall(glUniform1f(getUniformLocation(name), value));
+		PROFILE_COUNT(UniformUploads, 1);
 	}
 
 	void setVec2(const std::string& name, const glm::vec2& value) const
 	{
-		GLCall(glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]));
+		GLCall(glUniform2fv(getUniformLocation(name), 1, &value[0]));
+		PROFILE_COUNT(UniformUploads, 1);
 	}
 	void setVec2(const std::string& name, float x, float y) const
 	{
-		GLCall(glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y));
+		GLCall(glUniform2f(getUniformLocation(name), x, y));
+		PROFILE_COUNT(UniformUploads, 1);
 	}
 
 	void setVec3(const std::string& name, const glm::vec3& value) const
 	{
-		GLCall(glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]));
+		GLCall(glUniform3fv(getUniformLocation(name), 1, &value[0]));
+		PROFILE_COUNT(UniformUploads, 1);
 	}
 	void setVec3(const std::string& name, float x, float y, float z) const
 	{
-		GLCall(glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z));
+		GLCall(glUniform3f(getUniformLocation(name), x, y, z));
+		PROFILE_COUNT(UniformUploads, 1);
 	}
 
 	void setVec4(const std::string& name, const glm::vec4& value) const
 	{
-		GLCall(glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]));
+		GLCall(glUniform4fv(getUniformLocation(name), 1, &value[0]));
+		PROFILE_COUNT(UniformUploads, 1);
 	}
 	void setVec4(const std::string& name, float x, float y, float z, float w) const
 	{
-		GLCall(glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w));
+		GLCall(glUniform4f(getUniformLocation(name), x, y, z, w));
+		PROFILE_COUNT(UniformUploads, 1);
 	}
 
 	void setMat2(const std::string& name, const glm::mat2& mat) const
 	{
-		GLCall(glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]));
+		GLCall(glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]));
+		PROFILE_COUNT(UniformUploads, 1);
 	}
 
 	void setMat3(const std::string& name, const glm::mat3& mat) const
 	{
-		GLCall(glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]));
+		GLCall(glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]));
+		PROFILE_COUNT(UniformUploads, 1);
 	}
 
 	void setMat4(const std::string& name, const glm::mat4& mat) const
 	{
-		GLCall(glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]));
+		GLCall(glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]));
+		PROFILE_COUNT(UniformUploads, 1);
+	}
+
+	// Resolve a uniform once and reuse the handle with set() in hot loops
+	UniformHandle getUniformHandle(const std::string& name) const
+	{
+		return UniformHandle{ getUniformLocation(name) };
+	}
+
+	void set(UniformHandle handle, int value) const
+	{
+		GLCall(glUniform1i(handle.location, value));
+		PROFILE_COUNT(UniformUploads, 1);
+	}
+	void set(UniformHandle handle, float value) const
+	{
+		GLCall(glUniform1f(handle.location, value));
+		PROFILE_COUNT(UniformUploads, 1);
+	}
+	void set(UniformHandle handle, const glm::vec2& value) const
+	{
+		GLCall(glUniform2fv(handle.location, 1, &value[0]));
+		PROFILE_COUNT(UniformUploads, 1);
+	}
+	void set(UniformHandle handle, const glm::vec3& value) const
+	{
+		GLCall(glUniform3fv(handle.location, 1, &value[0]));
+		PROFILE_COUNT(UniformUploads, 1);
+	}
+	void set(UniformHandle handle, const glm::vec4& value) const
+	{
+		GLCall(glUniform4fv(handle.location, 1, &value[0]));
+		PROFILE_COUNT(UniformUploads, 1);
+	}
+	void set(UniformHandle handle, const glm::mat2& mat) const
+	{
+		GLCall(glUniformMatrix2fv(handle.location, 1, GL_FALSE, &mat[0][0]));
+		PROFILE_COUNT(UniformUploads, 1);
+	}
+	void set(UniformHandle handle, const glm::mat3& mat) const
+	{
+		GLCall(glUniformMatrix3fv(handle.location, 1, GL_FALSE, &mat[0][0]));
+		PROFILE_COUNT(UniformUploads, 1);
+	}
+	void set(UniformHandle handle, const glm::mat4& mat) const
+	{
+		GLCall(glUniformMatrix4fv(handle.location, 1, GL_FALSE, &mat[0][0]));
+		PROFILE_COUNT(UniformUploads, 1);
+	}
+
+private:
+	// Uniform name -> location, filled once after linking
+	std::unordered_map<std::string, int> m_UniformLocations;
+
+	int getUniformLocation(const std::string& name) const
+	{
+		auto it = m_UniformLocations.find(name);
+		// -1 is silently ignored by glUniform*, same as an inactive uniform
+		return it != m_UniformLocations.end() ? it->second : -1;
+	}
+
+	// Ask the linked program for all of its active uniforms so that the set*
+	// functions never have to call glGetUniformLocation again
+	void cacheUniformLocations()
+	{
+		int count = 0;
+		int maxLength = 0;
+		GLCall(glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count));
+		GLCall(glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength));
+
+		std::vector<char> nameBuffer(maxLength > 0 ? maxLength : 1);
+		for (int i = 0; i < count; i++)
+		{
+			int length = 0;
+			int size = 0;
+			GLenum type;
+			GLCall(glGetActiveUniform(ID, (GLuint)i, maxLength, &length, &size, &type, nameBuffer.data()));
+
+			std::string name(nameBuffer.data(), length);
+			int location = glGetUniformLocation(ID, name.c_str());
+			if (location == -1)
+				continue; // uniform block member
+
+			m_UniformLocations[name] = location;
+
+			// Arrays, even of one element, are reported as "name[0]"; also register "name" and every element
+			if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+			{
+				std::string base = name.substr(0, name.size() - 3);
+				m_UniformLocations[base] = location;
+				for (int j = 1; j < size; j++)
+				{
+					std::string element = base + "[" + std::to_string(j) + "]";
+					m_UniformLocations[element] = glGetUniformLocation(ID, element.c_str());
+				}
+			}
+		}
 	}
 };
\ No newline at end of file
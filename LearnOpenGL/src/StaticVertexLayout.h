@@ -0,0 +1,93 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include "VertexBufferLayout.h"
+
+// How a C++ attribute type is described to glVertexAttribPointer.
+// Types without a specialization fail to compile when used in a layout.
+template<typename T>
+struct VertexAttribFormat;
+
+#define VERTEX_ATTRIB_FORMAT(T, glType, glCount, glNormalized) \
+	template<> struct VertexAttribFormat<T> \
+	{ \
+		static constexpr unsigned int type = glType; \
+		static constexpr unsigned int count = glCount; \
+		static constexpr unsigned char normalized = glNormalized; \
+	}
+
+VERTEX_ATTRIB_FORMAT(float,        GL_FLOAT,              1, GL_FALSE);
+VERTEX_ATTRIB_FORMAT(glm::vec2,    GL_FLOAT,              2, GL_FALSE);
+VERTEX_ATTRIB_FORMAT(glm::vec3,    GL_FLOAT,              3, GL_FALSE);
+VERTEX_ATTRIB_FORMAT(glm::vec4,    GL_FLOAT,              4, GL_FALSE);
+VERTEX_ATTRIB_FORMAT(Half2,        GL_HALF_FLOAT,         2, GL_FALSE);
+VERTEX_ATTRIB_FORMAT(Half4,        GL_HALF_FLOAT,         4, GL_FALSE);
+VERTEX_ATTRIB_FORMAT(PackedNormal, GL_INT_2_10_10_10_REV, 4, GL_TRUE);
+VERTEX_ATTRIB_FORMAT(glm::u8vec4,  GL_UNSIGNED_BYTE,      4, GL_TRUE);
+VERTEX_ATTRIB_FORMAT(glm::i16vec2, GL_SHORT,              2, GL_TRUE);
+VERTEX_ATTRIB_FORMAT(glm::u16vec2, GL_UNSIGNED_SHORT,     2, GL_TRUE);
+VERTEX_ATTRIB_FORMAT(glm::i16vec4, GL_SHORT,              4, GL_TRUE);
+VERTEX_ATTRIB_FORMAT(glm::u16vec4, GL_UNSIGNED_SHORT,     4, GL_TRUE);
+
+#undef VERTEX_ATTRIB_FORMAT
+
+// One attribute of a vertex struct: its C++ type and its byte offset
+template<typename T, size_t Offset>
+struct VertexAttrib
+{
+	using Type = T;
+	static constexpr size_t offset = Offset;
+};
+
+// VERTEX_ATTRIB(Vertex, Normal) describes the Normal member of Vertex
+#define VERTEX_ATTRIB(VertexType, member) \
+	VertexAttrib<decltype(VertexType::member), offsetof(VertexType, member)>
+
+template<size_t N>
+struct StaticVertexLayout
+{
+	std::array<VertexBufferElement, N> Elements;
+	unsigned int Stride;
+};
+
+template<typename... Attribs>
+constexpr bool AttribsAreContiguous()
+{
+	constexpr size_t offsets[] = { Attribs::offset... };
+	constexpr size_t sizes[] = { sizeof(typename Attribs::Type)... };
+	size_t expected = 0;
+	for (size_t i = 0; i < sizeof...(Attribs); i++)
+	{
+		if (offsets[i] != expected)
+			return false;
+		expected += sizes[i];
+	}
+	return true;
+}
+
+// Builds the attribute offsets and stride of VertexType at compile time:
+//   constexpr auto layout = MakeLayout<Vertex, VERTEX_ATTRIB(Vertex, Position), VERTEX_ATTRIB(Vertex, Normal)>();
+// The attributes must be listed in declaration order and cover the whole struct,
+// so adding a member to the vertex without updating its layout fails to build.
+template<typename VertexType, typename... Attribs>
+constexpr StaticVertexLayout<sizeof...(Attribs)> MakeLayout()
+{
+	static_assert(sizeof...(Attribs) > 0, "a vertex layout needs at least one attribute");
+	static_assert((sizeof(typename Attribs::Type) + ...) == sizeof(VertexType),
+		"vertex layout doesn't cover every member of the vertex");
+	static_assert(AttribsAreContiguous<Attribs...>(),
+		"vertex attributes must be listed in declaration order without padding");
+
+	return StaticVertexLayout<sizeof...(Attribs)>{
+		{ { VertexBufferElement{
+			VertexAttribFormat<typename Attribs::Type>::type,
+			VertexAttribFormat<typename Attribs::Type>::count,
+			VertexAttribFormat<typename Attribs::Type>::normalized,
+			(unsigned int)Attribs::offset }... } },
+		(unsigned int)sizeof(VertexType)
+	};
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "StreamBuffer.h"
+
+#include "GLStateCache.h"
+#include "Profiler.h"
+#include "Renderer.h"
+
+StreamBuffer::StreamBuffer(unsigned int frameSize, unsigned int stride, unsigned int frameCount)
+	: m_FrameSize((frameSize + stride - 1) / stride * stride), m_Stride(stride), m_FrameCount(frameCount),
+	  m_Fences(frameCount, nullptr)
+{
+	// Regions start on a vertex boundary so that every offset maps to a whole base vertex
+	unsigned int id;
+	GLCall(glGenBuffers(1, &id));
+	m_Handle.Reset(id);
+	Bind();
+
+	GLsizeiptr totalSize = (GLsizeiptr)m_FrameSize * m_FrameCount;
+	if (GLAD_GL_VERSION_4_4)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLCall(glBufferStorage(GL_ARRAY_BUFFER, totalSize, nullptr, flags));
+		GLCall(m_PersistentData = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, totalSize, flags));
+	}
+	else
+	{
+		GLCall(glBufferData(GL_ARRAY_BUFFER, totalSize, nullptr, GL_STREAM_DRAW));
+	}
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	for (GLsync fence : m_Fences)
+	{
+		if (fence)
+			glDeleteSync(fence);
+	}
+	if (m_MappedData || m_PersistentData)
+	{
+		Bind();
+		GLCall(glUnmapBuffer(GL_ARRAY_BUFFER));
+	}
+}
+
+StreamAllocation StreamBuffer::Allocate(unsigned int vertexCount)
+{
+	unsigned int size = vertexCount * m_Stride;
+	if (m_Head + size > m_FrameSize)
+		return StreamAllocation();
+
+	StreamAllocation allocation;
+	allocation.Offset = m_Frame * m_FrameSize + m_Head;
+	allocation.BaseVertex = allocation.Offset / m_Stride;
+	if (size == 0)
+		return allocation;
+
+	if (m_PersistentData)
+		allocation.Data = m_PersistentData + allocation.Offset;
+	else
+	{
+		// Map once per Flush, so earlier allocations stay writable
+		if (!m_MappedData)
+		{
+			Bind();
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_FLUSH_EXPLICIT_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+			GLCall(m_MappedData = (char*)glMapBufferRange(GL_ARRAY_BUFFER, allocation.Offset, m_FrameSize - m_Head, flags));
+			if (!m_MappedData)
+				return StreamAllocation();
+			m_MapStart = m_Head;
+		}
+		allocation.Data = m_MappedData + (m_Head - m_MapStart);
+	}
+	m_Head += size;
+	PROFILE_COUNT(BytesUploaded, size);
+	return allocation;
+}
+
+void StreamBuffer::Flush()
+{
+	if (!m_MappedData)
+		return;
+
+	// Only the allocated part goes to GL, not the whole mapped region
+	Bind();
+	GLCall(glFlushMappedBufferRange(GL_ARRAY_BUFFER, 0, m_Head - m_MapStart));
+	GLCall(glUnmapBuffer(GL_ARRAY_BUFFER));
+	m_MappedData = nullptr;
+}
+
+void StreamBuffer::EndFrame()
+{
+	Flush();
+	m_Fences[m_Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	m_Frame = (m_Frame + 1) % m_FrameCount;
+	m_Head = 0;
+
+	// Block until the GPU has finished reading this region frameCount frames ago
+	GLsync fence = m_Fences[m_Frame];
+	if (fence)
+	{
+		GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		while (true)
+		{
+			GLenum result = glClientWaitSync(fence, waitFlags, 1000000); // 1ms
+			if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+				break;
+			waitFlags = 0;
+		}
+		glDeleteSync(fence);
+		m_Fences[m_Frame] = nullptr;
+	}
+}
+
+void StreamBuffer::Bind() const
+{
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, m_Handle.Get());
+}
+
+void StreamBuffer::Unbind() const
+{
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "GLHandle.h"
+#include <glad/glad.h>
+#include <vector>
+
+// A range of vertices handed out by StreamBuffer::Allocate
+struct StreamAllocation
+{
+	void* Data = nullptr;        // write the vertices here until Flush(); nullptr if the frame is full or the count is 0
+	unsigned int Offset = 0;     // byte offset inside the buffer
+	unsigned int BaseVertex = 0; // pass as 'first' to glDrawArrays or as basevertex to glDrawElementsBaseVertex
+};
+
+// Ring of frameCount regions for geometry that changes every frame. The CPU
+// writes into one region while the GPU is still reading the previous ones;
+// each region is fenced when the frame ends and only reused once the GPU is done.
+//
+// Uses a persistent, coherent mapping when GL 4.4 is available. Otherwise the
+// rest of the current region is mapped unsynchronized (the fences already
+// guarantee it is safe) with explicit flushing on the first Allocate, and
+// allocations hand out pointers into that one mapping until Flush() unmaps it.
+//
+//   StreamAllocation a = stream.Allocate(count);
+//   memcpy(a.Data, vertices, count * stride);
+//   stream.Flush();
+//   glDrawArrays(GL_TRIANGLES, a.BaseVertex, count);
+//   ...
+//   stream.EndFrame();
+class StreamBuffer
+{
+public:
+	StreamBuffer(unsigned int frameSize, unsigned int stride, unsigned int frameCount = 3);
+	~StreamBuffer();
+
+	StreamBuffer(const StreamBuffer&) = delete;
+	StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+	StreamAllocation Allocate(unsigned int vertexCount);
+	// Makes the allocations visible to GL; call before drawing from them.
+	// Without persistent mapping this ends the Data pointers handed out so far.
+	void Flush();
+	// Fences the current region and moves on to the next one, waiting for the GPU if needed
+	void EndFrame();
+
+	void Bind() const;
+	void Unbind() const;
+
+	inline unsigned int GetStride() const { return m_Stride; }
+	inline bool IsPersistent() const { return m_PersistentData != nullptr; }
+private:
+	GLHandle<BufferDeleter> m_Handle;
+	unsigned int m_FrameSize;
+	unsigned int m_Stride;
+	unsigned int m_FrameCount;
+
+	unsigned int m_Frame = 0;
+	unsigned int m_Head = 0; // bytes used in the current region
+	char* m_PersistentData = nullptr;
+	// GL 3.3 path: mapping of the current region from m_MapStart to its end
+	char* m_MappedData = nullptr;
+	unsigned int m_MapStart = 0;
+	std::vector<GLsync> m_Fences;
+};
\ No newline at end of file
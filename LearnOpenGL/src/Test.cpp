@@ -1,27 +1,93 @@
 #include <glad/glad.h>
+#ifndef LEARNOPENGL_HEADLESS_ONLY
 #include <GLFW/glfw3.h>
-#include "stb_image.h"
+#endif
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
 
 #include "Shader.h"
+#include "Benchmarks.h"
+#include "BVH.h"
 #include "Camera.h"
+#include "Frustum.h"
 #include "Renderer.h"
 #include "VertexBuffer.h"
+#include "GeometryPool.h"
 #include "IndexBuffer.h"
-
+#include "Framebuffer.h"
+#include "GLStateCache.h"
+#include "HeadlessContext.h"
+#include "Mesh.h"
+#include "Model.h"
+#include "ModelImporter.h"
+#include "Profiler.h"
+#include "RenderQueue.h"
+#include "TextureArray.h"
+#include "TextureCache.h"
+#include "TextureLoader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
 #include "VertexArray.h"
 
 
 const unsigned int SCR_WIDTH = 1024;
 const unsigned int SCR_HEIGHT = 768;
 
+// Builds without GLFW (see CMakeLists.txt) can only run headless
+#ifndef LEARNOPENGL_HEADLESS_ONLY
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
+#endif
+
+// Command line: --headless [frames] [--image out.ppm] [--timings out.csv] [--trace out.json]
+//               [--meshes count] [--model scene.obj|scene.glb|scene.bmesh] [--optimize] [--strips] [--quantize] [--pool]
+//               [--texture-arrays]
+//               --bench-<name> [size]
+struct RunOptions
+{
+	bool headless = false;
+	unsigned int frames = 600;
+	const char* imagePath = nullptr;
+	const char* timingsPath = nullptr;
+	const char* tracePath = nullptr;
+	// Extra cubes drawn one mesh at a time through the render queue
+	unsigned int meshes = 0;
+	// Imported model drawn through the render queue as well
+	const char* modelPath = nullptr;
+	// Run imported meshes through MeshOptimizer
+	bool optimizeModel = false;
+	// Store imported meshes as triangle strips where that takes fewer indices
+	bool stripModel = false;
+	// Upload imported meshes as QuantizedVertex, drawn with 3.3.shader.quantized.vs
+	bool quantizeModel = false;
+	// Allocate the cubes and the model from one GeometryPool
+	bool usePool = false;
+	// Put the imported model's textures in texture array layers, drawn with 3.3.shader.material.array.fs
+	bool textureArrays = false;
+	// Run one of Benchmarks.h headless instead of the scene
+	const char* benchmark = nullptr;
+	unsigned int benchmarkSize = 0;
+};
+RunOptions parseArgs(int argc, char** argv);
+void reportFrameTimes(const std::vector<double>& frameTimes, const char* csvPath);
+void reportOptimization(const ModelData& model);
+void reportQuantization(const ModelData& model);
+void reportIndexMemory(const std::vector<const Mesh*>& meshes);
+void reportGeometryPool(const GeometryPoolStats& stats);
+std::string preferBaked(const std::string& path);
 
 
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
@@ -33,39 +99,70 @@ float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
 
-int main()
+int main(int argc, char** argv)
 {
-	// ========== INIT ==========
+	RunOptions options = parseArgs(argc, argv);
 
-	// Initialize GLFW and set the version to 3
-	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	// Make sure the OpenGL version that we are using is the core profile
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-	// Vertex Data
-	// Let's Make a window!
-	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
-	if (!window) {
-		std::cout << "Failed to create GLFW window" << std::endl;
-		glfwTerminate();
-		return -1;
+	// ========== INIT ==========
+	HeadlessContext headless;
+#ifdef LEARNOPENGL_HEADLESS_ONLY
+	options.headless = true;
+#else
+	GLFWwindow* window = nullptr;
+#endif
+	if (options.headless)
+	{
+		if (!headless.Create())
+			return -1;
 	}
-	glfwMakeContextCurrent(window);
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	glfwSetCursorPosCallback(window, mouse_callback);
-
-	// Initialize GLAD; NOTE: must make glfw context current before initializing GLAD. Order matters here.
-	// Pass GLAD the function to load the OpenGL function pointers, glfwGetProcAddress defines the correct function based on OS
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) { 
-		std::cout << "Failed to initialize GLAD" << std::endl;
+#ifndef LEARNOPENGL_HEADLESS_ONLY
+	else
+	{
+		// Initialize GLFW and set the version to 3
+		glfwInit();
+#if GL_ERROR_CHECK == GL_ERROR_CHECK_CALLBACK
+		// glDebugMessageCallback is core since 4.3
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+#else
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+#endif
+		// Make sure the OpenGL version that we are using is the core profile
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+		// Vertex Data
+		// Let's Make a window!
+		window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+		if (!window) {
+			std::cout << "Failed to create GLFW window" << std::endl;
+			glfwTerminate();
+			return -1;
+		}
+		glfwMakeContextCurrent(window);
+		glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		glfwSetCursorPosCallback(window, mouse_callback);
+
+		// Initialize GLAD; NOTE: must make glfw context current before initializing GLAD. Order matters here.
+		// Pass GLAD the function to load the OpenGL function pointers, glfwGetProcAddress defines the correct function based on OS
+		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) { 
+			std::cout << "Failed to initialize GLAD" << std::endl;
+		}
 	}
+#endif
+	GLInitErrorChecking();
+	if (options.benchmark)
+		return RunBenchmark(options.benchmark, options.benchmarkSize);
 	
-	Shader ourShader("3.3.shader.coordsys.vs", "3.3.shader.coordsys.fs");
+	// Baked copies (TextureBaker) are block compressed and can't be layers of
+	// the RGBA8 texture array, so with those the boxes sample two textures
+	std::string boxTexturePaths[2] = { preferBaked("container.jpg"), preferBaked("awesomeface.png") };
+	bool bakedBoxTextures = boxTexturePaths[0] != "container.jpg" || boxTexturePaths[1] != "awesomeface.png";
+	Shader ourShader("3.3.shader.instanced.vs", bakedBoxTextures ? "3.3.shader.coordsys.fs" : "3.3.shader.array.fs");
 
-	GLCall(glEnable(GL_DEPTH_TEST));
+	GLStateCache::Get().SetEnabled(GL_DEPTH_TEST, true);
 	{
 		// ========== DATA ==========
 
@@ -147,114 +244,449 @@ int main()
 		layout.Push<float>(3);
 		layout.Push<float>(2);
 		va.AddBuffer(vb, layout);
+
+		// Per-instance model matrices, so every box goes out in a single draw call
+		const unsigned int cubeCount = sizeof(cubePositions) / sizeof(cubePositions[0]);
+		std::vector<glm::mat4> modelMatrices(cubeCount);
+		for (unsigned int i = 0; i < cubeCount; i++)
+		{
+			glm::mat4 model = glm::mat4(1.0f);
+			model = glm::translate(model, cubePositions[i]);
+			float angle = 20.0f * i;
+			model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+			modelMatrices[i] = model;
+		}
+		VertexBuffer instanceVB(modelMatrices.data(), (unsigned int)(modelMatrices.size() * sizeof(glm::mat4)), GL_DYNAMIC_DRAW);
+		VertexBufferLayout instanceLayout;
+		instanceLayout.Push<glm::mat4>(1);
+		va.AddBuffer(instanceVB, instanceLayout, 1);
+
+		// World bounds of everything in the scene: the boxes first, then the
+		// stress meshes. Only visible boxes are copied into the instance buffer.
+		std::vector<AABB> sceneBounds;
+		const AABB unitCube(glm::vec3(-0.5f), glm::vec3(0.5f));
+		for (const glm::mat4& model : modelMatrices)
+			sceneBounds.push_back(unitCube.Transformed(model));
+		std::vector<glm::mat4> visibleMatrices;
+		std::vector<uint32_t> visible;
 		// TEXTURE
 		// =========
-		// Texture 1
-		// ---------
-		unsigned int texture1;
-		GLCall(glGenTextures(1, &texture1));
-		GLCall(glBindTexture(GL_TEXTURE_2D, texture1)); // Texture operations now apply to the object at texture
-
-		// texture wrapping parameters
-		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
-		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
-		// texture filtering parameters
-		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-
-		// load image, create texture, and generate mipmaps
-		int width, height, nrChannels;
-		stbi_set_flip_vertically_on_load(true);
-		unsigned char* data = stbi_load("container.jpg", &width, &height, &nrChannels, 0);
-		if (data)
+		// Both images are 512x512, so they share one texture array and a single
+		// binding. Worker threads decode them; the layers show white until
+		// Update() uploads them. Baked copies upload immediately through the cache.
+		auto startupStart = std::chrono::steady_clock::now();
+		TextureLoader textureLoader;
+		TextureCache textureCache(textureLoader);
+		TextureArrayAllocator textureArrays(2);
+		TextureLayer texture1, texture2;
+		TextureHandle bakedTexture1, bakedTexture2;
+		bool texturesReported = false;
+
+		ourShader.use();
+		if (bakedBoxTextures)
 		{
-			GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data));
-			GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+			bakedTexture1 = textureCache.Acquire(boxTexturePaths[0]);
+			bakedTexture2 = textureCache.Acquire(boxTexturePaths[1]);
+			ourShader.setInt("texture1", 0);
+			ourShader.setInt("texture2", 1);
 		}
 		else
 		{
-			std::cout << "Failed to load texture1" << std::endl;
+			texture1 = textureArrays.Allocate(512, 512);
+			texture2 = textureArrays.Allocate(512, 512);
+			textureLoader.LoadLayer("container.jpg", *texture1.Array, texture1.Layer);
+			textureLoader.LoadLayer("awesomeface.png", *texture2.Array, texture2.Layer);
+			ourShader.setInt("textures", 0);
+			ourShader.setInt("layer1", texture1.Layer);
+			ourShader.setInt("layer2", texture2.Layer);
 		}
-		stbi_image_free(data);
-
-		// Texture 2
-		// ---------
-		unsigned int texture2;
-		GLCall(glGenTextures(1, &texture2));
-		GLCall(glBindTexture(GL_TEXTURE_2D, texture2));
 
-		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
-		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
-		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+		UniformHandle projectionLoc = ourShader.getUniformHandle("projection");
+		UniformHandle viewLoc = ourShader.getUniformHandle("view");
+
+		// Stress scene: a grid of cubes, each its own draw, spread over a few
+		// meshes and materials and submitted in no particular order
+		Shader meshShader("3.3.shader.mesh.vs", "3.3.shader.material.fs");
+		UniformHandle meshProjectionLoc = meshShader.getUniformHandle("projection");
+		UniformHandle meshViewLoc = meshShader.getUniformHandle("view");
+		// Imported meshes loaded with --quantize decode their vertices in this one
+		Shader quantizedShader("3.3.shader.quantized.vs", "3.3.shader.material.fs");
+		UniformHandle quantizedProjectionLoc = quantizedShader.getUniformHandle("projection");
+		UniformHandle quantizedViewLoc = quantizedShader.getUniformHandle("view");
+		// And with --texture-arrays in this one, unless they are quantized too
+		Shader layeredShader("3.3.shader.mesh.vs", "3.3.shader.material.array.fs");
+		UniformHandle layeredProjectionLoc = layeredShader.getUniformHandle("projection");
+		UniformHandle layeredViewLoc = layeredShader.getUniformHandle("view");
+		if (options.textureArrays && options.quantizeModel)
+			std::cout << "--texture-arrays is ignored with --quantize" << std::endl;
+		// Declared first so it outlives the meshes allocated from it
+		GeometryPool geometryPool;
+		GeometryPool* pool = options.usePool ? &geometryPool : nullptr;
+		std::vector<std::unique_ptr<Mesh>> meshes;
+		std::vector<std::pair<Mesh*, glm::mat4>> meshInstances;
+		RenderQueue renderQueue;
+		if (options.meshes > 0)
+		{
+			std::vector<Vertex> cubeVertices(36);
+			std::vector<unsigned int> cubeIndices(36);
+			AABB cubeBounds;
+			for (unsigned int i = 0; i < 36; i++)
+			{
+				cubeVertices[i].Position = glm::vec3(vertices[i * 5], vertices[i * 5 + 1], vertices[i * 5 + 2]);
+				cubeVertices[i].Normal = glm::vec3(0.0f);
+				cubeVertices[i].TexCoords = glm::vec2(vertices[i * 5 + 3], vertices[i * 5 + 4]);
+				cubeIndices[i] = i;
+				cubeBounds.Expand(cubeVertices[i].Position);
+			}
+			unsigned int materials[] = { textureLoader.Load("container.jpg"), textureLoader.Load("awesomeface.png") };
+			for (unsigned int i = 0; i < 8; i++)
+			{
+				std::vector<Texture> textures = { { materials[i % 2], TextureType::Diffuse } };
+				if (pool)
+					meshes.push_back(std::make_unique<Mesh>(pool->Allocate(cubeVertices, cubeIndices), textures, cubeBounds));
+				else
+					meshes.push_back(std::make_unique<Mesh>(cubeVertices, cubeIndices, textures));
+			}
 
-		data = stbi_load("awesomeface.png", &width, &height, &nrChannels, 0);
-		if (data)
+			unsigned int side = (unsigned int)std::ceil(std::sqrt((float)options.meshes));
+			for (unsigned int i = 0; i < options.meshes; i++)
+			{
+				glm::vec3 gridPosition((float)(i % side) - side * 0.5f, -4.0f, -(float)(i / side) - 5.0f);
+				glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), gridPosition * 1.5f), glm::vec3(0.5f));
+				meshInstances.push_back({ meshes[(i * 7) % meshes.size()].get(), model });
+				sceneBounds.push_back(meshInstances.back().first->GetBounds().Transformed(model));
+			}
+		}
+		TextureArrayAllocator modelTextureArrays;
+		TextureArrayAllocator* modelArrays = options.textureArrays && !options.quantizeModel ? &modelTextureArrays : nullptr;
+		Model importedModel;
+		size_t firstModelInstance = meshInstances.size();
+		if (options.modelPath)
 		{
-			GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data));
-			GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+			// Baked meshes skip the importer and upload from the mapped file
+			auto loadStart = std::chrono::steady_clock::now();
+			bool loaded = false;
+			if (std::filesystem::path(options.modelPath).extension() == ".bmesh")
+				loaded = Model::LoadBaked(options.modelPath, textureCache, importedModel, pool, modelArrays);
+			else
+			{
+				ModelImporter importer;
+				importer.SetOptimizeMeshes(options.optimizeModel);
+				importer.SetGenerateStrips(options.stripModel);
+				ModelData modelData;
+				loaded = importer.Import(options.modelPath, modelData);
+				if (loaded && options.optimizeModel)
+					reportOptimization(modelData);
+				if (loaded && options.quantizeModel)
+				{
+					if (pool)
+						std::cout << "--quantize is ignored with --pool, pooled meshes keep full vertices" << std::endl;
+					else
+						reportQuantization(modelData);
+				}
+				if (loaded)
+					importedModel = Model::Create(modelData, textureCache, pool, options.quantizeModel, modelArrays);
+			}
+			if (loaded)
+			{
+				size_t indices = 0;
+				for (const Mesh& mesh : importedModel.Meshes)
+					indices += mesh.GetIndexCount();
+				double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+				std::cout << options.modelPath << ": " << importedModel.Meshes.size() << " meshes, " << indices
+					<< " indices, loaded in " << loadMs << " ms" << std::endl;
+				for (Mesh& mesh : importedModel.Meshes)
+				{
+					meshInstances.push_back({ &mesh, glm::mat4(1.0f) });
+					sceneBounds.push_back(mesh.GetBounds());
+				}
+			}
 		}
-		else
+		std::vector<const Mesh*> sceneMeshes;
+		for (const auto& mesh : meshes)
+			sceneMeshes.push_back(mesh.get());
+		for (const Mesh& mesh : importedModel.Meshes)
+			sceneMeshes.push_back(&mesh);
+		reportIndexMemory(sceneMeshes);
+		if (pool)
+			reportGeometryPool(pool->GetStats());
+		RenderQueueStats queueStats;
+		BVH sceneBVH;
+		sceneBVH.Build(sceneBounds);
+		// Only the windowed loop picks
+		[[maybe_unused]] bool picking = false;
+
+		// Headless runs draw into an offscreen target instead of the window
+		std::unique_ptr<Framebuffer> offscreen;
+		if (options.headless)
 		{
-			std::cout << "Failed to load texture2" << std::endl;
+			offscreen = std::make_unique<Framebuffer>(SCR_WIDTH, SCR_HEIGHT);
+			GLCall(glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT));
 		}
-		stbi_image_free(data);
-
-
-		ourShader.use();
-		ourShader.setInt("texture1", 0);
-		ourShader.setInt("texture2", 1);
+		std::vector<double> frameTimes;
+		unsigned int frame = 0;
+		Profiler& profiler = Profiler::Get();
 
 		// ========== RENDERING ==========
 		// Set up Render loop
-		while (!glfwWindowShouldClose(window)) {
-			// Time Logic
-			float currentFrame = glfwGetTime();
-			deltaTime = currentFrame - lastFrame;
-			lastFrame = currentFrame;
-
-			// input
-			processInput(window);
-
-			// rendering commands
-			GLCall(glClearColor(0.2f, 0.3f, 0.3f, 1.0f));
-			GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
-
-			// bind texture
-			GLCall(glActiveTexture(GL_TEXTURE0));
-			GLCall(glBindTexture(GL_TEXTURE_2D, texture1));
-			GLCall(glActiveTexture(GL_TEXTURE1));
-			GLCall(glBindTexture(GL_TEXTURE_2D, texture2));
+#ifdef LEARNOPENGL_HEADLESS_ONLY
+		while (frame < options.frames) {
+#else
+		while (options.headless ? frame < options.frames : !glfwWindowShouldClose(window)) {
+#endif
+			auto frameStart = std::chrono::steady_clock::now();
+			profiler.BeginFrame();
+
+			if (options.headless)
+			{
+				// Fixed timestep and camera path so runs are comparable
+				deltaTime = 1.0f / 60.0f;
+				scriptedCamera(camera, frame, options.frames);
+			}
+#ifndef LEARNOPENGL_HEADLESS_ONLY
+			else
+			{
+				// Time Logic
+				float currentFrame = glfwGetTime();
+				deltaTime = currentFrame - lastFrame;
+				lastFrame = currentFrame;
+
+				// input
+				processInput(window);
+
+				// Click to pick whatever is under the crosshair
+				bool click = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+				if (click && !picking)
+				{
+					Ray ray = camera.GetScreenRay(SCR_WIDTH * 0.5f, SCR_HEIGHT * 0.5f, (float)SCR_WIDTH, (float)SCR_HEIGHT);
+					RayHit hit = sceneBVH.Raycast(ray);
+					if (hit.IsValid())
+						std::cout << "picked object " << hit.Object << " at " << hit.Distance << std::endl;
+					else
+						std::cout << "nothing picked, nearest object is " << sceneBVH.FindNearest(camera.Position) << std::endl;
+				}
+				picking = click;
+			}
+#endif
 
-			ourShader.use();
+			textureCache.Update();
 
-			glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			ourShader.setMat4("projection", projection);
+			{
+				PROFILE_SCOPE("Render");
+				PROFILE_GPU_SCOPE("Render");
+
+				// rendering commands
+				GLCall(glClearColor(0.2f, 0.3f, 0.3f, 1.0f));
+				GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+
+				// bind texture
+				if (bakedBoxTextures)
+				{
+					GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, bakedTexture1.GetID());
+					GLStateCache::Get().BindTexture(1, GL_TEXTURE_2D, bakedTexture2.GetID());
+				}
+				else
+					texture1.Array->Bind(0);
+
+				ourShader.use();
+
+				glm::mat4 projection = camera.GetProjectionMatrix((float)SCR_WIDTH / (float)SCR_HEIGHT);
+				ourShader.set(projectionLoc, projection);
+
+				glm::mat4 view = camera.GetViewMatrix();
+				ourShader.set(viewLoc, view);
+
+				Frustum frustum(projection * view);
+
+				// Split what can be seen into boxes and stress meshes
+				sceneBVH.QueryFrustum(frustum, visible);
+				visibleMatrices.clear();
+				renderQueue.Begin(camera.Position, 100.0f);
+				for (uint32_t index : visible)
+				{
+					if (index < cubeCount)
+						visibleMatrices.push_back(modelMatrices[index]);
+					else
+					{
+						auto& [mesh, transform] = meshInstances[index - cubeCount];
+						bool layered = modelArrays && index - cubeCount >= firstModelInstance;
+						renderQueue.Submit(*mesh, mesh->IsQuantized() ? quantizedShader : layered ? layeredShader : meshShader, transform);
+					}
+				}
+
+				// render the boxes
+				if (!visibleMatrices.empty())
+				{
+					instanceVB.SetData(visibleMatrices.data(), (unsigned int)(visibleMatrices.size() * sizeof(glm::mat4)));
+					va.Bind();
+					GLCall(glDrawArraysInstanced(GL_TRIANGLES, 0, 36, (GLsizei)visibleMatrices.size()));
+					PROFILE_COUNT(DrawCalls, 1);
+				}
+
+				if (renderQueue.GetPacketCount() > 0)
+				{
+					meshShader.use();
+					meshShader.set(meshProjectionLoc, projection);
+					meshShader.set(meshViewLoc, view);
+					if (options.quantizeModel)
+					{
+						quantizedShader.use();
+						quantizedShader.set(quantizedProjectionLoc, projection);
+						quantizedShader.set(quantizedViewLoc, view);
+					}
+					if (modelArrays)
+					{
+						layeredShader.use();
+						layeredShader.set(layeredProjectionLoc, projection);
+						layeredShader.set(layeredViewLoc, view);
+					}
+					queueStats = renderQueue.Flush();
+				}
+			}
 
-			glm::mat4 view = camera.GetViewMatrix();
-			ourShader.setMat4("view", view);
+			GLCheckFrameErrors("frame");
 
-			// render the box
-			va.Bind();
-			for (unsigned int i = 0; i < 10; i++)
+			if (options.headless)
 			{
-				glm::mat4 model = glm::mat4(1.0f);
-				model = glm::translate(model, cubePositions[i]);
-				float angle = 20.0f * i;
-				model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-				ourShader.setMat4("model", model);
-
-				glDrawArrays(GL_TRIANGLES, 0, 36);
+				// Wait for the GPU so the time covers the whole frame
+				GLCall(glFinish());
+				std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - frameStart;
+				frameTimes.push_back(elapsed.count());
+			}
+#ifndef LEARNOPENGL_HEADLESS_ONLY
+			else
+			{
+				glfwSwapBuffers(window);
+				glfwPollEvents();
 			}
+#endif
+			profiler.EndFrame();
+
+			auto sinceStartup = [&]() {
+				return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupStart).count();
+			};
+			if (frame == 0)
+				std::cout << "first frame after " << sinceStartup() << " ms" << std::endl;
+			if (!texturesReported && textureLoader.IsIdle())
+			{
+				TextureCacheStats cacheStats = textureCache.GetStats();
+				std::cout << "textures loaded after " << sinceStartup() << " ms (frame " << frame << "), "
+					<< cacheStats.Entries << " cached, " << cacheStats.Bytes / 1024 << " KB, " << cacheStats.Layers << " in texture arrays"
+					<< std::endl;
+				texturesReported = true;
+			}
+			frame++;
+		}
 
-			glfwSwapBuffers(window);
-			glfwPollEvents();
+		if (options.headless)
+		{
+			reportFrameTimes(frameTimes, options.timingsPath);
+			if (!meshInstances.empty())
+				std::cout << "render queue: " << queueStats.Packets << " packets, " << queueStats.ShaderChanges << " shader changes, "
+					<< queueStats.MaterialChanges << " material changes, " << queueStats.TextureBinds << " texture binds, "
+					<< queueStats.VertexArrayChanges << " vertex array changes" << std::endl;
+			profiler.PrintStats(std::cout);
+			if (options.tracePath)
+				profiler.WriteChromeTrace(options.tracePath);
+			if (options.imagePath)
+				offscreen->SaveImage(options.imagePath);
 		}
 	}
-	glfwTerminate();
+#ifndef LEARNOPENGL_HEADLESS_ONLY
+	if (!options.headless)
+		glfwTerminate();
+#endif
 	return 0;
 }
 
+// Uses the TextureBaker output next to an image when there is one
+std::string preferBaked(const std::string& path)
+{
+	std::string baked = std::filesystem::path(path).replace_extension(".btex").string();
+	return std::filesystem::exists(baked) ? baked : path;
+}
+
+RunOptions parseArgs(int argc, char** argv)
+{
+	RunOptions options;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--headless") == 0)
+		{
+			options.headless = true;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				options.frames = (unsigned int)std::atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--image") == 0 && i + 1 < argc)
+			options.imagePath = argv[++i];
+		else if (strcmp(argv[i], "--timings") == 0 && i + 1 < argc)
+			options.timingsPath = argv[++i];
+		else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+			options.tracePath = argv[++i];
+		else if (strcmp(argv[i], "--meshes") == 0 && i + 1 < argc)
+			options.meshes = (unsigned int)std::atoi(argv[++i]);
+		else if (strcmp(argv[i], "--model") == 0 && i + 1 < argc)
+			options.modelPath = argv[++i];
+		else if (strcmp(argv[i], "--optimize") == 0)
+			options.optimizeModel = true;
+		else if (strcmp(argv[i], "--strips") == 0)
+			options.stripModel = true;
+		else if (strcmp(argv[i], "--quantize") == 0)
+			options.quantizeModel = true;
+		else if (strcmp(argv[i], "--pool") == 0)
+			options.usePool = true;
+		else if (strcmp(argv[i], "--texture-arrays") == 0)
+			options.textureArrays = true;
+		else if (strncmp(argv[i], "--bench-", 8) == 0)
+		{
+			options.headless = true;
+			options.benchmark = argv[i] + 8;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				options.benchmarkSize = (unsigned int)std::atoi(argv[++i]);
+		}
+		else
+			std::cout << "Unknown argument " << argv[i] << std::endl;
+	}
+	return options;
+}
+
+// Dolly back from the boxes while panning left and right
+void scriptedCamera(Camera& camera, unsigned int frame, unsigned int frameCount)
+{
+	float t = frameCount > 1 ? (float)frame / (float)(frameCount - 1) : 0.0f;
+	camera.Position = glm::vec3(0.0f, 0.0f, 3.0f + 10.0f * t);
+	camera.Yaw = YAW + 30.0f * std::sin(t * 2.0f * 3.14159265f);
+	camera.Pitch = PITCH;
+	camera.ProcessMouseMovement(0.0f, 0.0f); // recompute Front/Right/Up
+}
+
+void reportFrameTimes(const std::vector<double>& frameTimes, const char* csvPath)
+{
+	if (frameTimes.empty())
+		return;
+
+	std::vector<double> sorted = frameTimes;
+	std::sort(sorted.begin(), sorted.end());
+	double total = 0.0;
+	for (double t : sorted)
+		total += t;
+
+	std::cout << "frames: " << sorted.size()
+		<< "  min: " << sorted.front() << " ms"
+		<< "  avg: " << total / sorted.size() << " ms"
+		<< "  p99: " << sorted[(sorted.size() - 1) * 99 / 100] << " ms"
+		<< "  max: " << sorted.back() << " ms" << std::endl;
+
+	if (csvPath)
+	{
+		std::ofstream csv(csvPath);
+		csv << "frame,ms\n";
+		for (size_t i = 0; i < frameTimes.size(); i++)
+			csv << i << "," << frameTimes[i] << "\n";
+	}
+}
+
+#ifndef LEARNOPENGL_HEADLESS_ONLY
 void framebuffer_size_callback(GLFWwindow * window, int width, int height)
 {
 	GLCall(glViewport(0, 0, width, height));
@@ -301,4 +733,78 @@ void processInput(GLFWwindow* window)
 		camera.ProcessKeyboard(RIGHT, deltaTime);
 	}
 }
+#endif
+
+// Position, normal and texture coordinate error of the quantized vertices, over every mesh
+void reportQuantization(const ModelData& model)
+{
+	QuantizationError total;
+	double vertices = 0.0, position = 0.0, normal = 0.0;
+	for (const MeshData& mesh : model.Meshes)
+	{
+		QuantizationError error = MeasureQuantizationError(mesh.Vertices, QuantizeVertices(mesh.Vertices));
+		double weight = (double)mesh.Vertices.size();
+		vertices += weight;
+		position += error.AvgPosition * weight;
+		normal += error.AvgNormalDegrees * weight;
+		total.MaxPosition = std::max(total.MaxPosition, error.MaxPosition);
+		total.MaxNormalDegrees = std::max(total.MaxNormalDegrees, error.MaxNormalDegrees);
+		total.MaxTexCoord = std::max(total.MaxTexCoord, error.MaxTexCoord);
+		total.BytesBefore += error.BytesBefore;
+		total.BytesAfter += error.BytesAfter;
+	}
+	if (vertices == 0.0)
+		return;
+	std::cout << "quantized " << model.Meshes.size() << " meshes: " << total.BytesBefore / 1024 << " -> " << total.BytesAfter / 1024
+		<< " KB of vertices, position error " << position / vertices << " avg / " << total.MaxPosition << " max, normal "
+		<< normal / vertices << " / " << total.MaxNormalDegrees << " degrees, texcoord " << total.MaxTexCoord << " max" << std::endl;
+}
+
+// Vertex cache and fetch efficiency of the whole model, weighted by triangles
+void reportOptimization(const ModelData& model)
+{
+	double triangles = 0.0, acmr[2] = {}, overfetch[2] = {};
+	for (const MeshData& mesh : model.Meshes)
+	{
+		double weight = (double)mesh.Optimization.After.TriangleCount;
+		triangles += weight;
+		acmr[0] += mesh.Optimization.Before.Cache.ACMR * weight;
+		acmr[1] += mesh.Optimization.After.Cache.ACMR * weight;
+		overfetch[0] += mesh.Optimization.Before.Overfetch * weight;
+		overfetch[1] += mesh.Optimization.After.Overfetch * weight;
+	}
+	if (triangles == 0.0)
+		return;
+	std::cout << "optimized " << model.Meshes.size() << " meshes: ACMR " << acmr[0] / triangles << " -> " << acmr[1] / triangles
+		<< ", overfetch " << overfetch[0] / triangles << " -> " << overfetch[1] / triangles << std::endl;
+}
+
+// GPU memory the index buffers take, against storing every index in 32 bits
+void reportIndexMemory(const std::vector<const Mesh*>& meshes)
+{
+	if (meshes.empty())
+		return;
+	size_t bytes = 0, bytes32 = 0, byType[3] = {}, strips = 0;
+	for (const Mesh* mesh : meshes)
+	{
+		DrawRange range = mesh->GetDrawRange();
+		bytes += (size_t)range.IndexCount * IndexBuffer::TypeSize(range.IndexType);
+		bytes32 += (size_t)range.IndexCount * sizeof(uint32_t);
+		byType[range.IndexType == GL_UNSIGNED_BYTE ? 0 : range.IndexType == GL_UNSIGNED_SHORT ? 1 : 2]++;
+		if (range.Primitive == GL_TRIANGLE_STRIP)
+			strips++;
+	}
+	std::cout << "index memory: " << meshes.size() << " buffers (" << byType[0] << " 8-bit, " << byType[1] << " 16-bit, "
+		<< byType[2] << " 32-bit, " << strips << " strips), " << bytes / 1024.0 << " KB, "
+		<< bytes32 / 1024.0 << " KB as 32-bit" << std::endl;
+}
+
+void reportGeometryPool(const GeometryPoolStats& stats)
+{
+	if (stats.Pages == 0)
+		return;
+	std::cout << "geometry pool: " << stats.Allocations << " meshes in " << stats.Pages << " pages, vertices "
+		<< 100.0 * stats.VerticesUsed / stats.VertexCapacity << "% used, indices "
+		<< 100.0 * stats.IndexBytesUsed / stats.IndexCapacity << "% used, " << stats.FreeRanges << " free ranges" << std::endl;
+}
 
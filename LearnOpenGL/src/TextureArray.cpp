@@ -0,0 +1,112 @@
+#include "TextureArray.h"
+
+#include "GLStateCache.h"
+#include "MipGenerator.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+static GLenum formatForChannels(unsigned int channels)
+{
+	switch (channels)
+	{
+	case 1: return GL_RED;
+	case 2: return GL_RG;
+	case 3: return GL_RGB;
+	default: return GL_RGBA;
+	}
+}
+
+TextureArray::TextureArray(unsigned int width, unsigned int height, unsigned int layerCapacity)
+	: m_Width(width), m_Height(height), m_LevelCount(1), m_LayerCapacity(layerCapacity)
+{
+	while ((std::max(width, height) >> m_LevelCount) > 0)
+		m_LevelCount++;
+
+	unsigned int id;
+	GLCall(glGenTextures(1, &id));
+	m_Handle.Reset(id);
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D_ARRAY, id);
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	for (unsigned int level = 0; level < m_LevelCount; level++)
+	{
+		unsigned int w = std::max(1u, width >> level), h = std::max(1u, height >> level);
+		GLCall(glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, w, h, layerCapacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	}
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+int TextureArray::AllocateLayer()
+{
+	if (m_LayerCount == m_LayerCapacity)
+		return -1;
+
+	// New storage is undefined, so fill every level of the layer with the placeholder
+	unsigned int layer = m_LayerCount++;
+	std::vector<uint8_t> white((size_t)m_Width * m_Height * 4, 255);
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D_ARRAY, m_Handle.Get());
+	for (unsigned int level = 0; level < m_LevelCount; level++)
+	{
+		unsigned int w = std::max(1u, m_Width >> level), h = std::max(1u, m_Height >> level);
+		GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, w, h, 1, GL_RGBA, GL_UNSIGNED_BYTE, white.data()));
+	}
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	return (int)layer;
+}
+
+void TextureArray::SetLayer(unsigned int layer, const uint8_t* pixels, unsigned int channels)
+{
+	ASSERT(layer < m_LayerCount);
+	std::vector<MipLevel> mips = GenerateMips(pixels, m_Width, m_Height, channels);
+	GLenum format = formatForChannels(channels);
+
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D_ARRAY, m_Handle.Get());
+	GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+	GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, m_Width, m_Height, 1, format, GL_UNSIGNED_BYTE, pixels));
+	size_t bytes = (size_t)m_Width * m_Height * channels;
+	for (size_t i = 0; i < mips.size(); i++)
+	{
+		GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)i + 1, 0, 0, layer, mips[i].width, mips[i].height, 1, format,
+			GL_UNSIGNED_BYTE, mips[i].pixels.data()));
+		bytes += mips[i].pixels.size();
+	}
+	GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	PROFILE_COUNT(BytesUploaded, bytes);
+}
+
+void TextureArray::Bind(unsigned int slot) const
+{
+	GLStateCache::Get().BindTexture(slot, GL_TEXTURE_2D_ARRAY, m_Handle.Get());
+}
+
+void TextureArray::Unbind() const
+{
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+TextureArrayAllocator::TextureArrayAllocator(unsigned int layersPerArray)
+{
+	int maxLayers = 256;
+	GLCall(glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers));
+	m_LayersPerArray = std::clamp(layersPerArray, 1u, (unsigned int)maxLayers);
+}
+
+TextureLayer TextureArrayAllocator::Allocate(unsigned int width, unsigned int height)
+{
+	for (auto& array : m_Arrays)
+	{
+		if (array->GetWidth() != width || array->GetHeight() != height)
+			continue;
+		int layer = array->AllocateLayer();
+		if (layer >= 0)
+			return { array.get(), (unsigned int)layer };
+	}
+
+	m_Arrays.push_back(std::make_unique<TextureArray>(width, height, m_LayersPerArray));
+	TextureArray* array = m_Arrays.back().get();
+	return { array, (unsigned int)array->AllocateLayer() };
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "GLHandle.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A GL_TEXTURE_2D_ARRAY of same-sized RGBA8 layers with full mip chains.
+// Storage for every layer is reserved up front.
+// Meshes that sample layers of one array share a single binding, so drawing
+// them back to back needs no texture binds in between.
+class TextureArray
+{
+public:
+	TextureArray(unsigned int width, unsigned int height, unsigned int layerCapacity);
+
+	// Returns the new layer, or -1 once the array is full. The layer starts out white.
+	int AllocateLayer();
+	// Uploads level 0 and mips built by GenerateMips; pixels must match the array size
+	void SetLayer(unsigned int layer, const uint8_t* pixels, unsigned int channels);
+
+	void Bind(unsigned int slot = 0) const;
+	void Unbind() const;
+
+	inline unsigned int GetID() const { return m_Handle.Get(); }
+	inline unsigned int GetWidth() const { return m_Width; }
+	inline unsigned int GetHeight() const { return m_Height; }
+	inline unsigned int GetLevelCount() const { return m_LevelCount; }
+	inline unsigned int GetLayerCount() const { return m_LayerCount; }
+	inline unsigned int GetLayerCapacity() const { return m_LayerCapacity; }
+private:
+	GLHandle<TextureDeleter> m_Handle;
+	unsigned int m_Width;
+	unsigned int m_Height;
+	unsigned int m_LevelCount;
+	unsigned int m_LayerCount = 0;
+	unsigned int m_LayerCapacity;
+};
+
+struct TextureLayer
+{
+	TextureArray* Array = nullptr;
+	unsigned int Layer = 0;
+
+	inline explicit operator bool() const { return Array != nullptr; }
+};
+
+// Hands out layers, opening a new array for each size the first array of
+// that size has run out of room for
+class TextureArrayAllocator
+{
+public:
+	// layersPerArray is clamped to GL_MAX_ARRAY_TEXTURE_LAYERS
+	explicit TextureArrayAllocator(unsigned int layersPerArray = 16);
+
+	TextureLayer Allocate(unsigned int width, unsigned int height);
+
+	inline const std::vector<std::unique_ptr<TextureArray>>& GetArrays() const { return m_Arrays; }
+private:
+	unsigned int m_LayersPerArray;
+	std::vector<std::unique_ptr<TextureArray>> m_Arrays;
+};
\ No newline at end of file
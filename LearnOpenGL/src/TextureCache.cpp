@@ -0,0 +1,202 @@
+#include "TextureCache.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+static std::string canonicalKey(const std::string& path, bool flipVertically)
+{
+	std::error_code error;
+	std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+	std::string key = error ? path : canonical.generic_string();
+	return flipVertically ? key + "|flip" : key;
+}
+
+// 64-bit FNV-1a over the whole file and the orientation, which makes it a
+// different texture; 0 if the file can't be read
+static uint64_t hashFile(const std::string& path, bool flipVertically)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return 0;
+
+	uint64_t hash = 14695981039346656037ull;
+	char buffer[64 * 1024];
+	while (file)
+	{
+		file.read(buffer, sizeof(buffer));
+		std::streamsize count = file.gcount();
+		for (std::streamsize i = 0; i < count; i++)
+		{
+			hash ^= (unsigned char)buffer[i];
+			hash *= 1099511628211ull;
+		}
+	}
+	hash ^= flipVertically ? 1 : 0;
+	hash *= 1099511628211ull;
+	return hash;
+}
+
+TextureCache::TextureCache(TextureLoader& loader, size_t memoryBudget)
+	: m_Loader(loader), m_Budget(memoryBudget)
+{}
+
+TextureHandle TextureCache::Acquire(const std::string& path, bool flipVertically)
+{
+	std::string key = canonicalKey(path, flipVertically);
+	auto alias = m_Aliases.find(key);
+	if (alias != m_Aliases.end())
+		key = alias->second;
+
+	auto it = m_Entries.find(key);
+	if (it != m_Entries.end())
+	{
+		m_Hits++;
+		it->second->LastUsed = ++m_Clock;
+		return TextureHandle(it->second);
+	}
+
+	uint64_t contentHash = 0;
+	if (m_ContentHashing)
+	{
+		contentHash = hashFile(path, flipVertically);
+		auto sameContent = contentHash ? m_ByContent.find(contentHash) : m_ByContent.end();
+		if (sameContent != m_ByContent.end())
+		{
+			m_ContentDuplicates++;
+			m_Aliases[key] = sameContent->second;
+			auto& entry = m_Entries[sameContent->second];
+			entry->LastUsed = ++m_Clock;
+			return TextureHandle(entry);
+		}
+	}
+
+	m_Misses++;
+	auto entry = std::make_shared<TextureCacheEntry>();
+	entry->Texture.Reset(m_Loader.Load(path, flipVertically));
+	entry->Key = key;
+	entry->ContentHash = contentHash;
+	entry->LastUsed = ++m_Clock;
+	m_Entries[key] = entry;
+	if (contentHash)
+		m_ByContent[contentHash] = key;
+
+	Trim();
+	return TextureHandle(entry);
+}
+
+TextureLayer TextureCache::AcquireLayer(const std::string& path, TextureArrayAllocator& arrays, bool flipVertically)
+{
+	std::string key = canonicalKey(path, flipVertically);
+	auto it = m_Layers.find(key);
+	if (it != m_Layers.end())
+	{
+		m_Hits++;
+		return it->second;
+	}
+
+	m_Misses++;
+	int width, height, channels;
+	TextureLayer layer;
+	if (stbi_info(path.c_str(), &width, &height, &channels))
+	{
+		layer = arrays.Allocate(width, height);
+		m_Loader.LoadLayer(path, *layer.Array, layer.Layer, flipVertically);
+	}
+	else
+	{
+		std::cout << "Can't read the size of " << path << " for a texture array, its layer stays white" << std::endl;
+		layer = arrays.Allocate(1, 1);
+	}
+	m_Layers[key] = layer;
+	return layer;
+}
+
+void TextureCache::Update(size_t budgetBytes)
+{
+	m_Loader.Update(budgetBytes);
+	Trim();
+}
+
+void TextureCache::SetMemoryBudget(size_t bytes)
+{
+	m_Budget = bytes;
+	Trim();
+}
+
+size_t TextureCache::entryBytes(const TextureCacheEntry& entry) const
+{
+	return m_Loader.GetStatus(entry.Texture.Get()).bytes;
+}
+
+void TextureCache::Trim()
+{
+	if (m_Budget == SIZE_MAX)
+		return;
+
+	size_t total = 0;
+	std::vector<std::pair<uint64_t, std::string>> candidates;
+	for (const auto& [key, entry] : m_Entries)
+	{
+		total += entryBytes(*entry);
+		// The cache holds the only reference, so nobody can be drawing with it.
+		// A texture still waiting for its upload has to stay until it lands.
+		if (entry.use_count() == 1 && m_Loader.GetStatus(entry->Texture.Get()).state != TextureLoader::State::Pending)
+			candidates.push_back({ entry->LastUsed, key });
+	}
+	if (total <= m_Budget)
+		return;
+
+	std::sort(candidates.begin(), candidates.end());
+	for (const auto& [lastUsed, key] : candidates)
+	{
+		if (total <= m_Budget)
+			break;
+		total -= entryBytes(*m_Entries[key]);
+		evict(key);
+	}
+}
+
+void TextureCache::evict(const std::string& key)
+{
+	auto it = m_Entries.find(key);
+	if (it == m_Entries.end())
+		return;
+
+	if (it->second->ContentHash)
+		m_ByContent.erase(it->second->ContentHash);
+	for (auto alias = m_Aliases.begin(); alias != m_Aliases.end();)
+	{
+		if (alias->second == key)
+			alias = m_Aliases.erase(alias);
+		else
+			++alias;
+	}
+	// The entry holds the last reference, so erasing it deletes the texture
+	m_Loader.Forget(it->second->Texture.Get());
+	m_Entries.erase(it);
+	m_Evictions++;
+}
+
+TextureCacheStats TextureCache::GetStats() const
+{
+	TextureCacheStats stats;
+	stats.Entries = m_Entries.size();
+	stats.Layers = m_Layers.size();
+	stats.Budget = m_Budget;
+	stats.Hits = m_Hits;
+	stats.Misses = m_Misses;
+	stats.ContentDuplicates = m_ContentDuplicates;
+	stats.Evictions = m_Evictions;
+	for (const auto& [key, entry] : m_Entries)
+	{
+		stats.Bytes += entryBytes(*entry);
+		if (entry.use_count() > 1)
+			stats.Referenced++;
+	}
+	return stats;
+}
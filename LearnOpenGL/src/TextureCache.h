@@ -0,0 +1,98 @@
+#pragma once
+
+#include "GLHandle.h"
+#include "TextureLoader.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+struct TextureCacheEntry
+{
+	GLHandle<TextureDeleter> Texture;
+	std::string Key;
+	uint64_t ContentHash = 0;
+	uint64_t LastUsed = 0;
+};
+
+// Shared reference to a cached texture. The texture stays alive as long as a
+// handle to it exists, even if the cache itself goes away first.
+class TextureHandle
+{
+public:
+	TextureHandle() = default;
+
+	inline unsigned int GetID() const { return m_Entry ? m_Entry->Texture.Get() : 0; }
+	inline explicit operator bool() const { return m_Entry != nullptr; }
+private:
+	friend class TextureCache;
+	explicit TextureHandle(std::shared_ptr<TextureCacheEntry> entry)
+		: m_Entry(std::move(entry))
+	{}
+
+	std::shared_ptr<TextureCacheEntry> m_Entry;
+};
+
+struct TextureCacheStats
+{
+	size_t Entries = 0;
+	size_t Referenced = 0;        // entries with at least one live handle
+	size_t Layers = 0;            // images placed in texture arrays by AcquireLayer
+	size_t Bytes = 0;             // estimated GPU memory of loaded entries
+	size_t Budget = 0;
+	uint64_t Hits = 0;
+	uint64_t Misses = 0;
+	uint64_t ContentDuplicates = 0; // different paths that turned out to hold the same file
+	uint64_t Evictions = 0;
+};
+
+// Hands out one texture per image file. Requests are deduplicated by canonical
+// path and, optionally, by a hash of the file contents. Textures no handle
+// refers to any more stay cached and are evicted least recently used first
+// once the loaded textures exceed the memory budget. Call Update() each frame
+// instead of TextureLoader::Update(), so textures that finish loading or lose
+// their last handle are counted against the budget.
+class TextureCache
+{
+public:
+	explicit TextureCache(TextureLoader& loader, size_t memoryBudget = SIZE_MAX);
+
+	TextureHandle Acquire(const std::string& path, bool flipVertically = true);
+	// Streams the image into a layer from arrays instead, picking an array of
+	// the image's size. Layers are deduplicated by path like textures but
+	// belong to the allocator, so they are never evicted. An image whose size
+	// can't be read (or a baked .btex) gets a 1x1 layer that stays white.
+	TextureLayer AcquireLayer(const std::string& path, TextureArrayAllocator& arrays, bool flipVertically = true);
+
+	// Hashing reads each new file on the calling thread before it is queued
+	void SetContentHashing(bool enabled) { m_ContentHashing = enabled; }
+	void SetMemoryBudget(size_t bytes);
+	// Uploads finished textures (see TextureLoader::Update), then trims
+	void Update(size_t budgetBytes = 8 * 1024 * 1024);
+	// Evicts unreferenced, loaded (or failed) textures until the cache fits in its budget
+	void Trim();
+
+	TextureCacheStats GetStats() const;
+private:
+	size_t entryBytes(const TextureCacheEntry& entry) const;
+	void evict(const std::string& key);
+
+	TextureLoader& m_Loader;
+	size_t m_Budget;
+	bool m_ContentHashing = false;
+	uint64_t m_Clock = 0;
+
+	std::unordered_map<std::string, std::shared_ptr<TextureCacheEntry>> m_Entries;
+	// Paths whose contents matched an entry under another key
+	std::unordered_map<std::string, std::string> m_Aliases;
+	// Content hashes include the orientation, so a flipped and an unflipped
+	// load of the same file stay separate
+	std::unordered_map<uint64_t, std::string> m_ByContent;
+	std::unordered_map<std::string, TextureLayer> m_Layers;
+
+	uint64_t m_Hits = 0;
+	uint64_t m_Misses = 0;
+	uint64_t m_ContentDuplicates = 0;
+	uint64_t m_Evictions = 0;
+};
\ No newline at end of file
@@ -0,0 +1,331 @@
+#include "TextureLoader.h"
+
+#include "BakedTextureFormat.h"
+#include "GLStateCache.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static GLenum formatForChannels(int channels)
+{
+	switch (channels)
+	{
+	case 1: return GL_RED;
+	case 2: return GL_RG;
+	case 3: return GL_RGB;
+	default: return GL_RGBA;
+	}
+}
+
+TextureLoader::TextureLoader(unsigned int workerCount)
+{
+	if (workerCount == 0)
+	{
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+	for (unsigned int i = 0; i < workerCount; i++)
+		m_Workers.emplace_back(&TextureLoader::workerLoop, this);
+
+	GLCall(glGenBuffers(PixelBufferCount, m_PixelBuffers));
+
+	int formatCount = 0;
+	GLCall(glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &formatCount));
+	m_CompressedFormats.resize(formatCount);
+	if (formatCount > 0)
+	{
+		GLCall(glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, m_CompressedFormats.data()));
+	}
+}
+
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Quit = true;
+	}
+	m_JobAvailable.notify_all();
+	for (std::thread& worker : m_Workers)
+		worker.join();
+
+	for (DecodedImage& image : m_Decoded)
+		stbi_image_free(image.pixels);
+	for (unsigned int pbo : m_PixelBuffers)
+		GLStateCache::Get().OnDeleteBuffer(pbo);
+	GLCall(glDeleteBuffers(PixelBufferCount, m_PixelBuffers));
+}
+
+unsigned int TextureLoader::Load(const std::string& path, bool flipVertically)
+{
+	unsigned int texture;
+	GLCall(glGenTextures(1, &texture));
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D, texture);
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+
+	const unsigned char white[4] = { 255, 255, 255, 255 };
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white));
+	GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+
+	m_Status[texture] = Status();
+	if (path.ends_with(".btex"))
+	{
+		Status& status = m_Status[texture];
+		if (!uploadBaked(texture, path, flipVertically, status))
+		{
+			std::cout << "Failed to load baked texture " << path << std::endl;
+			status.state = State::Failed;
+		}
+		return texture;
+	}
+
+	m_Pending++;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Jobs.push_back({ texture, path, flipVertically, nullptr, 0 });
+	}
+	m_JobAvailable.notify_one();
+	return texture;
+}
+
+void TextureLoader::LoadLayer(const std::string& path, TextureArray& array, unsigned int layer, bool flipVertically)
+{
+	m_Pending++;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Jobs.push_back({ 0, path, flipVertically, &array, layer });
+	}
+	m_JobAvailable.notify_one();
+}
+
+void TextureLoader::workerLoop()
+{
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_JobAvailable.wait(lock, [this] { return m_Quit || !m_Jobs.empty(); });
+			if (m_Quit)
+				return;
+			job = std::move(m_Jobs.front());
+			m_Jobs.pop_front();
+		}
+
+		DecodedImage image = { job.texture, job.array, job.layer, std::move(job.path), nullptr, 0, 0, 0, {}, 0 };
+		{
+			PROFILE_SCOPE("DecodeTexture");
+			stbi_set_flip_vertically_on_load_thread(job.flip);
+			image.pixels = stbi_load(image.path.c_str(), &image.width, &image.height, &image.channels, 0);
+		}
+		if (image.pixels)
+		{
+			PROFILE_SCOPE("GenerateMips");
+			image.mips = GenerateMips(image.pixels, image.width, image.height, image.channels);
+			image.bytes = (size_t)image.width * image.height * image.channels;
+			for (const MipLevel& level : image.mips)
+				image.bytes += level.pixels.size();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Decoded.push_back(std::move(image));
+		}
+		m_ImageDecoded.notify_one();
+	}
+}
+
+void TextureLoader::Update(size_t budgetBytes)
+{
+	size_t uploaded = 0;
+	while (uploaded < budgetBytes || uploaded == 0)
+	{
+		DecodedImage image;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_Decoded.empty())
+				break;
+			image = std::move(m_Decoded.front());
+			m_Decoded.pop_front();
+		}
+
+		upload(image);
+		uploaded += image.bytes;
+		stbi_image_free(image.pixels);
+		m_Pending--;
+	}
+}
+
+void TextureLoader::upload(const DecodedImage& image)
+{
+	PROFILE_SCOPE("UploadTexture");
+	if (image.array)
+	{
+		if (!image.pixels || (unsigned int)image.width != image.array->GetWidth() || (unsigned int)image.height != image.array->GetHeight())
+		{
+			std::cout << "Failed to load texture " << image.path << " into a " << image.array->GetWidth() << "x"
+				<< image.array->GetHeight() << " array layer" << std::endl;
+			return;
+		}
+	}
+	else if (!image.pixels)
+	{
+		std::cout << "Failed to load texture " << image.path << std::endl;
+		m_Status[image.texture].state = State::Failed;
+		return;
+	}
+
+	size_t baseSize = (size_t)image.width * image.height * image.channels;
+
+	// Copy every level into one pixel buffer so glTexImage2D reads from GPU-visible memory.
+	// Orphaning the buffer first means an upload still in flight never blocks the copy.
+	unsigned int pbo = m_PixelBuffers[m_NextPixelBuffer];
+	m_NextPixelBuffer = (m_NextPixelBuffer + 1) % PixelBufferCount;
+	GLStateCache::Get().BindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+	GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, image.bytes, nullptr, GL_STREAM_DRAW));
+	unsigned char* mapped;
+	GLCall(mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, image.bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	if (mapped)
+	{
+		memcpy(mapped, image.pixels, baseSize);
+		size_t offset = baseSize;
+		for (const MipLevel& level : image.mips)
+		{
+			memcpy(mapped + offset, level.pixels.data(), level.pixels.size());
+			offset += level.pixels.size();
+		}
+		GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+	}
+	else
+	{
+		GLStateCache::Get().BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	// With the buffer bound the data pointers are offsets into it
+	GLenum format = formatForChannels(image.channels);
+	auto uploadLevel = [&](GLint level, int width, int height, const void* data)
+	{
+		if (image.array)
+		{
+			GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, image.layer, width, height, 1, format, GL_UNSIGNED_BYTE, data));
+		}
+		else
+		{
+			GLCall(glTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0, format, GL_UNSIGNED_BYTE, data));
+		}
+	};
+
+	if (image.array)
+	{
+		GLStateCache::Get().BindTexture(GL_TEXTURE_2D_ARRAY, image.array->GetID());
+	}
+	else
+	{
+		GLStateCache::Get().BindTexture(GL_TEXTURE_2D, image.texture);
+	}
+	GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+	uploadLevel(0, image.width, image.height, mapped ? nullptr : image.pixels);
+	size_t offset = baseSize;
+	for (size_t i = 0; i < image.mips.size(); i++)
+	{
+		const MipLevel& level = image.mips[i];
+		uploadLevel((GLint)i + 1, level.width, level.height, mapped ? (const void*)(uintptr_t)offset : level.pixels.data());
+		offset += level.pixels.size();
+	}
+	GLStateCache::Get().BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	PROFILE_COUNT(BytesUploaded, image.bytes);
+	if (image.array)
+		return;
+
+	Status& status = m_Status[image.texture];
+	status.state = State::Loaded;
+	status.width = image.width;
+	status.height = image.height;
+	status.channels = image.channels;
+	status.bytes = image.bytes;
+}
+
+bool TextureLoader::uploadBaked(unsigned int texture, const std::string& path, bool flipVertically, Status& status)
+{
+	PROFILE_SCOPE("UploadBakedTexture");
+	MappedFile file(path);
+	if (!file.IsOpen() || file.GetSize() < sizeof(BakedTextureHeader))
+		return false;
+
+	const BakedTextureHeader* header = (const BakedTextureHeader*)file.GetData();
+	if (memcmp(header->Magic, BAKED_TEXTURE_MAGIC, 4) != 0 || header->Version != BAKED_TEXTURE_VERSION ||
+		header->LevelCount == 0 || sizeof(BakedTextureHeader) + header->LevelCount * sizeof(BakedTextureLevel) > file.GetSize())
+		return false;
+	if (std::find(m_CompressedFormats.begin(), m_CompressedFormats.end(), (int)header->GLFormat) == m_CompressedFormats.end())
+	{
+		std::cout << "Compressed format 0x" << std::hex << header->GLFormat << std::dec << " is not supported" << std::endl;
+		return false;
+	}
+	if (((header->Flags & BAKED_TEXTURE_FLIPPED) != 0) != flipVertically)
+	{
+		std::cout << path << " was baked " << (flipVertically ? "with --no-flip" : "flipped")
+			<< ", rebake it to match the requested orientation" << std::endl;
+		return false;
+	}
+
+	const BakedTextureLevel* levels = (const BakedTextureLevel*)(header + 1);
+	for (unsigned int i = 0; i < header->LevelCount; i++)
+	{
+		if (levels[i].Offset + levels[i].Size > file.GetSize())
+			return false;
+	}
+
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D, texture);
+	size_t total = 0;
+	for (unsigned int i = 0; i < header->LevelCount; i++)
+	{
+		GLCall(glCompressedTexImage2D(GL_TEXTURE_2D, i, header->GLFormat, levels[i].Width, levels[i].Height, 0,
+			(GLsizei)levels[i].Size, file.GetData() + levels[i].Offset));
+		total += levels[i].Size;
+	}
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header->LevelCount - 1));
+	PROFILE_COUNT(BytesUploaded, total);
+
+	status.state = State::Loaded;
+	status.width = header->Width;
+	status.height = header->Height;
+	status.channels = header->Flags & BAKED_TEXTURE_ALPHA ? 4 : 3;
+	status.bytes = total;
+	return true;
+}
+
+void TextureLoader::Finish()
+{
+	while (m_Pending > 0)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_ImageDecoded.wait(lock, [this] { return !m_Decoded.empty(); });
+		}
+		Update(SIZE_MAX);
+	}
+}
+
+bool TextureLoader::IsIdle() const
+{
+	return m_Pending == 0;
+}
+
+TextureLoader::Status TextureLoader::GetStatus(unsigned int texture) const
+{
+	auto it = m_Status.find(texture);
+	return it != m_Status.end() ? it->second : Status();
+}
+
+void TextureLoader::Forget(unsigned int texture)
+{
+	m_Status.erase(texture);
+}
\ No newline at end of file
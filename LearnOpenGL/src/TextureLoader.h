@@ -0,0 +1,114 @@
+#pragma once
+
+#include "MipGenerator.h"
+#include "TextureArray.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Loads textures without blocking the render thread. Load() returns a GL
+// texture straight away, showing a 1x1 white placeholder; worker threads
+// decode the image and build its mip chain (sRGB-correct, see MipGenerator.h),
+// and Update() uploads finished images through pixel buffer objects,
+// spending at most a byte budget per frame. The texture
+// name never changes, so it can be handed out before the data arrives.
+//
+// Baked textures (.btex, see BakedTextureFormat.h) skip the workers: their
+// compressed levels are uploaded by Load() straight from a file mapping. They
+// can't be flipped at load time, so one baked the other way up fails to load.
+//
+// Load() and Update() must be called on the thread that owns the GL context.
+// The returned textures belong to the caller.
+class TextureLoader
+{
+public:
+	enum class State
+	{
+		Pending,  // placeholder is showing
+		Loaded,
+		Failed    // placeholder stays
+	};
+
+	struct Status
+	{
+		State state = State::Pending;
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		size_t bytes = 0; // GPU memory including mip levels
+	};
+
+	// workerCount 0 picks one less than the number of hardware threads
+	explicit TextureLoader(unsigned int workerCount = 0);
+	~TextureLoader();
+
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+
+	unsigned int Load(const std::string& path, bool flipVertically = true);
+	// Streams the image into a layer of a texture array instead of a texture of
+	// its own. The image has to match the array's size; the layer stays white
+	// until it arrives.
+	void LoadLayer(const std::string& path, TextureArray& array, unsigned int layer, bool flipVertically = true);
+
+	// Uploads decoded images until budgetBytes have been sent. At least one
+	// image goes up per call, so an image larger than the budget still loads.
+	void Update(size_t budgetBytes = 8 * 1024 * 1024);
+	// Blocks until every requested texture has been uploaded (or failed)
+	void Finish();
+
+	bool IsIdle() const;
+	Status GetStatus(unsigned int texture) const;
+	// Drops the status of a texture the caller is deleting, which must no
+	// longer be pending. GetStatus() reports it as a fresh Pending one after.
+	void Forget(unsigned int texture);
+
+private:
+	struct Job
+	{
+		unsigned int texture;
+		std::string path;
+		bool flip;
+		TextureArray* array; // nullptr for a plain texture
+		unsigned int layer;
+	};
+
+	struct DecodedImage
+	{
+		unsigned int texture;
+		TextureArray* array;
+		unsigned int layer;
+		std::string path;
+		unsigned char* pixels; // stbi allocated, nullptr on failure
+		int width;
+		int height;
+		int channels;
+		std::vector<MipLevel> mips;
+		size_t bytes;          // all levels
+	};
+
+	void workerLoop();
+	void upload(const DecodedImage& image);
+	bool uploadBaked(unsigned int texture, const std::string& path, bool flipVertically, Status& status);
+
+	std::vector<std::thread> m_Workers;
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_JobAvailable;
+	std::condition_variable m_ImageDecoded;
+	std::deque<Job> m_Jobs;
+	std::deque<DecodedImage> m_Decoded;
+	bool m_Quit = false;
+
+	// GL thread only
+	std::unordered_map<unsigned int, Status> m_Status;
+	size_t m_Pending = 0;
+	static constexpr unsigned int PixelBufferCount = 3;
+	unsigned int m_PixelBuffers[PixelBufferCount] = {};
+	unsigned int m_NextPixelBuffer = 0;
+	std::vector<int> m_CompressedFormats;
+};
\ No newline at end of file
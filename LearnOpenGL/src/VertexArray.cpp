@@ -1,40 +1,56 @@
 #include "VertexArray.h"
 
+#include "GLStateCache.h"
 #include "Renderer.h"
 
+#include <cstdint>
+
 VertexArray::VertexArray()
 {
-	GLCall(glGenVertexArrays(1, &m_RendererID));
+	unsigned int id;
+	GLCall(glGenVertexArrays(1, &id));
+	m_Handle.Reset(id);
 }
 
-VertexArray::~VertexArray()
+void VertexArray::Bind() const
 {
-	GLCall(glDeleteVertexArrays(1, &m_RendererID));
+	GLStateCache::Get().BindVertexArray(m_Handle.Get());
 }
 
-void VertexArray::Bind() const
+void VertexArray::Unbind() const
 {
-	GLCall(glBindVertexArray(m_RendererID));
+	GLStateCache::Get().BindVertexArray(0);
+}
 
+void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, unsigned int divisor)
+{
+	Bind();
+	vb.Bind();
+	addAttributes(layout, divisor);
 }
 
-void VertexArray::Unbind() const
+void VertexArray::AddBuffer(const StreamBuffer& sb, const VertexBufferLayout& layout, unsigned int divisor)
 {
-	GLCall(glBindVertexArray(0));
+	Bind();
+	sb.Bind();
+	addAttributes(layout, divisor);
+}
 
+void VertexArray::addAttributes(const VertexBufferLayout& layout, unsigned int divisor)
+{
+	for (const auto& element : layout.GetElements())
+		addAttribute(element, layout.GetStride(), divisor);
 }
 
-void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout)
+void VertexArray::addAttribute(const VertexBufferElement& element, unsigned int stride, unsigned int divisor)
 {
-	Bind();
-	vb.Bind();
-	const auto& elements = layout.GetElements();
-	unsigned int offset = 0;
-	for (unsigned int i = 0; i < elements.size(); i++) {
-		const auto& element = elements[i];
-		GLCall(glEnableVertexAttribArray(i));
-		GLCall(glVertexAttribPointer(i, element.count, element.type,
-			element.normalized, layout.GetStride(), (const void*)offset));
-		offset += element.count * VertexBufferElement::GetSizeOfType(element.type);
+	// GL only accepts a packed 10:10:10:2 value as a whole xyzw attribute
+	ASSERT(!VertexBufferElement::IsPackedType(element.type) || element.count == 4);
+	unsigned int index = m_AttribCount++;
+	GLCall(glEnableVertexAttribArray(index));
+	GLCall(glVertexAttribPointer(index, element.count, element.type,
+		element.normalized, stride, (const void*)(uintptr_t)element.offset));
+	if (divisor != 0) {
+		GLCall(glVertexAttribDivisor(index, divisor));
 	}
 }
@@ -1,18 +1,44 @@
 #pragma once
+#include "GLHandle.h"
+#include "StreamBuffer.h"
 #include "VertexBuffer.h"
 #include "VertexBufferLayout.h"
+#include "StaticVertexLayout.h"
 
 class VertexArray
 {
 public:
 	VertexArray();
-	~VertexArray();
+
+	// Owns the GL vertex array, so it can be moved but never copied
+	VertexArray(const VertexArray&) = delete;
+	VertexArray& operator=(const VertexArray&) = delete;
+	VertexArray(VertexArray&&) noexcept = default;
+	VertexArray& operator=(VertexArray&&) noexcept = default;
 
 	void Bind() const;
 	void Unbind() const;
 
-	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
+	inline unsigned int GetID() const { return m_Handle.Get(); }
+
+	// Attributes are appended after those of previously added buffers.
+	// A non-zero divisor makes the buffer advance per instance instead of per vertex.
+	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, unsigned int divisor = 0);
+	void AddBuffer(const StreamBuffer& sb, const VertexBufferLayout& layout, unsigned int divisor = 0);
+
+	// Layout fixed at compile time (see MakeLayout), set up without touching the heap
+	template<size_t N>
+	void AddBuffer(const VertexBuffer& vb, const StaticVertexLayout<N>& layout, unsigned int divisor = 0)
+	{
+		Bind();
+		vb.Bind();
+		for (const auto& element : layout.Elements)
+			addAttribute(element, layout.Stride, divisor);
+	}
 private:
-	unsigned int m_RendererID;
-};
+	GLHandle<VertexArrayDeleter> m_Handle;
+	unsigned int m_AttribCount = 0;
 
+	void addAttributes(const VertexBufferLayout& layout, unsigned int divisor);
+	void addAttribute(const VertexBufferElement& element, unsigned int stride, unsigned int divisor);
+};
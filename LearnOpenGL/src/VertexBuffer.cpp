@@ -1,32 +1,52 @@
 #include "VertexBuffer.h"
 
+#include "GLStateCache.h"
+#include "Profiler.h"
 #include "Renderer.h"
 
-VertexBuffer::VertexBuffer(std::vector<Vertex> vertices)
+VertexBuffer::VertexBuffer(std::span<const Vertex> vertices)
+	: m_Size((unsigned int)vertices.size_bytes())
 {
-	GLCall(glGenBuffers(1, &m_RendererID));
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
-	GLCall(glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW));
+	unsigned int id;
+	GLCall(glGenBuffers(1, &id));
+	m_Handle.Reset(id);
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, m_Handle.Get());
+	GLCall(glBufferData(GL_ARRAY_BUFFER, vertices.size_bytes(), vertices.data(), GL_STATIC_DRAW));
+	PROFILE_COUNT(BytesUploaded, vertices.size_bytes());
 }
 
-VertexBuffer::VertexBuffer(const void* data, unsigned int size)
+VertexBuffer::VertexBuffer(const void* data, unsigned int size, unsigned int usage)
+	: m_Size(size), m_Usage(usage)
 {
-	GLCall(glGenBuffers(1, &m_RendererID));
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
-	GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
+	unsigned int id;
+	GLCall(glGenBuffers(1, &id));
+	m_Handle.Reset(id);
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, m_Handle.Get());
+	GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, usage));
+	if (data)
+		PROFILE_COUNT(BytesUploaded, size);
 }
 
-VertexBuffer::~VertexBuffer()
+void VertexBuffer::SetData(const void* data, unsigned int size)
 {
-	GLCall(glDeleteBuffers(1, &m_RendererID));
+	PROFILE_COUNT(BytesUploaded, size);
+	Bind();
+	if (size > m_Size)
+	{
+		m_Size = size;
+		GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, m_Usage));
+		return;
+	}
+	GLCall(glBufferData(GL_ARRAY_BUFFER, m_Size, nullptr, m_Usage));
+	GLCall(glBufferSubData(GL_ARRAY_BUFFER, 0, size, data));
 }
 
 void VertexBuffer::Bind() const
 {
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, m_Handle.Get());
 }
 
 void VertexBuffer::Unbind() const
 {
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, 0);
 }
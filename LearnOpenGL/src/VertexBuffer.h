@@ -1,17 +1,33 @@
 #pragma once
+#include "GLHandle.h"
 #include "VertexLayout.h"
-#include <vector>
+#include <glad/glad.h>
+#include <span>
 
 class VertexBuffer
 {
 private:
-	unsigned int m_RendererID = 0;
+	GLHandle<BufferDeleter> m_Handle;
+	unsigned int m_Size = 0;
+	unsigned int m_Usage = GL_STATIC_DRAW;
 public:
 	VertexBuffer() = default;
-	VertexBuffer(std::vector<Vertex> vertices);
-	VertexBuffer(const void* data, unsigned int size);
-	~VertexBuffer();
+	VertexBuffer(std::span<const Vertex> vertices);
+	VertexBuffer(const void* data, unsigned int size, unsigned int usage = GL_STATIC_DRAW);
+
+	// Owns the GL buffer, so it can be moved but never copied
+	VertexBuffer(const VertexBuffer&) = delete;
+	VertexBuffer& operator=(const VertexBuffer&) = delete;
+	VertexBuffer(VertexBuffer&&) noexcept = default;
+	VertexBuffer& operator=(VertexBuffer&&) noexcept = default;
+
+	// Replaces the whole buffer. Storage is orphaned first so that a draw still
+	// reading last frame's data doesn't stall the upload.
+	void SetData(const void* data, unsigned int size);
 
 	void Bind() const;
 	void Unbind() const;
-};
\ No newline at end of file
+
+	inline unsigned int GetID() const { return m_Handle.Get(); }
+	inline unsigned int GetSize() const { return m_Size; }
+};
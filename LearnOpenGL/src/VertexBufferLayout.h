@@ -1,26 +1,47 @@
 #pragma once
 #include <vector>
 #include <glad/glad.h>
+#include <glm/glm.hpp>
 #include <assert.h>
+#include <cstdint>
 #include "Renderer.h"
 
+// Packed attribute types, for vertices smaller than plain floats allow
+struct Half { uint16_t bits; };              // one GL_HALF_FLOAT
+struct Half2 { uint16_t x, y; };             // two GL_HALF_FLOATs
+struct Half4 { uint16_t x, y, z, w; };       // four GL_HALF_FLOATs
+struct PackedNormal { uint32_t value; };     // GL_INT_2_10_10_10_REV, normalized to [-1, 1]
+
 struct VertexBufferElement
 {
 	unsigned int type;
 	unsigned int count;
 	unsigned char normalized;
+	unsigned int offset; // bytes from the start of the vertex
 
 	static unsigned int GetSizeOfType(unsigned int type)
 	{
 		switch (type)
 		{
-		case GL_FLOAT:         return 4;
-		case GL_UNSIGNED_INT:  return 4;
-		case GL_UNSIGNED_BYTE: return 1;
+		case GL_FLOAT:                       return 4;
+		case GL_HALF_FLOAT:                  return 2;
+		case GL_UNSIGNED_INT:                return 4;
+		case GL_SHORT:                       return 2;
+		case GL_UNSIGNED_SHORT:              return 2;
+		case GL_BYTE:                        return 1;
+		case GL_UNSIGNED_BYTE:               return 1;
+		case GL_INT_2_10_10_10_REV:          return 4;
+		case GL_UNSIGNED_INT_2_10_10_10_REV: return 4;
 		}
 		ASSERT(false);
 		return 0;
 	}
+
+	// Packed formats store all four components in a single 32-bit value
+	static bool IsPackedType(unsigned int type)
+	{
+		return type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV;
+	}
 };
 
 class VertexBufferLayout
@@ -39,27 +60,69 @@ public:
 		assert(false);
 	}
 
-	template<>
-	void Push<float>(unsigned int count)
-	{
-		m_Elements.push_back({ GL_FLOAT, count, GL_FALSE });
-		m_Stride += count * VertexBufferElement::GetSizeOfType(GL_FLOAT);
-	}
+	inline const std::vector<VertexBufferElement>& GetElements() const { return m_Elements; }
+	inline unsigned int GetStride() const { return m_Stride; }
+};
 
-	template<>
-	void Push<unsigned int>(unsigned int count)
-	{
-		m_Elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE });
-		m_Stride += count * VertexBufferElement::GetSizeOfType(GL_UNSIGNED_INT);
-	}
+// Explicit specializations have to be at namespace scope
+template<>
+inline void VertexBufferLayout::Push<float>(unsigned int count)
+{
+	m_Elements.push_back({ GL_FLOAT, count, GL_FALSE, m_Stride });
+	m_Stride += count * VertexBufferElement::GetSizeOfType(GL_FLOAT);
+}
+
+template<>
+inline void VertexBufferLayout::Push<unsigned int>(unsigned int count)
+{
+	m_Elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE, m_Stride });
+	m_Stride += count * VertexBufferElement::GetSizeOfType(GL_UNSIGNED_INT);
+}
+
+template<>
+inline void VertexBufferLayout::Push<unsigned char>(unsigned int count)
+{
+	m_Elements.push_back({ GL_UNSIGNED_BYTE, count, GL_TRUE, m_Stride });
+	m_Stride += count * VertexBufferElement::GetSizeOfType(GL_UNSIGNED_BYTE);
+}
+
+// 16-bit integers are normalized, as used by quantized vertex data
+template<>
+inline void VertexBufferLayout::Push<short>(unsigned int count)
+{
+	m_Elements.push_back({ GL_SHORT, count, GL_TRUE, m_Stride });
+	m_Stride += count * VertexBufferElement::GetSizeOfType(GL_SHORT);
+}
+
+template<>
+inline void VertexBufferLayout::Push<unsigned short>(unsigned int count)
+{
+	m_Elements.push_back({ GL_UNSIGNED_SHORT, count, GL_TRUE, m_Stride });
+	m_Stride += count * VertexBufferElement::GetSizeOfType(GL_UNSIGNED_SHORT);
+}
 
-	template<>
-	void Push<unsigned char>(unsigned int count)
+template<>
+inline void VertexBufferLayout::Push<Half>(unsigned int count)
+{
+	m_Elements.push_back({ GL_HALF_FLOAT, count, GL_FALSE, m_Stride });
+	m_Stride += count * VertexBufferElement::GetSizeOfType(GL_HALF_FLOAT);
+}
+
+// count is the number of packed values, each holding a whole xyzw attribute
+template<>
+inline void VertexBufferLayout::Push<PackedNormal>(unsigned int count)
+{
+	for (unsigned int i = 0; i < count; i++)
 	{
-		m_Elements.push_back({ GL_UNSIGNED_BYTE, count, GL_TRUE });
-		m_Stride += count * VertexBufferElement::GetSizeOfType(GL_UNSIGNED_BYTE);
+		m_Elements.push_back({ GL_INT_2_10_10_10_REV, 4, GL_TRUE, m_Stride });
+		m_Stride += VertexBufferElement::GetSizeOfType(GL_INT_2_10_10_10_REV);
 	}
+}
 
-	inline const std::vector<VertexBufferElement>& GetElements() const { return m_Elements; }
-	inline unsigned int GetStride() const { return m_Stride; }
-};
\ No newline at end of file
+// A mat4 takes up four consecutive vec4 attribute slots
+template<>
+inline void VertexBufferLayout::Push<glm::mat4>(unsigned int count)
+{
+	for (unsigned int i = 0; i < count * 4; i++)
+		Push<float>(4);
+}
\ No newline at end of file
@@ -1,6 +1,6 @@
 #pragma once
 #include <glm/glm.hpp>
-#include <string>
+#include "StaticVertexLayout.h"
 
 struct Vertex
 {
@@ -9,8 +9,38 @@ struct Vertex
 	glm::vec2 TexCoords;
 };
 
+inline constexpr auto VERTEX_LAYOUT = MakeLayout<Vertex,
+	VERTEX_ATTRIB(Vertex, Position),
+	VERTEX_ATTRIB(Vertex, Normal),
+	VERTEX_ATTRIB(Vertex, TexCoords)>();
+
+// Material sampler a texture feeds. The shader declares them as
+// material.texture_diffuse1, material.texture_specular1 and so on.
+enum class TextureType : unsigned char
+{
+	Diffuse,
+	Specular,
+	Normal,
+	Height,
+	Count
+};
+
+inline const char* TextureTypeName(TextureType type)
+{
+	switch (type)
+	{
+	case TextureType::Diffuse:  return "texture_diffuse";
+	case TextureType::Specular: return "texture_specular";
+	case TextureType::Normal:   return "texture_normal";
+	default:                    return "texture_height";
+	}
+}
+
 struct Texture
 {
 	unsigned int id;
-	std::string type;
+	TextureType type;
+	// With a layer, id is a GL_TEXTURE_2D_ARRAY and the shader samples that layer
+	// (material.layer_diffuse1 next to material.texture_diffuse1)
+	int layer = -1;
 };
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/packing.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QUANTIZE_SSE2 1
+#include <emmintrin.h>
+#if defined(__F16C__) || defined(__AVX2__)
+#define QUANTIZE_F16C 1
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON)
+#define QUANTIZE_NEON 1
+#include <arm_neon.h>
+#endif
+
+static void computeBounds(std::span<const Vertex> vertices, glm::vec3& outMin, glm::vec3& outMax)
+{
+	if (vertices.empty())
+	{
+		outMin = outMax = glm::vec3(0.0f);
+		return;
+	}
+#if QUANTIZE_SSE2
+	__m128 minV = _mm_set1_ps(INFINITY);
+	__m128 maxV = _mm_set1_ps(-INFINITY);
+	for (const Vertex& v : vertices)
+	{
+		// Position and Normal are adjacent, so the fourth lane (Normal.x) is just ignored
+		__m128 p = _mm_loadu_ps(&v.Position.x);
+		minV = _mm_min_ps(minV, p);
+		maxV = _mm_max_ps(maxV, p);
+	}
+	float minOut[4], maxOut[4];
+	_mm_storeu_ps(minOut, minV);
+	_mm_storeu_ps(maxOut, maxV);
+	outMin = glm::vec3(minOut[0], minOut[1], minOut[2]);
+	outMax = glm::vec3(maxOut[0], maxOut[1], maxOut[2]);
+#else
+	outMin = outMax = vertices[0].Position;
+	for (const Vertex& v : vertices)
+	{
+		outMin = glm::min(outMin, v.Position);
+		outMax = glm::max(outMax, v.Position);
+	}
+#endif
+}
+
+static void quantizePositions(std::span<const Vertex> vertices, const glm::vec3& boundsMin, const glm::vec3& scale,
+	std::vector<QuantizedVertex>& out)
+{
+#if QUANTIZE_SSE2
+	const __m128 minV = _mm_setr_ps(boundsMin.x, boundsMin.y, boundsMin.z, 0.0f);
+	const __m128 scaleV = _mm_setr_ps(scale.x, scale.y, scale.z, 0.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 maxValue = _mm_set1_ps(65535.0f);
+	const __m128i bias32 = _mm_set1_epi32(32768);
+	const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		__m128 p = _mm_loadu_ps(&vertices[i].Position.x);
+		__m128 q = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(p, minV), scaleV), half);
+		q = _mm_min_ps(_mm_max_ps(q, zero), maxValue);
+		// SSE2 only has a signed saturating pack, so shift into the signed range and back
+		__m128i qi = _mm_sub_epi32(_mm_cvttps_epi32(q), bias32);
+		__m128i packed = _mm_xor_si128(_mm_packs_epi32(qi, qi), bias16);
+		_mm_storel_epi64((__m128i*)&out[i].Position, packed);
+		out[i].Position.w = 0;
+	}
+#elif QUANTIZE_NEON
+	const float32x4_t minV = { boundsMin.x, boundsMin.y, boundsMin.z, 0.0f };
+	const float32x4_t scaleV = { scale.x, scale.y, scale.z, 0.0f };
+	const float32x4_t half = vdupq_n_f32(0.5f);
+	const float32x4_t maxValue = vdupq_n_f32(65535.0f);
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		float32x4_t p = vld1q_f32(&vertices[i].Position.x);
+		float32x4_t q = vaddq_f32(vmulq_f32(vsubq_f32(p, minV), scaleV), half);
+		q = vminq_f32(vmaxq_f32(q, vdupq_n_f32(0.0f)), maxValue);
+		uint16x4_t packed = vmovn_u32(vcvtq_u32_f32(q));
+		vst1_u16(&out[i].Position.x, packed);
+		out[i].Position.w = 0;
+	}
+#else
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		glm::vec3 q = glm::clamp((vertices[i].Position - boundsMin) * scale + 0.5f, 0.0f, 65535.0f);
+		out[i].Position = glm::u16vec4(glm::u16vec3(q), 0);
+	}
+#endif
+}
+
+static void quantizeTexCoords(std::span<const Vertex> vertices, std::vector<QuantizedVertex>& out)
+{
+	size_t i = 0;
+#if QUANTIZE_F16C
+	// Two vertices per conversion
+	for (; i + 2 <= vertices.size(); i += 2)
+	{
+		__m128 uv = _mm_setr_ps(vertices[i].TexCoords.x, vertices[i].TexCoords.y,
+			vertices[i + 1].TexCoords.x, vertices[i + 1].TexCoords.y);
+		__m128i h = _mm_cvtps_ph(uv, _MM_FROUND_TO_NEAREST_INT);
+		uint16_t halves[8];
+		_mm_storeu_si128((__m128i*)halves, h);
+		out[i].TexCoords = { halves[0], halves[1] };
+		out[i + 1].TexCoords = { halves[2], halves[3] };
+	}
+#endif
+	for (; i < vertices.size(); i++)
+	{
+		out[i].TexCoords.x = glm::packHalf1x16(vertices[i].TexCoords.x);
+		out[i].TexCoords.y = glm::packHalf1x16(vertices[i].TexCoords.y);
+	}
+}
+
+QuantizedMesh QuantizeVertices(std::span<const Vertex> vertices)
+{
+	QuantizedMesh mesh;
+	mesh.Vertices.resize(vertices.size());
+
+	glm::vec3 boundsMax;
+	computeBounds(vertices, mesh.BoundsMin, boundsMax);
+	mesh.BoundsExtent = boundsMax - mesh.BoundsMin;
+
+	glm::vec3 scale;
+	for (int axis = 0; axis < 3; axis++)
+		scale[axis] = mesh.BoundsExtent[axis] > 0.0f ? 65535.0f / mesh.BoundsExtent[axis] : 0.0f;
+
+	quantizePositions(vertices, mesh.BoundsMin, scale, mesh.Vertices);
+	for (size_t i = 0; i < vertices.size(); i++)
+		mesh.Vertices[i].Normal = EncodeOctahedral(vertices[i].Normal);
+	quantizeTexCoords(vertices, mesh.Vertices);
+
+	return mesh;
+}
+
+glm::i16vec2 EncodeOctahedral(const glm::vec3& normal)
+{
+	float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+	if (sum == 0.0f)
+		return glm::i16vec2(0);
+
+	glm::vec3 n = normal / sum;
+	glm::vec2 e(n.x, n.y);
+	if (n.z < 0.0f)
+	{
+		// Fold the lower hemisphere over the diagonals
+		glm::vec2 sign(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+		e = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * sign;
+	}
+	e = glm::clamp(e, -1.0f, 1.0f);
+	return glm::i16vec2(glm::round(e * 32767.0f));
+}
+
+glm::vec3 DecodeOctahedral(const glm::i16vec2& encoded)
+{
+	glm::vec2 e = glm::max(glm::vec2(encoded) / 32767.0f, -1.0f);
+	glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+	float t = std::max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	float length = glm::length(n);
+	return length > 0.0f ? n / length : n;
+}
+
+PackedNormal EncodeNormal1010102(const glm::vec3& normal)
+{
+	glm::ivec3 q = glm::ivec3(glm::round(glm::clamp(normal, -1.0f, 1.0f) * 511.0f));
+	PackedNormal packed;
+	packed.value = (uint32_t)(q.x & 0x3FF) | ((uint32_t)(q.y & 0x3FF) << 10) | ((uint32_t)(q.z & 0x3FF) << 20);
+	return packed;
+}
+
+Vertex DecodeVertex(const QuantizedVertex& vertex, const QuantizedMesh& mesh)
+{
+	Vertex decoded;
+	decoded.Position = mesh.BoundsMin + glm::vec3(vertex.Position) / 65535.0f * mesh.BoundsExtent;
+	decoded.Normal = DecodeOctahedral(vertex.Normal);
+	decoded.TexCoords = glm::vec2(glm::unpackHalf1x16(vertex.TexCoords.x), glm::unpackHalf1x16(vertex.TexCoords.y));
+	return decoded;
+}
+
+QuantizationError MeasureQuantizationError(std::span<const Vertex> vertices, const QuantizedMesh& mesh)
+{
+	QuantizationError error;
+	error.BytesBefore = (unsigned int)vertices.size_bytes();
+	error.BytesAfter = (unsigned int)(mesh.Vertices.size() * sizeof(QuantizedVertex));
+	if (vertices.empty())
+		return error;
+
+	double positionSum = 0.0;
+	double normalSum = 0.0;
+	size_t normalCount = 0;
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		Vertex decoded = DecodeVertex(mesh.Vertices[i], mesh);
+
+		float positionError = glm::length(decoded.Position - vertices[i].Position);
+		error.MaxPosition = std::max(error.MaxPosition, positionError);
+		positionSum += positionError;
+
+		float length = glm::length(vertices[i].Normal);
+		if (length > 0.0f)
+		{
+			float cosAngle = glm::clamp(glm::dot(vertices[i].Normal / length, decoded.Normal), -1.0f, 1.0f);
+			float degrees = glm::degrees(std::acos(cosAngle));
+			error.MaxNormalDegrees = std::max(error.MaxNormalDegrees, degrees);
+			normalSum += degrees;
+			normalCount++;
+		}
+
+		glm::vec2 uvError = glm::abs(decoded.TexCoords - vertices[i].TexCoords);
+		error.MaxTexCoord = std::max(error.MaxTexCoord, std::max(uvError.x, uvError.y));
+	}
+	error.AvgPosition = (float)(positionSum / vertices.size());
+	error.AvgNormalDegrees = normalCount ? (float)(normalSum / normalCount) : 0.0f;
+	return error;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <span>
+#include <vector>
+#include "StaticVertexLayout.h"
+#include "VertexLayout.h"
+
+// 16 byte version of Vertex (which is 32 bytes):
+//  - Position: unorm16 relative to the mesh bounds, decoded as BoundsMin + p * BoundsExtent
+//  - Normal:   octahedral encoding in two snorm16s
+//  - TexCoords: two half floats
+struct QuantizedVertex
+{
+	glm::u16vec4 Position; // w is padding
+	glm::i16vec2 Normal;
+	Half2        TexCoords;
+};
+
+inline constexpr auto QUANTIZED_VERTEX_LAYOUT = MakeLayout<QuantizedVertex,
+	VERTEX_ATTRIB(QuantizedVertex, Position),
+	VERTEX_ATTRIB(QuantizedVertex, Normal),
+	VERTEX_ATTRIB(QuantizedVertex, TexCoords)>();
+
+struct QuantizedMesh
+{
+	std::vector<QuantizedVertex> Vertices;
+	// Upload these as uniforms so the vertex shader can rebuild positions
+	glm::vec3 BoundsMin = glm::vec3(0.0f);
+	glm::vec3 BoundsExtent = glm::vec3(0.0f);
+};
+
+struct QuantizationError
+{
+	float MaxPosition = 0.0f;      // in mesh units
+	float AvgPosition = 0.0f;
+	float MaxNormalDegrees = 0.0f;
+	float AvgNormalDegrees = 0.0f;
+	float MaxTexCoord = 0.0f;
+	unsigned int BytesBefore = 0;
+	unsigned int BytesAfter = 0;
+};
+
+QuantizedMesh QuantizeVertices(std::span<const Vertex> vertices);
+// Decodes every vertex again and compares it to the source
+QuantizationError MeasureQuantizationError(std::span<const Vertex> vertices, const QuantizedMesh& mesh);
+
+glm::i16vec2 EncodeOctahedral(const glm::vec3& normal);
+glm::vec3 DecodeOctahedral(const glm::i16vec2& encoded);
+// Packs a unit vector into GL_INT_2_10_10_10_REV, for use with PackedNormal
+PackedNormal EncodeNormal1010102(const glm::vec3& normal);
+Vertex DecodeVertex(const QuantizedVertex& vertex, const QuantizedMesh& mesh);
\ No newline at end of file
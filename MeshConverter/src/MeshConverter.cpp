@@ -0,0 +1,103 @@
+// Converts OBJ and glTF (.glb) models into baked meshes (.bmesh): vertices and
+// indices laid out for the GPU, so the app can upload them from a mapping
+// instead of parsing text every run. Meshes are optimized for the vertex
+// cache, overdraw and vertex fetch on the way (see MeshOptimizer.h) and the
+// before/after numbers are printed for each. Indices are stored in the
+// smallest type that holds them, and with --strips as triangle strips where
+// those come out shorter.
+//
+// usage: MeshConverter [--threads n] [--no-optimize] [--strips] [-o output] input...
+
+#include "BakedMeshWriter.h"
+#include "ModelImporter.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct ConvertOptions
+{
+	unsigned int threads = 0;
+	bool optimize = true;
+	bool strips = false;
+	std::string output;
+	std::vector<std::string> inputs;
+};
+
+static void printOptimization(const ModelData& model)
+{
+	for (size_t i = 0; i < model.Meshes.size(); i++)
+	{
+		const MeshData& mesh = model.Meshes[i];
+		const MeshStats& before = mesh.Optimization.Before;
+		const MeshStats& after = mesh.Optimization.After;
+		std::cout << std::fixed << std::setprecision(3) << "  " << (mesh.Name.empty() ? "mesh " + std::to_string(i) : mesh.Name)
+			<< ": " << after.TriangleCount << " triangles, vertices " << before.VertexCount << " -> " << after.VertexCount
+			<< ", ACMR " << before.Cache.ACMR << " -> " << after.Cache.ACMR
+			<< ", ATVR " << before.Cache.ATVR << " -> " << after.Cache.ATVR
+			<< ", overfetch " << before.Overfetch << " -> " << after.Overfetch << std::endl;
+	}
+	std::cout << std::defaultfloat;
+}
+
+static bool convert(const std::string& input, const std::string& output, const ConvertOptions& options)
+{
+	auto start = std::chrono::steady_clock::now();
+	ModelImporter importer(options.threads);
+	importer.SetOptimizeMeshes(options.optimize);
+	importer.SetGenerateStrips(options.strips);
+	ModelData model;
+	if (!importer.Import(input, model))
+		return false;
+	if (options.optimize)
+		printOptimization(model);
+
+	BakedMeshSummary summary;
+	if (!WriteBakedMesh(model, output, &summary))
+		return false;
+
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << input << " -> " << output << ": " << summary.Submeshes << " meshes, " << summary.Vertices << " vertices, "
+		<< summary.Triangles << " triangles, " << summary.IndexBytes / 1024 << " KB of indices, " << summary.FileBytes / 1024
+		<< " KB, " << ms << " ms" << std::endl;
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	ConvertOptions options;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			options.threads = (unsigned int)std::atoi(argv[++i]);
+		else if (strcmp(argv[i], "--no-optimize") == 0)
+			options.optimize = false;
+		else if (strcmp(argv[i], "--strips") == 0)
+			options.strips = true;
+		else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			options.output = argv[++i];
+		else
+			options.inputs.push_back(argv[i]);
+	}
+
+	if (options.inputs.empty() || (!options.output.empty() && options.inputs.size() > 1))
+	{
+		std::cout << "usage: MeshConverter [--threads n] [--no-optimize] [--strips] [-o output] input..." << std::endl;
+		return 1;
+	}
+
+	int failures = 0;
+	for (const std::string& input : options.inputs)
+	{
+		std::string output = options.output;
+		if (output.empty())
+			output = std::filesystem::path(input).replace_extension(".bmesh").string();
+		if (!convert(input, output, options))
+			failures++;
+	}
+	return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
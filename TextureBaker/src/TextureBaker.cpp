@@ -0,0 +1,149 @@
+// Converts images into baked textures (.btex): a full mip chain, block
+// compressed ahead of time so the app can upload it without decoding.
+//
+// usage: TextureBaker [--bc1 | --bc3] [--no-flip] [-o output] input...
+
+#include "BakedTextureFormat.h"
+#include "BlockCompression.h"
+#include "MappedFile.h"
+#include "MipGenerator.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct BakeOptions
+{
+	bool forceBC1 = false;
+	bool forceBC3 = false;
+	bool flip = true; // matches TextureLoader's default
+	std::string output;
+	std::vector<std::string> inputs;
+};
+
+static bool hasAlpha(const std::vector<uint8_t>& pixels)
+{
+	for (size_t i = 3; i < pixels.size(); i += 4)
+	{
+		if (pixels[i] != 255)
+			return true;
+	}
+	return false;
+}
+
+static bool bake(const std::string& input, const std::string& output, const BakeOptions& options)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	MappedFile source(input);
+	if (!source.IsOpen())
+	{
+		std::cout << "Can't open " << input << std::endl;
+		return false;
+	}
+
+	int width, height, channels;
+	stbi_set_flip_vertically_on_load(options.flip);
+	uint8_t* pixels = stbi_load_from_memory(source.GetData(), (int)source.GetSize(), &width, &height, &channels, 4);
+	if (!pixels)
+	{
+		std::cout << "Can't decode " << input << ": " << stbi_failure_reason() << std::endl;
+		return false;
+	}
+
+	std::vector<MipLevel> levels(1);
+	levels[0].width = width;
+	levels[0].height = height;
+	levels[0].pixels.assign(pixels, pixels + (size_t)width * height * 4);
+	stbi_image_free(pixels);
+	std::vector<MipLevel> mips = GenerateMips(levels[0].pixels.data(), width, height, 4);
+	levels.insert(levels.end(), std::make_move_iterator(mips.begin()), std::make_move_iterator(mips.end()));
+
+	bool alpha = options.forceBC3 || (!options.forceBC1 && hasAlpha(levels[0].pixels));
+	BlockFormat format = alpha ? BlockFormat::BC3 : BlockFormat::BC1;
+
+	BakedTextureHeader header = {};
+	memcpy(header.Magic, BAKED_TEXTURE_MAGIC, 4);
+	header.Version = BAKED_TEXTURE_VERSION;
+	header.GLFormat = alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	header.Width = width;
+	header.Height = height;
+	header.LevelCount = (uint32_t)levels.size();
+	header.Flags = (options.flip ? (uint32_t)BAKED_TEXTURE_FLIPPED : 0u) | (alpha ? (uint32_t)BAKED_TEXTURE_ALPHA : 0u);
+
+	std::vector<BakedTextureLevel> table(levels.size());
+	uint64_t offset = sizeof(BakedTextureHeader) + table.size() * sizeof(BakedTextureLevel);
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		offset = (offset + BAKED_TEXTURE_ALIGNMENT - 1) & ~(uint64_t)(BAKED_TEXTURE_ALIGNMENT - 1);
+		table[i].Offset = offset;
+		table[i].Size = CompressedImageSize(format, levels[i].width, levels[i].height);
+		table[i].Width = levels[i].width;
+		table[i].Height = levels[i].height;
+		offset += table[i].Size;
+	}
+
+	std::vector<uint8_t> file(offset, 0);
+	memcpy(file.data(), &header, sizeof(header));
+	memcpy(file.data() + sizeof(header), table.data(), table.size() * sizeof(BakedTextureLevel));
+	for (size_t i = 0; i < levels.size(); i++)
+		CompressImage(format, levels[i].pixels.data(), levels[i].width, levels[i].height, file.data() + table[i].Offset);
+
+	std::ofstream out(output, std::ios::binary);
+	out.write((const char*)file.data(), file.size());
+	if (!out)
+	{
+		std::cout << "Can't write " << output << std::endl;
+		return false;
+	}
+
+	size_t uncompressed = 0;
+	for (const MipLevel& level : levels)
+		uncompressed += level.pixels.size();
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << input << " -> " << output << ": " << width << "x" << height << " " << (alpha ? "BC3" : "BC1")
+		<< ", " << levels.size() << " levels, " << file.size() / 1024 << " KB (RGBA8 " << uncompressed / 1024
+		<< " KB), " << ms << " ms" << std::endl;
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	BakeOptions options;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--bc1") == 0)
+			options.forceBC1 = true;
+		else if (strcmp(argv[i], "--bc3") == 0)
+			options.forceBC3 = true;
+		else if (strcmp(argv[i], "--no-flip") == 0)
+			options.flip = false;
+		else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			options.output = argv[++i];
+		else
+			options.inputs.push_back(argv[i]);
+	}
+
+	if (options.inputs.empty() || (!options.output.empty() && options.inputs.size() > 1))
+	{
+		std::cout << "usage: TextureBaker [--bc1 | --bc3] [--no-flip] [-o output] input..." << std::endl;
+		return 1;
+	}
+
+	int failures = 0;
+	for (const std::string& input : options.inputs)
+	{
+		std::string output = options.output;
+		if (output.empty())
+			output = std::filesystem::path(input).replace_extension(".btex").string();
+		if (!bake(input, output, options))
+			failures++;
+	}
+	return failures == 0 ? 0 : 1;
+}